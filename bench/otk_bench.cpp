@@ -0,0 +1,220 @@
+#include <filesystem>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <nlohmann/json.hpp>
+
+#include "otk/converter.hpp"
+#include "otk/expression.hpp"
+#include "otk/synthetic.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Converter with the conversion kernels exposed
+//
+// ---------------------------------------------------------------------------------------
+class BenchConverter : public otk::Converter {
+   public:
+    explicit BenchConverter(
+        const nlohmann::json &output_request = nlohmann::json::object())
+        : otk::Converter(output_request) {}
+
+    using otk::Converter::clear_field_data;
+    using otk::Converter::convert_mesh;
+    using otk::Converter::extract_scalar_field;
+    using otk::Converter::extract_vector_field;
+    using otk::Converter::get_cells;
+    using otk::Converter::get_points;
+    using otk::Converter::write;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Synthetic model with n x n x n elements per instance
+//
+// ---------------------------------------------------------------------------------------
+otk::SyntheticConfig make_config(int64_t n) {
+    otk::SyntheticConfig config;
+    config.nx = static_cast<int>(n);
+    config.ny = static_cast<int>(n);
+    config.nz = static_cast<int>(n);
+    config.frames = 1;
+    return config;
+}
+
+const std::string INSTANCE = "PART-1-1";
+const std::string STEP = "Step-1";
+
+// ---------------------------------------------------------------------------------------
+//
+//   Mesh kernels
+//
+// ---------------------------------------------------------------------------------------
+void BM_GetPoints(benchmark::State &state) {
+    otk::SyntheticSource source{make_config(state.range(0))};
+    otk::NodeData nodes = source.nodes(INSTANCE);
+    BenchConverter converter;
+
+    for (auto _ : state) {
+        otk::LabelIndex node_map;
+        auto points = converter.get_points(node_map, nodes, otk::Dimension::THREE_D);
+        benchmark::DoNotOptimize(points);
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.labels.size());
+}
+
+void BM_GetCells(benchmark::State &state) {
+    otk::SyntheticSource source{make_config(state.range(0))};
+    otk::NodeData nodes = source.nodes(INSTANCE);
+    otk::ElementData elements = source.elements(INSTANCE);
+    BenchConverter converter;
+
+    otk::LabelIndex node_map;
+    converter.get_points(node_map, nodes, otk::Dimension::THREE_D);
+
+    for (auto _ : state) {
+        otk::ElementScan scan = otk::scan_elements(elements, &node_map);
+        auto cells = converter.get_cells(scan, INSTANCE);
+        benchmark::DoNotOptimize(cells);
+    }
+    state.SetItemsProcessed(state.iterations() * elements.labels.size());
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Extraction kernels
+//
+// ---------------------------------------------------------------------------------------
+template <bool Vector>
+void extract_field(benchmark::State &state, const std::string &field) {
+    otk::SyntheticSource source{make_config(state.range(0))};
+    BenchConverter converter;
+    converter.convert_mesh(source);
+
+    otk::FieldData data = source.field_data(STEP, 0, field, INSTANCE, {}, false, {});
+    size_t num_rows = 0;
+    for (const auto &block : data.blocks) {
+        num_rows += block.length;
+    }
+
+    for (auto _ : state) {
+        converter.clear_field_data();
+        if constexpr (Vector) {
+            converter.extract_vector_field(data, INSTANCE);
+        } else {
+            converter.extract_scalar_field(data, INSTANCE);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * num_rows);
+}
+
+void BM_ExtractNodalScalar(benchmark::State &state) { extract_field<false>(state, "NT1"); }
+
+void BM_ExtractElementScalar(benchmark::State &state) {
+    extract_field<false>(state, "EVOL1");
+}
+
+void BM_ExtractIntegrationScalar(benchmark::State &state) {
+    extract_field<false>(state, "PEEQ1");
+}
+
+void BM_ExtractNodalVector(benchmark::State &state) { extract_field<true>(state, "U"); }
+
+// Derived field over two nodal arrays of n^3 values
+void BM_EvaluateExpression(benchmark::State &state) {
+    const size_t num_values = static_cast<size_t>(state.range(0) * state.range(0) *
+                                                  state.range(0));
+    std::vector<double> u1(num_values, 3.0);
+    std::vector<double> u2(num_values, 4.0);
+    std::vector<double> output(num_values);
+    otk::Expression expression{"sqrt(U1^2 + U2^2)"};
+
+    for (auto _ : state) {
+        expression.evaluate({u1.data(), u2.data()}, output.data(), num_values);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_values);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Writer
+//
+// ---------------------------------------------------------------------------------------
+void write_frame(benchmark::State &state, const nlohmann::json &output_request) {
+    otk::SyntheticSource source{make_config(state.range(0))};
+    BenchConverter converter{output_request};
+    converter.convert_mesh(source);
+    converter.extract_vector_field(
+        source.field_data(STEP, 0, "U", INSTANCE, {}, false, {}), INSTANCE);
+    converter.extract_scalar_field(
+        source.field_data(STEP, 0, "PEEQ1", INSTANCE, {}, false, {}), INSTANCE);
+
+    fs::path directory = fs::temp_directory_path() / "otk_bench";
+    fs::create_directories(directory / "synthetic");
+    fs::path file = directory / "synthetic.odb";
+
+    for (auto _ : state) {
+        converter.write(file, 0);
+    }
+    state.SetItemsProcessed(state.iterations() * source.num_elements(INSTANCE));
+
+    fs::remove_all(directory);
+}
+
+// Both writers with the same compressor: zlib (the default) and none
+void BM_Write(benchmark::State &state) { write_frame(state, nlohmann::json::object()); }
+
+void BM_WriteNative(benchmark::State &state) {
+    write_frame(state, {{"vtk", {{"writer", "native"}}}});
+}
+
+void BM_WriteRaw(benchmark::State &state) {
+    write_frame(state, {{"vtk", {{"compression", "none"}}}});
+}
+
+void BM_WriteNativeRaw(benchmark::State &state) {
+    write_frame(state, {{"vtk", {{"writer", "native"}, {"compression", "none"}}}});
+}
+
+}  // namespace
+
+BENCHMARK(BM_GetPoints)->RangeMultiplier(2)->Range(16, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GetCells)->RangeMultiplier(2)->Range(16, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ExtractNodalScalar)
+    ->RangeMultiplier(2)
+    ->Range(16, 64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ExtractElementScalar)
+    ->RangeMultiplier(2)
+    ->Range(16, 64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ExtractIntegrationScalar)
+    ->RangeMultiplier(2)
+    ->Range(16, 64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ExtractNodalVector)
+    ->RangeMultiplier(2)
+    ->Range(16, 64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EvaluateExpression)
+    ->RangeMultiplier(2)
+    ->Range(16, 64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Write)->RangeMultiplier(2)->Range(16, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WriteNative)
+    ->RangeMultiplier(2)
+    ->Range(16, 64)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WriteRaw)->RangeMultiplier(2)->Range(16, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WriteNativeRaw)
+    ->RangeMultiplier(2)
+    ->Range(16, 64)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#ifndef OTK_BATCH_HPP
+#define OTK_BATCH_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Expand ODB file names, directories and glob patterns (* and ? in the file name),
+//   plus the lines of an optional list file; missing files are reported and skipped
+//
+// ---------------------------------------------------------------------------------------
+std::vector<fs::path> expand_odb_files(const std::vector<std::string> &patterns,
+                                       const std::string &list_file = {});
+
+// ---------------------------------------------------------------------------------------
+//
+//   Path of the running executable (argv[0] may be a command found through PATH)
+//
+// ---------------------------------------------------------------------------------------
+fs::path executable_path(const std::string &argv0);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Convert one ODB file with the JSON output request next to it, to VTK or to time
+//   histories for "history" requests (requires an active otk::OdbSession)
+//
+// ---------------------------------------------------------------------------------------
+void convert_file(const fs::path &file);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Convert ODB files one after another in this process; returns the number of
+//   failed conversions. With a trace file, the events of each ODB file are written to
+//   <trace>_<odb><ext> and dropped before the next file.
+//
+// ---------------------------------------------------------------------------------------
+int convert_files(const std::vector<fs::path> &files, const fs::path &trace_file = {});
+
+// ---------------------------------------------------------------------------------------
+//
+//   Spread ODB files over worker processes of the given executable ("otk batch"), each
+//   converting its share with a single ODB API session (and writing the traces of its
+//   files with a trace file); returns the number of failed workers
+//
+// ---------------------------------------------------------------------------------------
+int run_batch(const fs::path &executable, const std::vector<fs::path> &files, int jobs,
+              const fs::path &trace_file = {});
+
+}  // namespace otk
+
+#endif  // !OTK_BATCH_HPP
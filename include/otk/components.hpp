@@ -0,0 +1,94 @@
+#ifndef OTK_COMPONENTS_HPP
+#define OTK_COMPONENTS_HPP
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "otk/source.hpp"
+
+namespace otk {
+
+// =======================================================================================
+//
+//   Field components
+//
+//   A field request can select components and invariants instead of the whole field:
+//
+//       {"key": "S", "components": ["S11", "MISES"]}
+//       {"key": "U", "components": ["U3"]}
+//
+//   Components are named like the Abaqus component labels (field name followed by 1-3
+//   for vectors, 11, 22, 33, 12, 13 or 23 for tensors). MAGNITUDE is available for
+//   vectors, MISES and PRESS for tensors. Each selector becomes a scalar array, and the
+//   extraction only reads the columns it needs from the bulk data rows.
+//
+// =======================================================================================
+enum class Invariant { NONE, MAGNITUDE, MISES, PRESS };
+
+struct ComponentSelector {
+    std::string name;                       // Output array name (S11, S_MISES)
+    int column = -1;                        // Column of the rows (Invariant::NONE)
+    Invariant invariant = Invariant::NONE;  // Invariant computed from the whole row
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Resolve the selectors of a field of the given type; throws on a selector that does
+//   not name a component or an invariant of that type
+//
+// ---------------------------------------------------------------------------------------
+std::vector<ComponentSelector> resolve_components(const std::string &field,
+                                                  DataType type,
+                                                  const std::vector<std::string> &names);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Value of a selector for one row of `width` values (missing columns are zero)
+//
+//   Tensor rows hold 11, 22, 33, 12, 13, 23 (TENSOR_3D_FULL), 11, 22, 33, 12
+//   (TENSOR_3D_PLANAR) or 11, 22, 12 (TENSOR_2D_PLANAR).
+//
+// ---------------------------------------------------------------------------------------
+template <typename T>
+inline double evaluate_component(const ComponentSelector &selector, DataType type,
+                                 const T *row, int width) {
+    auto at = [row, width](int column) {
+        return column < width ? static_cast<double>(row[column]) : 0.0;
+    };
+
+    switch (selector.invariant) {
+        case Invariant::NONE:
+            return at(selector.column);
+        case Invariant::MAGNITUDE: {
+            double sum = 0.0;
+            for (int j = 0; j < width; ++j) {
+                sum += static_cast<double>(row[j]) * row[j];
+            }
+            return std::sqrt(sum);
+        }
+        default:
+            break;
+    }
+
+    const bool planar = type == DataType::TENSOR_2D_PLANAR;
+    const double s11 = at(0);
+    const double s22 = at(1);
+    const double s33 = planar ? 0.0 : at(2);
+    const double s12 = planar ? at(2) : at(3);
+    const double s13 = type == DataType::TENSOR_3D_FULL ? at(4) : 0.0;
+    const double s23 = type == DataType::TENSOR_3D_FULL ? at(5) : 0.0;
+
+    if (selector.invariant == Invariant::PRESS) {
+        return -(s11 + s22 + s33) / 3.0;
+    }
+    const double d1 = s11 - s22;
+    const double d2 = s22 - s33;
+    const double d3 = s33 - s11;
+    return std::sqrt(0.5 * (d1 * d1 + d2 * d2 + d3 * d3) +
+                     3.0 * (s12 * s12 + s13 * s13 + s23 * s23));
+}
+
+}  // namespace otk
+
+#endif  // !OTK_COMPONENTS_HPP
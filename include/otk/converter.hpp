@@ -2,7 +2,9 @@
 #define OTK_CONVERTER_HPP
 
 #include <filesystem>
+#include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -14,12 +16,23 @@
 #include <vtkCellType.h>
 #include <vtkDataArray.h>
 #include <vtkDoubleArray.h>
+#include <vtkIdList.h>
 #include <vtkPointData.h>
 #include <vtkPoints.h>
 #include <vtkSmartPointer.h>
 #include <vtkUnstructuredGrid.h>
 
-#include "otk/odb.hpp"
+#include "otk/components.hpp"
+#include "otk/element_scan.hpp"
+#include "otk/ensight.hpp"
+#include "otk/expression.hpp"
+#include "otk/label_index.hpp"
+#include "otk/memory.hpp"
+#include "otk/npy.hpp"
+#include "otk/orientation.hpp"
+#include "otk/source.hpp"
+#include "otk/store.hpp"
+#include "otk/vtk_xml.hpp"
 
 namespace fs = std::filesystem;
 
@@ -29,12 +42,42 @@ class Converter {
     using PointArray = vtkSmartPointer<vtkPoints>;
     using CellArray = vtkSmartPointer<vtkCellArray>;
     using CellArrayPair = std::pair<std::vector<int>, CellArray>;
-    using CellData = vtkSmartPointer<vtkDoubleArray>;
-    using PointData = vtkSmartPointer<vtkDoubleArray>;
+    using CellData = vtkSmartPointer<vtkDataArray>;
+    using PointData = vtkSmartPointer<vtkDataArray>;
     using CellDataArray = std::vector<CellData>;
     using PointDataArray = std::vector<PointData>;
-    using ElementMap = std::unordered_map<std::string, odb_SequenceElement>;
-    using ElementLabelMap = std::unordered_map<int, int>;
+    using FieldDataArray = std::vector<vtkSmartPointer<vtkDoubleArray>>;
+
+    // Spatial partition of an instance: the instance cells and points it holds, and
+    // its renumbered mesh
+    struct Partition {
+        vtkSmartPointer<vtkIdList> cell_ids;
+        vtkSmartPointer<vtkIdList> point_ids;
+        PointArray points;
+        CellArrayPair cells;
+    };
+
+    // Mesh and field arrays of an instance (or of one of its partitions) for a frame
+    struct FramePiece {
+        PointArray points;
+        const CellArrayPair *cells;
+        PointDataArray point_data;
+        CellDataArray cell_data;
+    };
+
+    // Field computed from an expression; inputs holds the field and selector of each
+    // variable for the current frame (empty if a variable was not found)
+    struct DerivedField {
+        std::string name;
+        Expression expression;
+        std::vector<std::pair<std::string, ComponentSelector>> inputs;
+    };
+
+    // Deformed coordinates X + scale * u written per frame from a displacement field
+    struct Deformation {
+        std::string field;
+        double scale;
+    };
 
    public:
     // -----------------------------------------------------------------------------------
@@ -49,7 +92,15 @@ class Converter {
     //   Convert ODB file to VTK format
     //
     // -----------------------------------------------------------------------------------
-    void convert(otk::Odb &odb, fs::path file);
+    void convert(otk::Source &source, fs::path file);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Estimate the output size, peak memory and frame x field work list of the
+    //   conversion from the metadata only (no bulk data is read)
+    //
+    // -----------------------------------------------------------------------------------
+    nlohmann::json plan(otk::Source &source);
 
    protected:
     // -----------------------------------------------------------------------------------
@@ -57,14 +108,14 @@ class Converter {
     //   Convert mesh data to VTK format
     //
     // -----------------------------------------------------------------------------------
-    void convert_mesh(otk::Odb &odb);
+    void convert_mesh(otk::Source &source);
 
     // -----------------------------------------------------------------------------------
     //
     //   Convert field data to VTK format
     //
     // -----------------------------------------------------------------------------------
-    void convert_fields(otk::Odb &odb, fs::path file, nlohmann::json field_summary,
+    void convert_fields(otk::Source &source, fs::path file, nlohmann::json field_summary,
                         nlohmann::json instance_summary, nlohmann::json output_summary,
                         nlohmann::json matches);
 
@@ -77,40 +128,118 @@ class Converter {
 
     // -----------------------------------------------------------------------------------
     //
-    //   Get the base element type without derivatives
+    //   Write mesh data to VTU files with the native appended-binary writer
+    //
+    // -----------------------------------------------------------------------------------
+    void write_native(fs::path file, int frame_id);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the mesh and the field arrays of a frame to the OTK frame store
+    //
+    // -----------------------------------------------------------------------------------
+    void write_store_mesh();
+    void write_store_frame(const std::string &step_name, int frame_id);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the mesh and the field arrays of a frame as NumPy .npy files or .npz
+    //   archives
+    //
+    // -----------------------------------------------------------------------------------
+    void write_numpy_mesh(fs::path file, bool npz);
+    void write_numpy_frame(fs::path file, int frame_id, bool npz);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the mesh and the field arrays of a frame to the EnSight Gold case
+    //
+    // -----------------------------------------------------------------------------------
+    void write_ensight_geometry();
+    void write_ensight_frame(double time);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Element label of each output cell (surface faces get the label of their cell)
+    //
+    // -----------------------------------------------------------------------------------
+    std::vector<int> get_cell_labels(const std::string &instance_name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Quantization parameters (offset, scale) of a field array of the frame (nullptr
+    //   if the field is not quantized)
     //
     // -----------------------------------------------------------------------------------
-    std::string get_base_element_type(const std::string &element_type);
+    vtkDoubleArray *get_quantization(const std::string &instance_name,
+                                     const std::string &field_name);
 
     // -----------------------------------------------------------------------------------
     //
-    //   Get the cell types from an element sequence
+    //   Restrict the mesh of an instance to the region of interest of the output
+    //   request (element sets, node sets and/or bounding box); returns false if no
+    //   element of the instance is in the region
     //
     // -----------------------------------------------------------------------------------
-    std::set<VTKCellType> get_cell_types(const odb_SequenceElement &element_sequence);
+    bool select_region(otk::Source &source, const std::string &instance_name,
+                       ElementData &elements, NodeData &nodes);
 
     // -----------------------------------------------------------------------------------
     //
-    //   Get vtkCellArrays from an element sequence
+    //   Get vtkCellArrays from the cells of an element scan (the scan arrays are moved)
     //
     // -----------------------------------------------------------------------------------
-    CellArrayPair get_cells(const std::unordered_map<int, vtkIdType> &node_map,
-                            const odb_SequenceElement &element_sequence,
-                            const std::string &instance_name,
-                            const odb_Instance &instance);
+    CellArrayPair get_cells(ElementScan &scan, const std::string &instance_name);
 
     // -----------------------------------------------------------------------------------
     //
-    //   Get vtkPoints from a node sequence
+    //   Replace the cells and points of an instance by its exterior surface
     //
     // -----------------------------------------------------------------------------------
-    PointArray get_points(std::unordered_map<int, vtkIdType> &node_map,
-                          const odb_SequenceNode &node_sequence,
-                          odb_Enum::odb_DimensionEnum instance_type);
+    void extract_surface(const std::string &instance_name, const NodeData &nodes);
 
     // -----------------------------------------------------------------------------------
     //
-    //   Process summary JSON from Odb class
+    //   Split the cells of an instance into spatially coherent partitions (recursive
+    //   coordinate bisection of the cell centroids)
+    //
+    // -----------------------------------------------------------------------------------
+    void partition_instance(const std::string &instance_name, int num_partitions);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Renumber the points and cells of an instance along a space-filling curve
+    //   ("morton" or "hilbert")
+    //
+    // -----------------------------------------------------------------------------------
+    void reorder_instance(const std::string &instance_name, const std::string &curve);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Share one cell array between the instances with an identical topology
+    //
+    // -----------------------------------------------------------------------------------
+    void share_topology();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Pieces of an instance written for the frame (the instance, or its partitions
+    //   with the field arrays gathered to them)
+    //
+    // -----------------------------------------------------------------------------------
+    std::vector<FramePiece> get_frame_pieces(const std::string &instance_name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Get vtkPoints from the node data
+    //
+    // -----------------------------------------------------------------------------------
+    PointArray get_points(LabelIndex &node_map, const NodeData &nodes,
+                          Dimension instance_type);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Process summary JSON from Source class
     //
     // -----------------------------------------------------------------------------------
     nlohmann::json process_field_summary(const nlohmann::json &summary);
@@ -125,18 +254,18 @@ class Converter {
 
     // -----------------------------------------------------------------------------------
     //
-    //   Load field data from Odb class
+    //   Load field data from Source class
     //
     // -----------------------------------------------------------------------------------
-    nlohmann::json load_field_data(otk::Odb &odb, const nlohmann::json &request,
+    nlohmann::json load_field_data(otk::Source &source, const nlohmann::json &request,
                                    const std::string &step_name, int frame_id);
 
     // -----------------------------------------------------------------------------------
     //
-    //   Extract field data from Odb class
+    //   Extract field data from Source class
     //
     // -----------------------------------------------------------------------------------
-    void extract_field_data(otk::Odb &odb, const nlohmann::json &data,
+    void extract_field_data(otk::Source &source, const nlohmann::json &data,
                             const nlohmann::json &instance_summary,
                             const std::string &step_name, int frame_id);
 
@@ -145,8 +274,8 @@ class Converter {
     //   Extract field data from Instance
     //
     // -----------------------------------------------------------------------------------
-    void extract_instance_field_data(otk::Odb &odb, const nlohmann::json &data,
-                                     odb_Instance &instance, bool composite,
+    void extract_instance_field_data(otk::Source &source, const nlohmann::json &data,
+                                     const std::string &instance_name, bool composite,
                                      const std::string &step_name, int frame_id);
 
     // -----------------------------------------------------------------------------------
@@ -154,90 +283,168 @@ class Converter {
     //   Extract scalar field data
     //
     // -----------------------------------------------------------------------------------
-    void extract_scalar_field(const odb_FieldOutput &field_output,
-                              const std::vector<odb_Set> &element_sets,
-                              const odb_Instance &instance, bool composite);
+    void extract_scalar_field(const FieldData &field, const std::string &instance_name);
 
     // -----------------------------------------------------------------------------------
     //
     //   Extract vector field data
     //
     // -----------------------------------------------------------------------------------
-    void extract_vector_field(const odb_FieldOutput &field_output,
-                              const std::vector<odb_Set> &element_sets,
-                              const odb_Instance &instance, bool composite);
+    void extract_vector_field(const FieldData &field, const std::string &instance_name);
 
     // -----------------------------------------------------------------------------------
     //
     //   Extract tensor field data
     //
     // -----------------------------------------------------------------------------------
-    void extract_tensor_field(const odb_FieldOutput &field_output,
-                              const std::vector<odb_Set> &element_sets,
-                              const odb_Instance &instance, bool composite);
+    void extract_tensor_field(const FieldData &field, const std::string &instance_name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Scatter the bulk data blocks of a field into a point or cell array
+    //
+    // -----------------------------------------------------------------------------------
+    void scatter_field(const FieldData &field, const std::string &instance_name,
+                       int num_components, bool add_array = true);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Data type of the converted rows of a field
+    //
+    // -----------------------------------------------------------------------------------
+    DataType output_type(DataType type) const;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Scatter the selected components and invariants of a field into scalar arrays
+    //   (use_cell_data is set if they are cell arrays)
+    //
+    // -----------------------------------------------------------------------------------
+    FieldDataArray scatter_selectors(const FieldData &field,
+                                     const std::string &instance_name,
+                                     const std::vector<ComponentSelector> &selectors,
+                                     bool &use_cell_data);
+    void scatter_components(const FieldData &field, const std::string &instance_name,
+                            const std::vector<ComponentSelector> &selectors);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Average the tuples of a point array over the rows accumulated per node
+    //
+    // -----------------------------------------------------------------------------------
+    static void average_tuples(vtkDoubleArray *array, const std::vector<int> &counts);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Deformed coordinates: average the displacement tuples and write the deformed
+    //   points of an instance in the same pass, or fetch the displacement field when it
+    //   was not extracted as a whole vector field
+    //
+    // -----------------------------------------------------------------------------------
+    void deform_points(vtkDoubleArray *displacement, const std::vector<int> &counts,
+                       const std::string &instance_name);
+    void extract_deformed_points(otk::Source &source, const std::string &instance_name,
+                                 const std::map<std::string, FieldData> &fetched,
+                                 bool composite, const std::string &step_name,
+                                 int frame_id);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Add a field array to the point or cell data of an instance
+    //
+    // -----------------------------------------------------------------------------------
+    void add_field_array(vtkSmartPointer<vtkDoubleArray> array,
+                         const std::string &instance_name, const std::string &field_name,
+                         bool use_cell_data);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Derived fields: parse the expressions of the request, resolve their variables
+    //   to the field outputs of a frame and evaluate them for an instance
+    //
+    // -----------------------------------------------------------------------------------
+    void parse_derived_fields();
+    void resolve_derived_inputs(otk::Source &source, const std::string &step_name,
+                                int frame_id);
+    void extract_derived_fields(otk::Source &source, const std::string &instance_name,
+                                std::map<std::string, FieldData> &fetched,
+                                bool composite, const std::string &step_name,
+                                int frame_id);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Components and invariants requested for a field (empty for the whole field)
+    //
+    // -----------------------------------------------------------------------------------
+    const std::vector<std::string> &get_requested_components(
+        const std::string &field_name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Quantization bits requested for a field (0 if the field is kept in double
+    //   precision)
+    //
+    // -----------------------------------------------------------------------------------
+    int get_quantization_bits(const std::string &field_name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Quantize an array of a field to 8- or 16-bit integers with a scale and offset
+    //   (the field request decides the bits)
+    //
+    // -----------------------------------------------------------------------------------
+    vtkSmartPointer<vtkDataArray> quantize_field(
+        const vtkSmartPointer<vtkDoubleArray> &array, const std::string &instance_name,
+        const std::string &field_name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Release the field arrays of the previous frame
+    //
+    // -----------------------------------------------------------------------------------
+    void clear_field_data();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Memory instrumentation (RSS at phase boundaries and VTK array bytes)
+    //
+    // -----------------------------------------------------------------------------------
+    void sample_memory_phase(const std::string &phase);
+    void account_memory();
+    void report_memory();
 
    private:
     nlohmann::json output_request_;
-    std::vector<odb_FieldOutput> field_outputs_;
+    nlohmann::json instance_summary_;
+    bool write_vtk_ = true;
+    bool write_npy_ = false;
+    bool write_npz_ = false;
+    std::unique_ptr<StoreWriter> store_;
+    std::unique_ptr<EnsightWriter> ensight_;
     std::unordered_map<std::string, PointArray> points_;
     std::unordered_map<std::string, CellArrayPair> cells_;
     std::unordered_map<std::string, CellDataArray> cell_data_;
     std::unordered_map<std::string, PointDataArray> point_data_;
-    std::unordered_map<std::string, ElementMap> section_elements_;
-    std::unordered_map<std::string, ElementLabelMap> element_map_;
-};
-
-// ---------------------------------------------------------------------------------------
-//
-//   Constant map to convert from Abaqus element type to VTK cell type
-//
-// ---------------------------------------------------------------------------------------
-const std::unordered_map<std::string, VTKCellType> ABQ_VTK_CELL_MAP{
-    // 2D Continuum - Plane strain
-    {"CPE3", VTK_TRIANGLE},
-    {"CPE4", VTK_QUAD},
-    {"CPE6", VTK_QUADRATIC_TRIANGLE},
-    {"CPE8", VTK_QUADRATIC_QUAD},
-
-    // 2D Continuum - Plane stress
-    {"CPS3", VTK_TRIANGLE},
-    {"CPS4", VTK_QUAD},
-    {"CPS6", VTK_QUADRATIC_TRIANGLE},
-    {"CPS8", VTK_QUADRATIC_QUAD},
-
-    // 2D Continuum - Generalized plane strain
-    {"CPEG4", VTK_QUAD},
-    {"CPEG3", VTK_TRIANGLE},
-    {"CPEG8", VTK_QUADRATIC_QUAD},
-    {"CPEG6", VTK_QUADRATIC_TRIANGLE},
-
-    // 2D Continuum - Axisymmetric
-    {"CAX3", VTK_TRIANGLE},
-    {"CAX4", VTK_QUAD},
-    {"CAX6", VTK_QUADRATIC_TRIANGLE},
-    {"CAX8", VTK_QUADRATIC_QUAD},
-
-    // 3D Continuum
-    {"C3D4", VTK_TETRA},
-    {"C3D5", VTK_PYRAMID},
-    {"C3D6", VTK_WEDGE},
-    {"C3D8", VTK_HEXAHEDRON},
-    {"C3D10", VTK_QUADRATIC_TETRA},
-    {"C3D15", VTK_QUADRATIC_WEDGE},
-    {"C3D20", VTK_QUADRATIC_HEXAHEDRON},
-
-    // Shell
-    {"STRI3", VTK_TRIANGLE},
-    {"S3", VTK_TRIANGLE},
-    {"S4", VTK_QUAD},
-    {"S8", VTK_QUADRATIC_QUAD},
-
-    // Continuum shell
-    {"SC6", VTK_WEDGE},
-    {"SC8", VTK_HEXAHEDRON},
-
-    // Continuum solid shell
-    {"CSS8", VTK_HEXAHEDRON},
+    std::unordered_map<std::string, FieldDataArray> quantization_data_;
+    std::unordered_map<std::string, int> quantization_bits_;
+    std::unordered_map<std::string, std::vector<std::string>> requested_components_;
+    std::vector<DerivedField> derived_fields_;
+    std::set<std::string> derived_input_fields_;
+    std::optional<Matrix3> orientation_axes_;
+    std::optional<Deformation> deformation_;
+    std::unordered_map<std::string, PointArray> deformed_points_;
+    std::unordered_map<std::string, ElementGroups> section_elements_;
+    std::unordered_map<std::string, std::vector<int>> region_nodes_;
+    std::unordered_map<std::string, std::vector<vtkIdType>> surface_faces_;
+    std::unordered_map<std::string, std::vector<Partition>> partitions_;
+    std::unordered_map<std::string, std::pair<PointData, CellData>> label_arrays_;
+    std::unordered_map<std::string, std::string> shared_topology_;
+    std::unordered_map<std::string, LabelIndex> node_map_;
+    std::unordered_map<std::string, LabelIndex> element_map_;
+    std::unordered_map<std::string, std::vector<int>> node_labels_;
+    std::unordered_map<std::string, std::vector<int>> element_labels_;
+    std::vector<MemorySample> memory_samples_;
+    nlohmann::json memory_report_;
 };
 
 template <typename Key, typename Value>
@@ -0,0 +1,128 @@
+#ifndef OTK_ELEMENT_SCAN_HPP
+#define OTK_ELEMENT_SCAN_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <vtkCellType.h>
+#include <vtkIdTypeArray.h>
+#include <vtkSmartPointer.h>
+
+#include "otk/label_index.hpp"
+#include "otk/source.hpp"
+
+namespace otk {
+
+// =======================================================================================
+//
+//   Element scan
+//
+//   Everything OTK derives from the elements of an instance, gathered in a single pass
+//   over the element data: the instance summary (element type and section category
+//   counts, supported and composite flags) and, when a node index is given, the VTK
+//   cells of the supported elements with their labels and section groups. Type and
+//   section names are resolved once per distinct name, not once per element.
+//
+// =======================================================================================
+struct ElementScan {
+    // Summary
+    std::map<std::string, int> element_types;       // Abaqus element type -> count
+    std::map<std::string, int> section_categories;  // Display category -> count
+    std::vector<std::string> category_names;        // Category of each section name
+    std::set<VTKCellType> cell_types;               // VTK types of the used elements
+    std::vector<std::string> unsupported_types;     // Used types without a VTK cell
+    bool supported = true;   // Not a mix of composite and other sections
+    bool composite = false;  // At least one composite section
+
+    // Cells of the supported elements (only filled with a node index)
+    std::vector<int> types;                        // VTK cell type per cell
+    vtkSmartPointer<vtkIdTypeArray> offsets;       // Number of cells + 1 entries
+    vtkSmartPointer<vtkIdTypeArray> connectivity;  // Point ids
+    std::vector<int> labels;                       // Element label per cell
+    ElementGroups section_groups;                  // Labels per section and type
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Scan the elements of an instance; node_map maps node labels to point ids
+//
+// ---------------------------------------------------------------------------------------
+ElementScan scan_elements(const ElementData &elements,
+                          const LabelIndex *node_map = nullptr);
+
+// ---------------------------------------------------------------------------------------
+//
+//   JSON summary of a scan (element_types, section_categories, supported, composite)
+//
+// ---------------------------------------------------------------------------------------
+nlohmann::json scan_summary(const ElementScan &scan);
+
+// ---------------------------------------------------------------------------------------
+//
+//   VTK cell type of an Abaqus element type, matched on the base type without
+//   derivatives (-1 if the type is not supported)
+//
+// ---------------------------------------------------------------------------------------
+int vtk_cell_type(const std::string &element_type);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Constant map to convert from Abaqus element type to VTK cell type
+//
+// ---------------------------------------------------------------------------------------
+const std::unordered_map<std::string, VTKCellType> ABQ_VTK_CELL_MAP{
+    // 2D Continuum - Plane strain
+    {"CPE3", VTK_TRIANGLE},
+    {"CPE4", VTK_QUAD},
+    {"CPE6", VTK_QUADRATIC_TRIANGLE},
+    {"CPE8", VTK_QUADRATIC_QUAD},
+
+    // 2D Continuum - Plane stress
+    {"CPS3", VTK_TRIANGLE},
+    {"CPS4", VTK_QUAD},
+    {"CPS6", VTK_QUADRATIC_TRIANGLE},
+    {"CPS8", VTK_QUADRATIC_QUAD},
+
+    // 2D Continuum - Generalized plane strain
+    {"CPEG4", VTK_QUAD},
+    {"CPEG3", VTK_TRIANGLE},
+    {"CPEG8", VTK_QUADRATIC_QUAD},
+    {"CPEG6", VTK_QUADRATIC_TRIANGLE},
+
+    // 2D Continuum - Axisymmetric
+    {"CAX3", VTK_TRIANGLE},
+    {"CAX4", VTK_QUAD},
+    {"CAX6", VTK_QUADRATIC_TRIANGLE},
+    {"CAX8", VTK_QUADRATIC_QUAD},
+
+    // 3D Continuum
+    {"C3D4", VTK_TETRA},
+    {"C3D5", VTK_PYRAMID},
+    {"C3D6", VTK_WEDGE},
+    {"C3D8", VTK_HEXAHEDRON},
+    {"C3D10", VTK_QUADRATIC_TETRA},
+    {"C3D15", VTK_QUADRATIC_WEDGE},
+    {"C3D20", VTK_QUADRATIC_HEXAHEDRON},
+
+    // Shell
+    {"STRI3", VTK_TRIANGLE},
+    {"S3", VTK_TRIANGLE},
+    {"S4", VTK_QUAD},
+    {"S8", VTK_QUADRATIC_QUAD},
+
+    // Continuum shell
+    {"SC6", VTK_WEDGE},
+    {"SC8", VTK_HEXAHEDRON},
+
+    // Continuum solid shell
+    {"CSS8", VTK_HEXAHEDRON},
+};
+
+}  // namespace otk
+
+#endif  // !OTK_ELEMENT_SCAN_HPP
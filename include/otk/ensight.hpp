@@ -0,0 +1,124 @@
+#ifndef OTK_ENSIGHT_HPP
+#define OTK_ENSIGHT_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <vtkDataArray.h>
+#include <vtkType.h>
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// =======================================================================================
+//
+//   EnsightWriter class
+//
+//   Writes an EnSight Gold binary case: the geometry once (<name>.geo, one part per
+//   instance with the Abaqus node and element labels as ids), one file per variable
+//   and frame (<name>_<variable>.NNNNN) and the <name>.case file, where the frame
+//   values are the times. Each variable has its own time set, so fields missing from
+//   some frames are allowed.
+//
+// =======================================================================================
+class EnsightWriter {
+   public:
+    // Mesh of one instance; the buffers are only read by write_geometry
+    struct Part {
+        std::string name;
+        const float *points;  // [num_points x 3]
+        size_t num_points;
+        const vtkIdType *offsets;  // [num_cells + 1]
+        const vtkIdType *connectivity;
+        const int *types;  // VTK cell types
+        size_t num_cells;
+        const int *node_labels;
+        const int *element_labels;
+    };
+
+    // Values of a variable on one part; integer (quantized) arrays are restored with
+    // offset + scale * q
+    struct Variable {
+        size_t part;
+        vtkDataArray *array;
+        bool per_node;
+        double offset = 0.0;
+        double scale = 1.0;
+    };
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Constructor
+    //
+    // -----------------------------------------------------------------------------------
+    EnsightWriter(const fs::path &directory, const std::string &name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Destructor (writes the case file if close() was not called)
+    //
+    // -----------------------------------------------------------------------------------
+    ~EnsightWriter();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Class is non-copyable
+    //
+    // -----------------------------------------------------------------------------------
+    EnsightWriter(const EnsightWriter &) = delete;
+    EnsightWriter &operator=(const EnsightWriter &) = delete;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the geometry file
+    //
+    // -----------------------------------------------------------------------------------
+    void write_geometry(const std::vector<Part> &parts);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the variable files of a frame (variable name -> values per part)
+    //
+    // -----------------------------------------------------------------------------------
+    void write_frame(double time,
+                     const std::map<std::string, std::vector<Variable>> &variables);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the case file
+    //
+    // -----------------------------------------------------------------------------------
+    void close();
+
+   private:
+    // Cells of a part grouped by EnSight element type
+    struct Block {
+        int vtk_type;
+        std::vector<vtkIdType> cells;
+    };
+
+    // Variable of the case file with its time set
+    struct Series {
+        std::string type;
+        std::string description;
+        std::string file;
+        std::vector<double> times;
+    };
+
+    void write_variable(const fs::path &file, const std::string &name,
+                        const std::vector<Variable> &values);
+
+    fs::path directory_;
+    std::string name_;
+    std::vector<std::vector<Block>> blocks_;
+    std::map<std::string, Series> series_;
+    bool closed_ = false;
+};
+
+}  // namespace otk
+
+#endif  // !OTK_ENSIGHT_HPP
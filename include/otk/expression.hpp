@@ -0,0 +1,107 @@
+#ifndef OTK_EXPRESSION_HPP
+#define OTK_EXPRESSION_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace otk {
+
+// =======================================================================================
+//
+//   Expression class
+//
+//   Arithmetic expression over named scalar variables, parsed once into a stack
+//   bytecode and evaluated over whole arrays:
+//
+//       sqrt(U1^2 + U2^2)     S11 / ALLOW     PEEQ > 0.02
+//
+//   Operators are + - * / ^ (right associative), unary minus and the comparisons
+//   < <= > >= == != (1 or 0). Functions are sqrt, abs, exp, log, sin, cos, min and max.
+//   Names found in the constants are folded into the code; the others are variables.
+//
+//   Each instruction is applied to a batch of EXPRESSION_BATCH values before the next
+//   one, so the inner loops are plain loops over contiguous arrays that the compiler
+//   can vectorize, and the stack holds one batch per level.
+//
+// =======================================================================================
+constexpr size_t EXPRESSION_BATCH = 1024;
+
+class Expression {
+   public:
+    // -----------------------------------------------------------------------------------
+    //
+    //   Parse an expression; throws std::runtime_error on a syntax error
+    //
+    // -----------------------------------------------------------------------------------
+    explicit Expression(const std::string &text,
+                        const std::map<std::string, double> &constants = {});
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Variable names, in the order of the inputs of evaluate()
+    //
+    // -----------------------------------------------------------------------------------
+    const std::vector<std::string> &variables() const { return variables_; }
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Evaluate the expression for count values; inputs[i] holds the count values of
+    //   variables()[i]
+    //
+    // -----------------------------------------------------------------------------------
+    void evaluate(const std::vector<const double *> &inputs, double *output,
+                  size_t count) const;
+
+    const std::string &text() const { return text_; }
+
+   private:
+    enum class Op {
+        CONSTANT,
+        VARIABLE,
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        DIVIDE,
+        POWER,
+        SQUARE,
+        NEGATE,
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        EQUAL,
+        NOT_EQUAL,
+        SQRT,
+        ABS,
+        EXP,
+        LOG,
+        SIN,
+        COS,
+        MIN,
+        MAX
+    };
+
+    struct Instruction {
+        Op op;
+        double value = 0.0;  // CONSTANT
+        int index = 0;       // VARIABLE
+    };
+
+    class Parser;
+
+    void emit(Op op, double value = 0.0, int index = 0);
+    static bool is_binary(Op op);
+    static double apply(Op op, double x, double y = 0.0);
+
+    std::string text_;
+    std::vector<Instruction> code_;
+    std::vector<std::string> variables_;
+    int depth_ = 0;      // Stack depth after the instructions emitted so far
+    int max_depth_ = 0;  // Stack levels needed by evaluate()
+};
+
+}  // namespace otk
+
+#endif  // !OTK_EXPRESSION_HPP
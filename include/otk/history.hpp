@@ -0,0 +1,153 @@
+#ifndef OTK_HISTORY_HPP
+#define OTK_HISTORY_HPP
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "otk/label_index.hpp"
+#include "otk/source.hpp"
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// =======================================================================================
+//
+//   History class
+//
+//   Extracts the time history of field outputs at selected nodes and elements. Only
+//   the selected entries are read from each frame and every field output is streamed
+//   to its own column store: one column per (instance, label, row, component) and one
+//   record per frame, written as CSV and/or raw binary with a JSON description.
+//
+//   History outputs (odb_Step::historyRegions) of the regions matching the "regions"
+//   regex keys are copied as well, filtered by the same "fields" keys as the field
+//   outputs.
+//
+//   The selection comes from the "history" object of the output request:
+//
+//       "history": {
+//           "format": ["csv", "binary"],
+//           "nodes": [{"instance": "PART-1-1", "labels": [1, 2, 3]}],
+//           "elements": [{"instance": "PART-1-1", "set": "MONITOR"}],
+//           "regions": ["Assembly .*", "Node PART-1-1\\..*"]
+//       }
+//
+// =======================================================================================
+class History {
+   public:
+    // -----------------------------------------------------------------------------------
+    //
+    //   Constructor
+    //
+    // -----------------------------------------------------------------------------------
+    History(const nlohmann::json &output_request) : output_request_(output_request) {}
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Extract the history of the requested frames and fields
+    //
+    // -----------------------------------------------------------------------------------
+    void extract(otk::Source &source, fs::path file);
+
+   protected:
+    // Selected node and element labels of an instance (sorted, unique)
+    struct Selection {
+        std::vector<int> nodes;
+        std::vector<int> elements;
+    };
+
+    // Column layout of one instance in a series
+    struct Layout {
+        LabelIndex index;              // Selected label -> entity index
+        std::vector<int> first_column; // First column of each entity
+        std::vector<int> num_rows;     // Rows (e.g. integration points) of each entity
+        int width = 0;
+    };
+
+    // Column store of one field output
+    struct Series {
+        std::string field;
+        std::vector<std::string> columns;
+        std::map<std::string, Layout> layouts;
+        bool double_precision = false;
+        std::vector<double> values;
+        std::ofstream csv;
+        std::ofstream binary;
+        fs::path binary_file;
+        nlohmann::json records;
+    };
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Resolve the node and element selection of the request (labels and sets)
+    //
+    // -----------------------------------------------------------------------------------
+    std::map<std::string, Selection> resolve_selection(otk::Source &source);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Copy the history outputs of the requested regions of each requested step
+    //
+    // -----------------------------------------------------------------------------------
+    void extract_regions(otk::Source &source, const fs::path &directory,
+                         const std::string &stem);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the history outputs of a region to CSV (outputs that do not share the
+    //   time axis of the first output get their own time column)
+    //
+    // -----------------------------------------------------------------------------------
+    void write_region_csv(const fs::path &csv_file,
+                          const std::vector<HistoryData> &outputs);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Match a field name with the regex keys of the request (cached)
+    //
+    // -----------------------------------------------------------------------------------
+    bool is_field_requested(const std::string &field);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Build the column layout of a series from the first frame holding the field
+    //
+    // -----------------------------------------------------------------------------------
+    void build_layout(Series &series, const std::map<std::string, FieldData> &data);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Gather the values of a frame into the record and append it to the stores
+    //
+    // -----------------------------------------------------------------------------------
+    void append_record(Series &series, const std::map<std::string, FieldData> &data,
+                       const std::string &step_name, int frame_id, double frame_value);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Open the stores of a series and close them with the binary description
+    //
+    // -----------------------------------------------------------------------------------
+    void open_series(Series &series, const fs::path &directory, const std::string &stem);
+    void close_series(Series &series);
+
+   private:
+    nlohmann::json output_request_;
+    std::vector<std::regex> field_keys_;
+    std::unordered_map<std::string, bool> field_matches_;
+    bool write_csv_ = true;
+    bool write_binary_ = false;
+};
+
+}  // namespace otk
+
+#endif  // !OTK_HISTORY_HPP
@@ -0,0 +1,52 @@
+#ifndef OTK_INFO_HPP
+#define OTK_INFO_HPP
+
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include "otk/source.hpp"
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// =======================================================================================
+//
+//   Machine-readable model info
+//
+//   Describes a model (instances with their element types and section categories,
+//   steps with their frames and field outputs) as JSON for scripts. The verbose dump
+//   adds every node and element, either as JSON arrays or as CSV tables:
+//
+//       info.json            {"instances": {"PART-1-1": {..., "nodes": [[label, x, y, z],
+//                             ...], "elements": [[label, type, section, [nodes]], ...]}},
+//                             "steps": [...]}
+//       info.csv             instance,dimension,num_nodes,num_elements
+//       info_nodes.csv       instance,label,x,y,z
+//       info_elements.csv    instance,label,type,section,connectivity
+//
+//   Mesh rows are formatted in parallel chunks from the bulk node and element arrays
+//   and written in large blocks, in order.
+//
+// =======================================================================================
+
+// ---------------------------------------------------------------------------------------
+//
+//   JSON summary of a model
+//
+// ---------------------------------------------------------------------------------------
+nlohmann::json info_summary(const Source &source);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the model info to a .json or .csv file; verbose adds the nodes and elements.
+//   threads <= 0 uses all hardware threads.
+//
+// ---------------------------------------------------------------------------------------
+void write_info(const Source &source, const fs::path &file, bool verbose,
+                int threads = 0);
+
+}  // namespace otk
+
+#endif  // !OTK_INFO_HPP
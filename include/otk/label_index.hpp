@@ -0,0 +1,87 @@
+#ifndef OTK_LABEL_INDEX_HPP
+#define OTK_LABEL_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace otk {
+
+// =======================================================================================
+//
+//   LabelIndex class
+//
+//   Maps Abaqus node or element labels to array indices. Labels are usually compact,
+//   so a dense lookup table is used unless it would be much larger than the number of
+//   labels, in which case a hash map is used instead.
+//
+// =======================================================================================
+class LabelIndex {
+   public:
+    // -----------------------------------------------------------------------------------
+    //
+    //   Build the index; labels[i] maps to i
+    //
+    // -----------------------------------------------------------------------------------
+    void build(const std::vector<int> &labels) {
+        dense_.clear();
+        sparse_.clear();
+        size_ = labels.size();
+
+        int max_label = -1;
+        int min_label = 0;
+        for (const auto &label : labels) {
+            max_label = std::max(max_label, label);
+            min_label = std::min(min_label, label);
+        }
+
+        is_dense_ =
+            (min_label >= 0) && (static_cast<size_t>(max_label) <= 2 * size_ + 1024);
+        if (is_dense_) {
+            dense_.assign(static_cast<size_t>(max_label) + 1, -1);
+            for (size_t i = 0; i < labels.size(); ++i) {
+                dense_[labels[i]] = static_cast<std::int64_t>(i);
+            }
+        } else {
+            sparse_.reserve(labels.size());
+            for (size_t i = 0; i < labels.size(); ++i) {
+                sparse_[labels[i]] = static_cast<std::int64_t>(i);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Index of a label (-1 if the label is not indexed)
+    //
+    // -----------------------------------------------------------------------------------
+    inline std::int64_t find(int label) const {
+        if (is_dense_) {
+            return (label >= 0 && static_cast<size_t>(label) < dense_.size())
+                       ? dense_[label]
+                       : -1;
+        }
+        auto it = sparse_.find(label);
+        return (it != sparse_.end()) ? it->second : -1;
+    }
+
+    inline size_t size() const { return size_; }
+
+    inline size_t memory_size() const {
+        return dense_.capacity() * sizeof(std::int64_t) +
+               sparse_.size() * (sizeof(std::pair<const int, std::int64_t>) +
+                                 2 * sizeof(void *)) +
+               sparse_.bucket_count() * sizeof(void *);
+    }
+
+   private:
+    bool is_dense_ = true;
+    size_t size_ = 0;
+    std::vector<std::int64_t> dense_;
+    std::unordered_map<int, std::int64_t> sparse_;
+};
+
+}  // namespace otk
+
+#endif  // !OTK_LABEL_INDEX_HPP
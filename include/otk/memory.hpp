@@ -0,0 +1,38 @@
+#ifndef OTK_MEMORY_HPP
+#define OTK_MEMORY_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Resident set size of the process (current and high-water mark, in bytes)
+//
+// ---------------------------------------------------------------------------------------
+size_t current_rss();
+
+size_t peak_rss();
+
+// ---------------------------------------------------------------------------------------
+//
+//   Memory sample taken at a phase boundary
+//
+// ---------------------------------------------------------------------------------------
+struct MemorySample {
+    std::string phase;
+    size_t rss;
+    size_t peak;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Sample the RSS and record it as a "memory" counter in the trace
+//
+// ---------------------------------------------------------------------------------------
+MemorySample sample_memory(const std::string &phase);
+
+}  // namespace otk
+
+#endif  // !OTK_MEMORY_HPP
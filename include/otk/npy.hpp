@@ -0,0 +1,91 @@
+#ifndef OTK_NPY_HPP
+#define OTK_NPY_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <vtkDataArray.h>
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Header of a .npy array (format 1.0, padded to 64 bytes) for a store dtype
+//   ("float32", "int64", ...; see store_dtype) and a shape
+//
+// ---------------------------------------------------------------------------------------
+std::string npy_header(const std::string &dtype, const std::vector<size_t> &shape);
+
+// =======================================================================================
+//
+//   NumpyWriter class
+//
+//   Writes arrays as NumPy .npy files under a directory, or as the members of an
+//   uncompressed (stored) .npz archive. Arrays with one component are written as 1-D
+//   arrays, others as [rows x components]. The data is written straight from the
+//   caller's buffer, and .npy files can be loaded with np.load(mmap_mode="r").
+//
+// =======================================================================================
+class NumpyWriter {
+   public:
+    // -----------------------------------------------------------------------------------
+    //
+    //   Constructor; path is the directory of the .npy files, or the .npz file
+    //
+    // -----------------------------------------------------------------------------------
+    NumpyWriter(const fs::path &path, bool npz);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Destructor (writes the .npz central directory if close() was not called)
+    //
+    // -----------------------------------------------------------------------------------
+    ~NumpyWriter();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Class is non-copyable
+    //
+    // -----------------------------------------------------------------------------------
+    NumpyWriter(const NumpyWriter &) = delete;
+    NumpyWriter &operator=(const NumpyWriter &) = delete;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write an array; the name may contain "/" separators (sub-directories)
+    //
+    // -----------------------------------------------------------------------------------
+    void write(const std::string &name, const std::string &dtype, size_t num_rows,
+               int num_components, const void *data);
+    void write(const std::string &name, vtkDataArray *array);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Close the .npz archive
+    //
+    // -----------------------------------------------------------------------------------
+    void close();
+
+   private:
+    struct Member {
+        std::string name;
+        std::uint32_t crc;
+        std::uint64_t size;
+        std::uint64_t offset;
+    };
+
+    fs::path path_;
+    bool npz_ = false;
+    std::ofstream stream_;
+    std::uint64_t position_ = 0;
+    std::vector<Member> members_;
+};
+
+}  // namespace otk
+
+#endif  // !OTK_NPY_HPP
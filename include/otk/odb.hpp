@@ -15,15 +15,36 @@
 #include <nlohmann/json.hpp>
 
 #include "otk/cli.hpp"
+#include "otk/source.hpp"
 
 namespace otk {
 
 // =======================================================================================
 //
-//   Odb class
+//   OdbSession class
+//
+//   Initializes the ODB API for the lifetime of the object. Exactly one session must
+//   be alive while otk::Odb objects exist; it is created once per process so that
+//   several ODB files can be opened without paying for the API start-up each time.
+//
+// =======================================================================================
+class OdbSession {
+   public:
+    OdbSession();
+    ~OdbSession();
+
+    OdbSession(const OdbSession &) = delete;
+    OdbSession &operator=(const OdbSession &) = delete;
+
+    static bool active();
+};
+
+// =======================================================================================
+//
+//   Odb class (otk::Source implementation on top of odb_API.h)
 //
 // =======================================================================================
-class Odb {
+class Odb : public Source {
    public:
     // -----------------------------------------------------------------------------------
     //
@@ -31,7 +52,7 @@ class Odb {
     //
     // -----------------------------------------------------------------------------------
     Odb(fs::path path);
-    ~Odb();
+    ~Odb() override;
 
     // -----------------------------------------------------------------------------------
     //
@@ -52,11 +73,43 @@ class Odb {
 
     // -----------------------------------------------------------------------------------
     //
-    //   JSON summary functions (used by the otk::Converter class)
+    //   otk::Source interface
     //
     // -----------------------------------------------------------------------------------
-    nlohmann::json field_summary(nlohmann::json &frames) const;
-    nlohmann::json instance_summary() const;
+    std::vector<std::string> instance_names() const override;
+    Dimension dimension(const std::string &instance) const override;
+    int num_nodes(const std::string &instance) const override;
+    int num_elements(const std::string &instance) const override;
+    NodeData nodes(const std::string &instance) const override;
+    ElementData elements(const std::string &instance) const override;
+
+    std::vector<int> node_set(const std::string &instance,
+                              const std::string &name) const override;
+    std::vector<int> element_set(const std::string &instance,
+                                 const std::string &name) const override;
+
+    std::vector<std::string> step_names() const override;
+    int num_frames(const std::string &step) const override;
+    FrameInfo frame(const std::string &step, int frame) const override;
+    std::vector<std::string> field_names(const std::string &step,
+                                         int frame) const override;
+    FieldInfo field_info(const std::string &step, int frame,
+                         const std::string &field) const override;
+
+    FieldData field_data(const std::string &step, int frame, const std::string &field,
+                         const std::string &instance, const ElementGroups &groups,
+                         bool composite,
+                         const std::vector<int> &region_nodes) const override;
+    FieldData field_values(const std::string &step, int frame, const std::string &field,
+                           const std::string &instance,
+                           const std::vector<int> &node_labels,
+                           const std::vector<int> &element_labels) const override;
+
+    std::vector<std::string> history_region_names(const std::string &step) const override;
+    std::vector<std::string> history_output_names(
+        const std::string &step, const std::string &region) const override;
+    HistoryData history_output(const std::string &step, const std::string &region,
+                               const std::string &output) const override;
 
     // -----------------------------------------------------------------------------------
     //
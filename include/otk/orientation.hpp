@@ -0,0 +1,71 @@
+#ifndef OTK_ORIENTATION_HPP
+#define OTK_ORIENTATION_HPP
+
+#include <array>
+#include <cstddef>
+
+#include "otk/source.hpp"
+
+namespace otk {
+
+// =======================================================================================
+//
+//   Local orientations
+//
+//   Vector and tensor results of elements with a local orientation (composite layups,
+//   *ORIENTATION) are stored in the local axes. Each result row then comes with the
+//   local axes as a unit quaternion (x, y, z, w), and the rows are rotated to a set of
+//   output axes: the global axes or user axes given by their global direction
+//   cosines.
+//
+//   Vectors become 3 values and tensors the 6 values 11, 22, 33, 12, 13, 23 of the
+//   full 3D tensor (TENSOR_3D_FULL layout), since a planar tensor in local axes is not
+//   planar in the output axes in general. Rows are rotated in batches of
+//   ORIENTATION_BATCH with one fused matrix (output axes x local axes) per row.
+//
+// =======================================================================================
+constexpr int ORIENTATION_BATCH = 512;
+
+// Row-major 3x3 matrix; rows of output axes are the axes in global coordinates
+using Matrix3 = std::array<double, 9>;
+
+constexpr Matrix3 IDENTITY_AXES{1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+
+// Largest cosine between two user axes still taken as orthogonal
+constexpr double AXES_TOLERANCE = 1e-6;
+
+// ---------------------------------------------------------------------------------------
+//
+//   Whether rows of a data type are rotated, and their type and width once rotated
+//
+// ---------------------------------------------------------------------------------------
+bool is_rotatable(DataType type);
+DataType rotated_type(DataType type);
+int rotated_width(DataType type);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Output axes from three direction vectors (normalized; throws unless the directions
+//   are orthogonal within AXES_TOLERANCE and right-handed)
+//
+// ---------------------------------------------------------------------------------------
+Matrix3 make_axes(const std::array<std::array<double, 3>, 3> &directions);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Rotate count rows of width values to the output axes
+//
+//   quaternions holds orientation_width (4) values per row, or is null for rows that
+//   are already in global axes. Engineering shear components (strains) are halved
+//   before and doubled after the rotation. out receives rotated_width(type) values
+//   per row.
+//
+// ---------------------------------------------------------------------------------------
+template <typename T>
+void rotate_rows(DataType type, bool engineering, const T *rows, int width,
+                 const T *quaternions, int orientation_width, const Matrix3 &axes,
+                 size_t count, double *out);
+
+}  // namespace otk
+
+#endif  // !OTK_ORIENTATION_HPP
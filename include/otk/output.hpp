@@ -1,16 +1,9 @@
 #ifndef OTK_OUTPUT_HPP
 #define OTK_OUTPUT_HPP
 
-#include <nlohmann/json.hpp>
-
-#include <odb_API.h>
-
-#include <vtkCellArray.h>
-#include <vtkCellType.h>
-#include <vtkPoints.h>
-#include <vtkUnstructuredGrid.h>
+#include <filesystem>
 
-#include "otk/odb.hpp"
+#include <nlohmann/json.hpp>
 
 namespace otk {
 
@@ -21,6 +14,13 @@ namespace otk {
 // ---------------------------------------------------------------------------------------
 bool is_output_request_valid(const nlohmann::json &output_request);
 
+// ---------------------------------------------------------------------------------------
+//
+//   Read and validate the JSON output request file
+//
+// ---------------------------------------------------------------------------------------
+nlohmann::json read_output_request(const std::filesystem::path &json_file);
+
 }  // namespace otk
 
 #endif  // !OTK_OUTPUT_HPP
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef OTK_PARALLEL_HPP
+#define OTK_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Number of threads to use for a requested count (<= 0: all hardware threads)
+//
+// ---------------------------------------------------------------------------------------
+inline int thread_count(int threads) {
+    if (threads > 0) {
+        return threads;
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Run task(i, worker) for i in [0, count) on up to num_threads threads
+//
+//   Workers take the next index from a shared counter; worker is the index of the
+//   thread in [0, num_threads) so that tasks can use per-thread state. The calling
+//   thread is worker 0. The first exception stops the remaining tasks and is rethrown.
+//
+// ---------------------------------------------------------------------------------------
+template <typename Task>
+void parallel_for(size_t count, int num_threads, Task &&task) {
+    num_threads = static_cast<int>(
+        std::clamp<size_t>(static_cast<size_t>(std::max(num_threads, 1)), 1,
+                           std::max<size_t>(count, 1)));
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&](int worker_id) {
+        try {
+            for (size_t i = next++; i < count; i = next++) {
+                task(i, worker_id);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock{error_mutex};
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_threads; ++i) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto &thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace otk
+
+#endif  // !OTK_PARALLEL_HPP
@@ -0,0 +1,244 @@
+#ifndef OTK_SOURCE_HPP
+#define OTK_SOURCE_HPP
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Enumerations mirroring the parts of odb_Enum used by OTK
+//
+// ---------------------------------------------------------------------------------------
+enum class Dimension { THREE_D, TWO_D_PLANAR, AXISYMMETRIC, UNSUPPORTED };
+
+enum class DataType {
+    SCALAR,
+    VECTOR,
+    TENSOR_3D_FULL,
+    TENSOR_3D_PLANAR,
+    TENSOR_2D_PLANAR,
+    UNSUPPORTED
+};
+
+enum class Position {
+    NODAL,
+    ELEMENT_NODAL,
+    WHOLE_ELEMENT,
+    INTEGRATION_POINT,
+    UNSUPPORTED
+};
+
+enum class Precision { SINGLE, DOUBLE };
+
+// ---------------------------------------------------------------------------------------
+//
+//   Mesh data of an instance, fetched in bulk
+//
+// ---------------------------------------------------------------------------------------
+struct NodeData {
+    std::vector<int> labels;
+    std::vector<float> coordinates;  // 3 per node, z = 0 for planar instances
+};
+
+struct ElementData {
+    std::vector<int> labels;
+    std::vector<int> types;                  // Index into type_names
+    std::vector<int> sections;               // Index into section_names
+    std::vector<int> offsets;                // Size is number of elements + 1
+    std::vector<int> connectivity;           // Node labels
+    std::vector<std::string> type_names;     // Abaqus element types (e.g. C3D8R)
+    std::vector<std::string> section_names;  // Raw section category names
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Frame description
+//
+// ---------------------------------------------------------------------------------------
+struct FrameInfo {
+    int id;
+    int increment;
+    double value;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Bulk data block of a field output
+//
+//   The pointers view storage owned by FieldData::storage. Each of the `length` rows
+//   holds `width` values and is labelled with a node label (NODAL, ELEMENT_NODAL) or
+//   an element label (WHOLE_ELEMENT, INTEGRATION_POINT). Exactly one of
+//   data/data_double is set. Results in local axes also have `orientation_width`
+//   values per row (a quaternion) in orientation/orientation_double, at the precision
+//   of the data.
+//
+// ---------------------------------------------------------------------------------------
+struct FieldBlock {
+    Position position;
+    Precision precision;
+    int width;
+    int length;
+    const int *labels;
+    const float *data;
+    const double *data_double;
+    int orientation_width = 0;
+    const float *orientation = nullptr;
+    const double *orientation_double = nullptr;
+};
+
+struct FieldData {
+    std::string name;
+    DataType type = DataType::UNSUPPORTED;
+    bool engineering = false;  // Shear components are engineering strains
+    std::vector<FieldBlock> blocks;
+    std::shared_ptr<const void> storage;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Description of a field output of a frame (no bulk data): type, number of
+//   components and the positions it is stored at
+//
+// ---------------------------------------------------------------------------------------
+struct FieldInfo {
+    std::string name;
+    DataType type = DataType::UNSUPPORTED;
+    int width = 0;
+    std::vector<Position> positions;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   History output of a history region: one value per output time
+//
+// ---------------------------------------------------------------------------------------
+struct HistoryData {
+    std::string name;
+    std::string description;
+    std::vector<double> time;
+    std::vector<double> values;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Element groups used to localize field outputs, keyed by section category and
+//   element type; values are element labels
+//
+// ---------------------------------------------------------------------------------------
+using ElementGroups = std::map<std::string, std::vector<int>>;
+
+// =======================================================================================
+//
+//   Source class
+//
+//   Abstraction over the parts of the ODB API used by OTK: instances, nodes, elements,
+//   steps, frames, field outputs, bulk data blocks and history outputs. otk::Odb
+//   implements it on top of odb_API.h and otk::SyntheticSource generates an in-memory
+//   model for benchmarking.
+//
+// =======================================================================================
+class Source {
+   public:
+    virtual ~Source() = default;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Instances
+    //
+    // -----------------------------------------------------------------------------------
+    virtual std::vector<std::string> instance_names() const = 0;
+    virtual Dimension dimension(const std::string &instance) const = 0;
+    virtual int num_nodes(const std::string &instance) const = 0;
+    virtual int num_elements(const std::string &instance) const = 0;
+    virtual NodeData nodes(const std::string &instance) const = 0;
+    virtual ElementData elements(const std::string &instance) const = 0;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Labels of the nodes or elements of an instance set
+    //
+    // -----------------------------------------------------------------------------------
+    virtual std::vector<int> node_set(const std::string &instance,
+                                      const std::string &name) const = 0;
+    virtual std::vector<int> element_set(const std::string &instance,
+                                         const std::string &name) const = 0;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Steps and frames
+    //
+    // -----------------------------------------------------------------------------------
+    virtual std::vector<std::string> step_names() const = 0;
+    virtual int num_frames(const std::string &step) const = 0;
+    virtual FrameInfo frame(const std::string &step, int frame) const = 0;
+    virtual std::vector<std::string> field_names(const std::string &step,
+                                                 int frame) const = 0;
+    virtual FieldInfo field_info(const std::string &step, int frame,
+                                 const std::string &field) const = 0;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Field outputs of an instance
+    //
+    //   Results at integration points are extrapolated to ELEMENT_NODAL and, for
+    //   composite sections, reduced to the envelope over the section points of each
+    //   element group. Nodal results are read for the sorted region_nodes only, or for
+    //   the whole instance if it is empty.
+    //
+    // -----------------------------------------------------------------------------------
+    virtual FieldData field_data(const std::string &step, int frame,
+                                 const std::string &field, const std::string &instance,
+                                 const ElementGroups &groups, bool composite,
+                                 const std::vector<int> &region_nodes) const = 0;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Field output values at selected nodes and elements of an instance
+    //
+    //   Only the entries of the given labels are read. Nodal results are returned per
+    //   node (NODAL); element results keep their native position, either one row per
+    //   element (WHOLE_ELEMENT) or one row per integration point (INTEGRATION_POINT).
+    //
+    // -----------------------------------------------------------------------------------
+    virtual FieldData field_values(const std::string &step, int frame,
+                                   const std::string &field, const std::string &instance,
+                                   const std::vector<int> &node_labels,
+                                   const std::vector<int> &element_labels) const = 0;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   History regions and outputs of a step
+    //
+    // -----------------------------------------------------------------------------------
+    virtual std::vector<std::string> history_region_names(
+        const std::string &step) const = 0;
+    virtual std::vector<std::string> history_output_names(
+        const std::string &step, const std::string &region) const = 0;
+    virtual HistoryData history_output(const std::string &step, const std::string &region,
+                                       const std::string &output) const = 0;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   JSON summary functions (used by the otk::Converter class)
+    //
+    // -----------------------------------------------------------------------------------
+    nlohmann::json field_summary(nlohmann::json &frames) const;
+    nlohmann::json instance_summary() const;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Map a raw section category name to a display category
+//
+// ---------------------------------------------------------------------------------------
+std::string get_section_category_name(const std::string &section_category_raw_name);
+
+}  // namespace otk
+
+#endif  // !OTK_SOURCE_HPP
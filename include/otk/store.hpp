@@ -0,0 +1,198 @@
+#ifndef OTK_STORE_HPP
+#define OTK_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <vtkDataArray.h>
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// =======================================================================================
+//
+//   OTK frame store (.otks)
+//
+//   One file per ODB holding the mesh of each instance once, followed by one chunk per
+//   (step, frame, instance, field). The layout is
+//
+//       "OTKSTORE" | uint32 version | uint32 alignment | chunks... | JSON index |
+//       uint64 index offset | uint64 index size | "OTKINDEX"
+//
+//   Every chunk starts at a multiple of the alignment and holds a little-endian
+//   row-major [rows x components] array. The JSON index at the end of the file lists
+//   the chunks with their kind ("mesh", "point", "cell" or "coordinates" for deformed
+//   points), names, dtype, shape, byte offset and size. Uncompressed chunks can be
+//   used in place from a memory map; zlib-compressed chunks are inflated on first
+//   access. Entries with a "link" reuse the data of an earlier chunk (the topology
+//   shared by instances of a part).
+//
+// =======================================================================================
+constexpr std::uint32_t STORE_VERSION = 1;
+constexpr std::uint64_t STORE_ALIGNMENT = 64;
+
+// ---------------------------------------------------------------------------------------
+//
+//   Store dtype of a VTK data type ("float32", "int64", ...; empty if unsupported)
+//
+// ---------------------------------------------------------------------------------------
+std::string store_dtype(int vtk_type);
+
+// =======================================================================================
+//
+//   StoreWriter class
+//
+// =======================================================================================
+class StoreWriter {
+   public:
+    // -----------------------------------------------------------------------------------
+    //
+    //   Constructor (creates the file and writes the header)
+    //
+    // -----------------------------------------------------------------------------------
+    StoreWriter(const fs::path &file, bool compress);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Destructor (writes the index if close() was not called)
+    //
+    // -----------------------------------------------------------------------------------
+    ~StoreWriter();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Class is non-copyable
+    //
+    // -----------------------------------------------------------------------------------
+    StoreWriter(const StoreWriter &) = delete;
+    StoreWriter &operator=(const StoreWriter &) = delete;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Append a chunk; the entry holds its kind, names and any extra attributes, and
+    //   gets the dtype, shape, offset and sizes. Returns the id of the chunk.
+    //
+    // -----------------------------------------------------------------------------------
+    size_t write(nlohmann::json entry, const std::string &dtype, size_t num_rows,
+                 int num_components, const void *data);
+    size_t write(nlohmann::json entry, vtkDataArray *array);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Add an index entry for the data of a previous chunk (given by the value
+    //   returned by write) instead of writing it again
+    //
+    // -----------------------------------------------------------------------------------
+    size_t link(nlohmann::json entry, size_t chunk_id);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the index and the footer
+    //
+    // -----------------------------------------------------------------------------------
+    void close();
+
+   private:
+    fs::path file_;
+    std::ofstream stream_;
+    std::uint64_t position_ = 0;
+    bool compress_ = false;
+    nlohmann::json chunks_ = nlohmann::json::array();
+};
+
+// =======================================================================================
+//
+//   Store class
+//
+//   Read-only access to an OTK frame store through a memory map of the whole file.
+//
+// =======================================================================================
+class Store {
+   public:
+    // View of one chunk; data stays valid as long as the Store
+    struct Chunk {
+        const void *data = nullptr;
+        std::string dtype;
+        size_t num_rows = 0;
+        int num_components = 0;
+        const nlohmann::json *entry = nullptr;
+
+        explicit operator bool() const { return data != nullptr; }
+
+        template <typename T>
+        const T *as() const {
+            return static_cast<const T *>(data);
+        }
+    };
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Constructor (maps the file and reads the index)
+    //
+    // -----------------------------------------------------------------------------------
+    explicit Store(const fs::path &file);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Destructor (unmaps the file)
+    //
+    // -----------------------------------------------------------------------------------
+    ~Store();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Class is non-copyable
+    //
+    // -----------------------------------------------------------------------------------
+    Store(const Store &) = delete;
+    Store &operator=(const Store &) = delete;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Index of the store (chunk entries)
+    //
+    // -----------------------------------------------------------------------------------
+    const nlohmann::json &chunks() const { return index_["chunks"]; }
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Mesh chunk of an instance ("points", "offsets", "connectivity", "types")
+    //
+    // -----------------------------------------------------------------------------------
+    Chunk mesh(const std::string &instance_name, const std::string &name);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Field chunk of an instance in a frame (point or cell array)
+    //
+    // -----------------------------------------------------------------------------------
+    Chunk field(const std::string &step_name, int frame_id,
+                const std::string &instance_name, const std::string &field_name);
+
+   private:
+    Chunk load(size_t chunk_id);
+    void unmap();
+
+    fs::path file_;
+    const unsigned char *base_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32) || defined(_WIN64)
+    void *file_handle_ = nullptr;
+    void *mapping_handle_ = nullptr;
+#endif
+    nlohmann::json index_;
+    std::unordered_map<std::string, size_t> lookup_;
+    std::unordered_map<std::uint64_t, std::vector<unsigned char>> inflated_;
+};
+
+}  // namespace otk
+
+#endif  // !OTK_STORE_HPP
@@ -0,0 +1,117 @@
+#ifndef OTK_SYNTHETIC_HPP
+#define OTK_SYNTHETIC_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "otk/source.hpp"
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Synthetic model configuration
+//
+//   Each instance is a structured grid of C3D8R elements, so an instance has
+//   nx * ny * nz elements and (nx + 1) * (ny + 1) * (nz + 1) nodes.
+//
+// ---------------------------------------------------------------------------------------
+struct SyntheticConfig {
+    int instances = 1;
+    int nx = 10;
+    int ny = 10;
+    int nz = 10;
+    int steps = 1;
+    int frames = 10;
+    int nodal_scalar_fields = 1;       // NODAL scalars
+    int nodal_vector_fields = 1;       // NODAL vectors (the first one is named U)
+    int element_scalar_fields = 1;     // WHOLE_ELEMENT scalars
+    int integration_scalar_fields = 1; // Integration point scalars (ELEMENT_NODAL rows)
+    int integration_tensor_fields = 1; // Integration point tensors (ELEMENT_NODAL rows)
+    bool double_precision = false;
+};
+
+// =======================================================================================
+//
+//   SyntheticSource class (in-memory otk::Source for benchmarking)
+//
+// =======================================================================================
+class SyntheticSource : public Source {
+   public:
+    // -----------------------------------------------------------------------------------
+    //
+    //   Constructor
+    //
+    // -----------------------------------------------------------------------------------
+    SyntheticSource(const SyntheticConfig &config);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   otk::Source interface
+    //
+    // -----------------------------------------------------------------------------------
+    std::vector<std::string> instance_names() const override;
+    Dimension dimension(const std::string &instance) const override;
+    int num_nodes(const std::string &instance) const override;
+    int num_elements(const std::string &instance) const override;
+    NodeData nodes(const std::string &instance) const override;
+    ElementData elements(const std::string &instance) const override;
+
+    std::vector<int> node_set(const std::string &instance,
+                              const std::string &name) const override;
+    std::vector<int> element_set(const std::string &instance,
+                                 const std::string &name) const override;
+
+    std::vector<std::string> step_names() const override;
+    int num_frames(const std::string &step) const override;
+    FrameInfo frame(const std::string &step, int frame) const override;
+    std::vector<std::string> field_names(const std::string &step,
+                                         int frame) const override;
+    FieldInfo field_info(const std::string &step, int frame,
+                         const std::string &field) const override;
+
+    FieldData field_data(const std::string &step, int frame, const std::string &field,
+                         const std::string &instance, const ElementGroups &groups,
+                         bool composite,
+                         const std::vector<int> &region_nodes) const override;
+    FieldData field_values(const std::string &step, int frame, const std::string &field,
+                           const std::string &instance,
+                           const std::vector<int> &node_labels,
+                           const std::vector<int> &element_labels) const override;
+
+    std::vector<std::string> history_region_names(const std::string &step) const override;
+    std::vector<std::string> history_output_names(
+        const std::string &step, const std::string &region) const override;
+    HistoryData history_output(const std::string &step, const std::string &region,
+                               const std::string &output) const override;
+
+   private:
+    struct FieldSpec {
+        DataType type;
+        Position position;
+        int width;
+    };
+
+    // Bulk data generated for one (step, frame, field, instance)
+    struct Block {
+        std::vector<int> labels;
+        std::vector<float> data;
+        std::vector<double> data_double;
+    };
+
+    int instance_index(const std::string &instance) const;
+    const FieldSpec &field_spec(const std::string &field) const;
+    FieldData make_field(const std::string &field, const FieldSpec &spec,
+                         Position position, std::vector<int> labels, int frame) const;
+
+    SyntheticConfig config_;
+    std::vector<std::string> instance_names_;
+    std::vector<std::string> field_names_;
+    std::unordered_map<std::string, FieldSpec> field_specs_;
+};
+
+}  // namespace otk
+
+#endif  // !OTK_SYNTHETIC_HPP
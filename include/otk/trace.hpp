@@ -0,0 +1,172 @@
+#ifndef OTK_TRACE_HPP
+#define OTK_TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// =======================================================================================
+//
+//   Tracer class
+//
+//   Keeps per-name aggregates of the ScopedTimer durations (count, total and a
+//   histogram of TRACE_BUCKETS log-spaced buckets for the percentiles), which take
+//   constant memory and are always on. Complete ("X") trace events and counter ("C")
+//   events such as memory samples are only kept while recording is enabled (--trace),
+//   since a long conversion fires the field timers millions of times. The timers are
+//   placed around phases, instances and fields, never inside element loops.
+//
+// =======================================================================================
+constexpr int TRACE_BUCKETS_PER_DECADE = 10;
+constexpr double TRACE_MIN_MS = 1e-3;  // Lower bound of the first bucket (1 us)
+constexpr int TRACE_BUCKETS = 9 * TRACE_BUCKETS_PER_DECADE + 2;  // Up to 1e6 ms
+
+class Tracer {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        std::string name;
+        std::string category;
+        Clock::time_point start;
+        Clock::duration duration;
+        int thread;
+        nlohmann::json args;
+        char phase = 'X';
+    };
+
+    // Durations of one timer name; bucket 0 holds durations below TRACE_MIN_MS and
+    // the last bucket the ones above the range
+    struct Aggregate {
+        size_t count = 0;
+        double total_ms = 0.0;
+        std::array<std::uint64_t, TRACE_BUCKETS> buckets{};
+    };
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Process-wide tracer
+    //
+    // -----------------------------------------------------------------------------------
+    static Tracer &instance();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Class is non-copyable
+    //
+    // -----------------------------------------------------------------------------------
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Record events
+    //
+    // -----------------------------------------------------------------------------------
+    void record(Event event);
+    void aggregate(std::string_view name, Clock::duration duration);
+    void counter(std::string name, nlohmann::json values);
+    void metadata(const std::string &key, nlohmann::json value);
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Keep individual events (off by default); clear_events() drops the events and
+    //   metadata, clear() the aggregates as well
+    //
+    // -----------------------------------------------------------------------------------
+    void set_recording(bool recording) { recording_ = recording; }
+    bool recording() const { return recording_; }
+    void clear_events();
+    void clear();
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Per-phase summary (count, total, p50, p99 in milliseconds; the percentiles are
+    //   the centers of their histogram buckets)
+    //
+    // -----------------------------------------------------------------------------------
+    nlohmann::json summary() const;
+    void print_summary() const;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Write the Chrome trace-event JSON file (chrome://tracing, Perfetto)
+    //
+    // -----------------------------------------------------------------------------------
+    void write_chrome_trace(const fs::path &file) const;
+
+    // -----------------------------------------------------------------------------------
+    //
+    //   Small per-thread index used as the trace "tid"
+    //
+    // -----------------------------------------------------------------------------------
+    static int thread_index();
+
+   private:
+    Tracer() : origin_(Clock::now()) {}
+
+    double to_microseconds(Clock::time_point time) const;
+
+    Clock::time_point origin_;
+    mutable std::mutex mutex_;
+    std::atomic<bool> recording_{false};
+    std::vector<Event> events_;
+    std::map<std::string, Aggregate, std::less<>> aggregates_;
+    nlohmann::json metadata_;
+};
+
+// =======================================================================================
+//
+//   ScopedTimer class (records one event on destruction)
+//
+//   The name and category are string literals, and the event arguments are built by a
+//   callable returning a json object, which is only called while the tracer records:
+//
+//       ScopedTimer timer{"write", [&] { return json{{"frame", frame_id}}; }};
+//
+//   so that a timer costs two clock reads and an aggregate update when tracing is off.
+//
+// =======================================================================================
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(const char *name, const char *category = "otk")
+        : name_(name), category_(category), start_(Tracer::Clock::now()) {}
+
+    template <typename MakeArgs>
+        requires std::is_invocable_r_v<nlohmann::json, MakeArgs>
+    ScopedTimer(const char *name, MakeArgs &&make_args, const char *category = "otk")
+        : name_(name), category_(category) {
+        if (Tracer::instance().recording()) {
+            args_ = make_args();
+        }
+        start_ = Tracer::Clock::now();
+    }
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+   private:
+    const char *name_;
+    const char *category_;
+    nlohmann::json args_;
+    Tracer::Clock::time_point start_;
+};
+
+}  // namespace otk
+
+#endif  // !OTK_TRACE_HPP
@@ -0,0 +1,88 @@
+#ifndef OTK_VTK_XML_HPP
+#define OTK_VTK_XML_HPP
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vtkDataArray.h>
+
+namespace fs = std::filesystem;
+
+namespace otk {
+
+// =======================================================================================
+//
+//   Native VTK XML writer
+//
+//   Writes .vtu files in raw appended-binary form (UInt64 headers, little-endian)
+//   straight from the converter's arrays, and the .vtpc collection that lists them.
+//   The array buffers are handed to the operating system as they are, with one
+//   vectored write per file, instead of being copied into VTK datasets first.
+//
+//   With compression, each array is split into fixed-size blocks that are compressed
+//   in parallel and written behind the VTK compressed-block header
+//   [num_blocks, block_size, last_block_size, compressed_size...].
+//
+// =======================================================================================
+
+// ---------------------------------------------------------------------------------------
+//
+//   Unstructured grid of one instance; offsets holds num_cells + 1 entries starting
+//   at 0 (vtkCellArray layout) and types the VTK cell types
+//
+// ---------------------------------------------------------------------------------------
+struct VtuPiece {
+    vtkDataArray *points = nullptr;
+    vtkDataArray *offsets = nullptr;
+    vtkDataArray *connectivity = nullptr;
+    const int *types = nullptr;
+    size_t num_cells = 0;
+    std::vector<vtkDataArray *> point_data;
+    std::vector<vtkDataArray *> cell_data;
+    std::vector<vtkDataArray *> field_data;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Block compression of the appended arrays; compressor is "zlib", "lz4", "lzma" (the
+//   compressors ParaView reads) or empty for raw data. threads <= 0 uses all hardware
+//   threads.
+//
+// ---------------------------------------------------------------------------------------
+struct VtuCompression {
+    std::string compressor;
+    int threads = 0;
+};
+
+constexpr size_t VTU_BLOCK_SIZE = 1 << 18;
+
+// ---------------------------------------------------------------------------------------
+//
+//   VTK XML type name of a data array ("Float32", "Int64", ...)
+//
+// ---------------------------------------------------------------------------------------
+std::string vtk_xml_type(vtkDataArray *array);
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write an unstructured grid file (.vtu)
+//
+// ---------------------------------------------------------------------------------------
+void write_vtu(const fs::path &file, const VtuPiece &piece,
+               const VtuCompression &compression = {});
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write a partitioned dataset collection file (.vtpc); each partitioned dataset is
+//   given by its name and the paths of its .vtu files relative to the .vtpc file
+//
+// ---------------------------------------------------------------------------------------
+void write_vtpc(
+    const fs::path &file,
+    const std::vector<std::pair<std::string, std::vector<std::string>>> &datasets);
+
+}  // namespace otk
+
+#endif  // !OTK_VTK_XML_HPP
@@ -0,0 +1,350 @@
+#include "otk/batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define NOMINMAX
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+
+#include "otk/cli.hpp"
+#include "otk/converter.hpp"
+#include "otk/history.hpp"
+#include "otk/odb.hpp"
+#include "otk/output.hpp"
+#include "otk/trace.hpp"
+
+using namespace nlohmann;
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Match a file name against a pattern with * and ? wildcards
+//
+// ---------------------------------------------------------------------------------------
+static bool wildcard_match(const std::string &pattern, const std::string &name) {
+    size_t p = 0, n = 0;
+    size_t star = std::string::npos, resume = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p;
+            ++n;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = n;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            n = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Expand ODB file names, directories, glob patterns and list files
+//
+// ---------------------------------------------------------------------------------------
+std::vector<fs::path> expand_odb_files(const std::vector<std::string> &patterns,
+                                       const std::string &list_file) {
+    std::vector<std::string> entries = patterns;
+    if (!list_file.empty()) {
+        std::ifstream list_stream(list_file);
+        if (!list_stream) {
+            throw std::runtime_error(
+                fmt::format("Could not open list file {}.", list_file));
+        }
+        std::string line;
+        while (std::getline(list_stream, line)) {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty() && line[0] != '#') {
+                entries.push_back(line);
+            }
+        }
+    }
+
+    std::set<fs::path> files;
+    for (const auto &entry : entries) {
+        fs::path path{entry};
+        std::string name = path.filename().string();
+
+        if (name.find_first_of("*?") != std::string::npos) {
+            fs::path directory = path.has_parent_path() ? path.parent_path() : ".";
+            if (!fs::is_directory(directory)) {
+                continue;
+            }
+            for (const auto &item : fs::directory_iterator(directory)) {
+                if (item.is_regular_file() &&
+                    wildcard_match(name, item.path().filename().string())) {
+                    files.insert(fs::absolute(item.path()));
+                }
+            }
+        } else if (fs::is_directory(path)) {
+            for (const auto &item : fs::directory_iterator(path)) {
+                if (item.is_regular_file() && item.path().extension() == ".odb") {
+                    files.insert(fs::absolute(item.path()));
+                }
+            }
+        } else if (fs::is_regular_file(path)) {
+            files.insert(fs::absolute(path));
+        } else {
+            fmt::print("WARNING: Skipping {} ({}).\n", entry,
+                       fs::exists(path) ? "not a regular file" : "not found");
+        }
+    }
+    return {files.begin(), files.end()};
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Path of the running executable
+//
+//   argv[0] is only the command name when the executable was found through PATH, so
+//   the path comes from the system (/proc/self/exe, GetModuleFileNameW), then from a
+//   PATH lookup of argv[0].
+//
+// ---------------------------------------------------------------------------------------
+fs::path executable_path(const std::string &argv0) {
+    std::error_code error;
+#if defined(_WIN32) || defined(_WIN64)
+    std::wstring buffer(MAX_PATH, L'\0');
+    DWORD size = 0;
+    while ((size = GetModuleFileNameW(nullptr, buffer.data(),
+                                      static_cast<DWORD>(buffer.size()))) ==
+           buffer.size()) {
+        buffer.resize(2 * buffer.size());
+    }
+    if (size > 0) {
+        return fs::path{buffer.substr(0, size)};
+    }
+    const char separator = ';';
+    const std::vector<std::string> suffixes{"", ".exe"};
+#else
+    fs::path self = fs::read_symlink("/proc/self/exe", error);
+    if (!error) {
+        return self;
+    }
+    const char separator = ':';
+    const std::vector<std::string> suffixes{""};
+#endif
+
+    fs::path command{argv0};
+    if (command.has_parent_path()) {
+        return fs::absolute(command);
+    }
+    const char *search_path = std::getenv("PATH");
+    std::string directories = search_path ? search_path : "";
+    size_t start = 0;
+    while (start <= directories.size()) {
+        size_t end = directories.find(separator, start);
+        if (end == std::string::npos) {
+            end = directories.size();
+        }
+        const fs::path directory{directories.substr(start, end - start)};
+        for (const auto &suffix : suffixes) {
+            fs::path candidate = directory / (argv0 + suffix);
+            if (!directory.empty() && fs::is_regular_file(candidate, error)) {
+                return fs::absolute(candidate);
+            }
+        }
+        start = end + 1;
+    }
+    return fs::absolute(command);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Convert one ODB file with the JSON output request next to it
+//
+// ---------------------------------------------------------------------------------------
+void convert_file(const fs::path &file) {
+    Odb odb{file};
+
+    fs::path json_file = (fs::path{odb.path()} / odb.name()).replace_extension(".json");
+    json output_request = read_output_request(json_file);
+
+    // A "history" request extracts time histories instead of VTK frames
+    if (output_request.contains("history")) {
+        History history{output_request};
+        history.extract(odb, file);
+        return;
+    }
+
+    Converter converter{output_request};
+    converter.convert(odb, file);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Convert ODB files one after another in this process
+//
+// ---------------------------------------------------------------------------------------
+int convert_files(const std::vector<fs::path> &files, const fs::path &trace_file) {
+    Tracer &tracer = Tracer::instance();
+    tracer.set_recording(!trace_file.empty());
+
+    int failed = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        print_separator_2();
+        fmt::print("Converting {} ({}/{})\n", files[i].string(), i + 1, files.size());
+
+        tracer.clear_events();
+        try {
+            convert_file(files[i]);
+        } catch (const odb_Exception &odb_err) {
+            fmt::print("ERROR: {}\n", odb_err.AsString().CStr());
+            failed++;
+        } catch (const std::exception &err) {
+            fmt::print("ERROR: {}\n", err.what());
+            failed++;
+        }
+
+        if (!trace_file.empty()) {
+            fs::path file_trace = trace_file.parent_path() /
+                                  fmt::format("{}_{}{}", trace_file.stem().string(),
+                                              files[i].stem().string(),
+                                              trace_file.extension().string());
+            tracer.write_chrome_trace(file_trace);
+            fmt::print("Trace written to {}\n", file_trace.string());
+        }
+    }
+    tracer.clear_events();
+
+    print_separator_2();
+    fmt::print("Converted {} of {} ODB files\n", files.size() - failed, files.size());
+    tracer.print_summary();
+
+    return failed;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Id of this process
+//
+// ---------------------------------------------------------------------------------------
+static int process_id() {
+#if defined(_WIN32) || defined(_WIN64)
+    return _getpid();
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Spread ODB files over worker processes
+//
+//   The ODB API is not thread-safe, so parallelism comes from processes. Files are
+//   assigned largest first to the least loaded worker (by file size), and each worker
+//   is the same executable running "batch --jobs 1 --list <file>" with its output
+//   redirected to a log file, in a work directory of its own per run (removed when all
+//   workers succeed). Worker threads only wait on std::system. The trace file is
+//   passed on, so that each worker writes the traces of its files.
+//
+// ---------------------------------------------------------------------------------------
+int run_batch(const fs::path &executable, const std::vector<fs::path> &files, int jobs,
+              const fs::path &trace_file) {
+    jobs = std::clamp(jobs, 1, static_cast<int>(std::max<size_t>(files.size(), 1)));
+
+    std::vector<fs::path> sorted_files = files;
+    std::sort(sorted_files.begin(), sorted_files.end(),
+              [](const fs::path &a, const fs::path &b) {
+                  return fs::file_size(a) > fs::file_size(b);
+              });
+
+    std::vector<std::vector<fs::path>> assignments(jobs);
+    std::vector<uintmax_t> loads(jobs, 0);
+    for (const auto &file : sorted_files) {
+        size_t worker = std::min_element(loads.begin(), loads.end()) - loads.begin();
+        assignments[worker].push_back(file);
+        loads[worker] += fs::file_size(file);
+    }
+
+    // One work directory per run, so that concurrent batches keep their own lists
+    fs::path work_directory =
+        fs::temp_directory_path() / fmt::format("otk_batch_{}", process_id());
+    fs::create_directories(work_directory);
+
+    std::string trace_option;
+    if (!trace_file.empty()) {
+        trace_option = fmt::format(" --trace \"{}\"", fs::absolute(trace_file).string());
+    }
+
+    std::vector<fs::path> logs(jobs);
+    std::vector<int> status(jobs, 0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < jobs; ++i) {
+        fs::path list_file = work_directory / fmt::format("worker_{}.txt", i);
+        logs[i] = work_directory / fmt::format("worker_{}.log", i);
+
+        std::ofstream list_stream(list_file);
+        for (const auto &file : assignments[i]) {
+            list_stream << file.string() << "\n";
+        }
+        list_stream.close();
+
+        std::string command =
+            fmt::format("\"{}\" batch --jobs 1 --list \"{}\"{} > \"{}\" 2>&1",
+                        executable.string(), list_file.string(), trace_option,
+                        logs[i].string());
+#if defined(_WIN32) || defined(_WIN64)
+        command = fmt::format("\"{}\"", command);
+#endif
+
+        fmt::print("Worker {}: {} files ({})\n", i, assignments[i].size(),
+                   format_byte_size(loads[i]));
+        workers.emplace_back(
+            [&status, i, command]() { status[i] = std::system(command.c_str()); });
+    }
+
+    // A failed worker had at least one failed file; its log tells which
+    int failed = 0;
+    size_t converted = 0;
+    for (int i = 0; i < jobs; ++i) {
+        workers[i].join();
+        if (status[i] != 0) {
+            failed++;
+            fmt::print("Worker {} failed (log: {})\n", i, logs[i].string());
+        } else {
+            converted += assignments[i].size();
+            fmt::print("Worker {} finished\n", i);
+        }
+    }
+
+    // The lists and logs are only kept when they are needed to look into a failure
+    if (failed == 0) {
+        std::error_code error;
+        fs::remove_all(work_directory, error);
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("Converted {} of {} ODB files with {} workers in {:.1f} s\n", converted,
+               files.size(), jobs, elapsed.count());
+    if (failed > 0) {
+        fmt::print("{} of {} workers failed; see their logs for the files concerned\n",
+                   failed, jobs);
+    }
+
+    return failed;
+}
+
+}  // namespace otk
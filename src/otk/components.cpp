@@ -0,0 +1,69 @@
+#include "otk/components.hpp"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Component suffixes of each data type, in row order
+//
+// ---------------------------------------------------------------------------------------
+static std::vector<std::string> component_suffixes(DataType type) {
+    switch (type) {
+        case DataType::SCALAR:
+            return {""};
+        case DataType::VECTOR:
+            return {"1", "2", "3"};
+        case DataType::TENSOR_3D_FULL:
+            return {"11", "22", "33", "12", "13", "23"};
+        case DataType::TENSOR_3D_PLANAR:
+            return {"11", "22", "33", "12"};
+        case DataType::TENSOR_2D_PLANAR:
+            return {"11", "22", "12"};
+        default:
+            return {};
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Resolve the selectors of a field
+//
+// ---------------------------------------------------------------------------------------
+std::vector<ComponentSelector> resolve_components(const std::string& field,
+                                                  DataType type,
+                                                  const std::vector<std::string>& names) {
+    const bool tensor = type == DataType::TENSOR_3D_FULL ||
+                        type == DataType::TENSOR_3D_PLANAR ||
+                        type == DataType::TENSOR_2D_PLANAR;
+    const std::vector<std::string> suffixes = component_suffixes(type);
+
+    std::vector<ComponentSelector> selectors;
+    for (const auto& name : names) {
+        ComponentSelector selector{name};
+        if (name == "MAGNITUDE" && type == DataType::VECTOR) {
+            selector = {fmt::format("{}_{}", field, name), -1, Invariant::MAGNITUDE};
+        } else if (name == "MISES" && tensor) {
+            selector = {fmt::format("{}_{}", field, name), -1, Invariant::MISES};
+        } else if (name == "PRESS" && tensor) {
+            selector = {fmt::format("{}_{}", field, name), -1, Invariant::PRESS};
+        } else {
+            for (size_t i = 0; i < suffixes.size(); ++i) {
+                if (name == field + suffixes[i]) {
+                    selector.column = static_cast<int>(i);
+                }
+            }
+            if (selector.column < 0) {
+                throw std::runtime_error(fmt::format(
+                    "{} is not a component or invariant of {}.", name, field));
+            }
+        }
+        selectors.push_back(selector);
+    }
+    return selectors;
+}
+
+}  // namespace otk
@@ -2,32 +2,75 @@
 
 #include <fmt/format.h>
 
-#include <odb_API.h>
-
-#include <vtkInformation.h>
-#include <vtkPartitionedDataSet.h>
-#include <vtkPartitionedDataSetCollection.h>
-#include <vtkXMLPartitionedDataSetCollectionWriter.h>
+#include <vtkFieldData.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnsignedShortArray.h>
 #include <vtkXMLUnstructuredGridWriter.h>
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <regex>
 #include <set>
 #include <thread>
+#include <tuple>
 #include <vector>
 
+#include "otk/cli.hpp"
+#include "otk/parallel.hpp"
+#include "otk/trace.hpp"
+
 using namespace nlohmann;
 
 namespace otk {
 
+// Connectivity size assumed by the plan (linear hexahedra)
+constexpr size_t PLAN_NODES_PER_ELEMENT = 8;
+
+// Compression of the .vtu files when the request has none (same for both writers)
+constexpr const char* DEFAULT_VTK_COMPRESSION = "zlib";
+
+// ---------------------------------------------------------------------------------------
+//
+//   Output formats of the request ("format" is a name or a list of names)
+//
+// ---------------------------------------------------------------------------------------
+static std::set<std::string> requested_formats(const json& request) {
+    json formats = request.value("format", json("vtk"));
+    if (formats.is_string()) {
+        formats = json::array({formats});
+    }
+    return formats.get<std::set<std::string>>();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Output axes of vector and tensor results ("global" or {"axes": [x, y, z]} with the
+//   axes as global direction vectors)
+//
+// ---------------------------------------------------------------------------------------
+static Matrix3 requested_axes(const json& orientation) {
+    if (orientation.is_string()) {
+        return IDENTITY_AXES;
+    }
+    return make_axes(orientation["axes"].get<std::array<std::array<double, 3>, 3>>());
+}
+
 // ---------------------------------------------------------------------------------------
 //
 //   Convert ODB file to VTK format
 //
 // ---------------------------------------------------------------------------------------
-void Converter::convert(otk::Odb& odb, fs::path file) {
-    json field_summary = odb.field_summary(output_request_["frames"]);
-    json instance_summary = odb.instance_summary();
+void Converter::convert(otk::Source& source, fs::path file) {
+    ScopedTimer timer{"convert"};
+
+    json field_summary = source.field_summary(output_request_["frames"]);
 
     json output_summary = process_field_summary(field_summary);
     json matches = match_request_to_available_data(output_summary["available_frames"],
@@ -44,45 +87,148 @@ void Converter::convert(otk::Odb& odb, fs::path file) {
         }
     }
 
-    convert_mesh(odb);
-    convert_fields(odb, file, field_summary, instance_summary, output_summary, matches);
+    parse_derived_fields();
+    orientation_axes_.reset();
+    if (output_request_.contains("orientation")) {
+        orientation_axes_ = requested_axes(output_request_["orientation"]);
+    }
+    deformation_.reset();
+    if (output_request_.contains("deformed")) {
+        const json& deformed = output_request_["deformed"];
+        deformation_ = Deformation{deformed.value("field", "U"),
+                                   deformed.value("scale", 1.0)};
+    }
+
+    const std::set<std::string> formats = requested_formats(output_request_);
+    write_vtk_ = formats.contains("vtk");
+    write_npy_ = formats.contains("npy");
+    write_npz_ = formats.contains("npz");
+    if (formats.contains("ensight")) {
+        if (deformation_) {
+            fmt::print("WARNING: The EnSight case keeps the undeformed geometry.\n");
+        }
+        ensight_ = std::make_unique<EnsightWriter>(file.parent_path() / file.stem(),
+                                                   file.stem().string());
+    }
+    if (formats.contains("store")) {
+        fs::path directory = file.parent_path() / file.stem();
+        fs::create_directories(directory);
+        bool compress = output_request_.contains("store") &&
+                        output_request_["store"].value("compression", "none") == "zlib";
+        store_ = std::make_unique<StoreWriter>(
+            directory / fmt::format("{}.otks", file.stem().string()), compress);
+    }
+
+    sample_memory_phase("metadata");
+
+    convert_mesh(source);
+    sample_memory_phase("convert_mesh");
+    account_memory();
+    if (store_) {
+        write_store_mesh();
+    }
+    if (write_npy_) {
+        write_numpy_mesh(file, false);
+    }
+    if (write_npz_) {
+        write_numpy_mesh(file, true);
+    }
+    if (ensight_) {
+        write_ensight_geometry();
+    }
+
+    convert_fields(source, file, field_summary, instance_summary_, output_summary,
+                   matches);
+    if (store_) {
+        store_->close();
+        store_.reset();
+    }
+    if (ensight_) {
+        ensight_->close();
+        ensight_.reset();
+    }
+    report_memory();
 }
 
 // ---------------------------------------------------------------------------------------
 //
 //   Convert mesh data to VTK format
 //
+//   The elements of each instance are scanned once; the scan gives both the cells and
+//   the instance summary used by the field extraction.
+//
 // ---------------------------------------------------------------------------------------
-void Converter::convert_mesh(otk::Odb& odb) {
-    const odb_Assembly& root_assembly = odb.handle()->rootAssembly();
-    odb_InstanceRepositoryIT instance_iterator(root_assembly.instances());
+void Converter::convert_mesh(otk::Source& source) {
+    ScopedTimer timer{"convert_mesh"};
+
+    instance_summary_ = json::object();
 
-    for (instance_iterator.first(); !instance_iterator.isDone();
-         instance_iterator.next()) {
-        const odb_Instance& instance = instance_iterator.currentValue();
-        odb_Enum::odb_DimensionEnum instance_type = instance.embeddedSpace();
-        std::string instance_name{instance.name().cStr()};
+    for (const auto& instance_name : source.instance_names()) {
+        ScopedTimer instance_timer{"convert_instance_mesh",
+                                   [&] { return json{{"instance", instance_name}}; }};
 
         std::cout << fmt::format("Converting mesh data for {}...  ", instance_name);
         std::cout << std::flush;
 
-        const odb_SequenceNode& instance_nodes = instance.nodes();
-        const odb_SequenceElement& instance_elements = instance.elements();
+        Dimension instance_type = source.dimension(instance_name);
+        if (instance_type == Dimension::UNSUPPORTED) {
+            fmt::print("skipping (unsupported embedded space)\n");
+            continue;
+        }
+
+        ElementData instance_elements = source.elements(instance_name);
+        NodeData instance_nodes = source.nodes(instance_name);
+
+        if (output_request_.contains("region") &&
+            !select_region(source, instance_name, instance_elements, instance_nodes)) {
+            fmt::print("skipping (outside the region of interest)\n");
+            continue;
+        }
+        if (output_request_.contains("region")) {
+            // Nodal results are read for these nodes only, in every frame
+            std::vector<int>& region_nodes = region_nodes_[instance_name];
+            region_nodes = instance_nodes.labels;
+            std::sort(region_nodes.begin(), region_nodes.end());
+        }
 
-        std::set<VTKCellType> cell_types = get_cell_types(instance_elements);
-        if (cell_types.empty()) {
+        LabelIndex& node_map = node_map_[instance_name];
+        PointArray points = get_points(node_map, instance_nodes, instance_type);
+        ElementScan scan = scan_elements(instance_elements, &node_map);
+        if (scan.cell_types.empty()) {
+            node_map_.erase(instance_name);
             fmt::print("skipping (no supported elements found)\n");
             continue;
         }
+        for (const auto& element_type : scan.unsupported_types) {
+            fmt::print("WARNING: Element type {} is not supported.\n", element_type);
+            fmt::print("These elements will be ignored.\n");
+            fmt::print("This may lead to incorrect results.\n");
+        }
+
+        instance_summary_[instance_name] = scan_summary(scan);
+        points_[instance_name] = points;
+        node_labels_[instance_name] = instance_nodes.labels;
+        cells_[instance_name] = get_cells(scan, instance_name);
+        if (output_request_.value("mesh", "volume") == "surface") {
+            extract_surface(instance_name, instance_nodes);
+        }
+        if (const std::string curve = output_request_.value("reorder", "none");
+            curve != "none") {
+            reorder_instance(instance_name, curve);
+        }
 
-        std::unordered_map<int, vtkIdType> node_map;
-        points_[instance_name] = get_points(node_map, instance_nodes, instance_type);
-        cells_[instance_name] =
-            get_cells(node_map, instance_elements, instance_name, instance);
+        const json vtk_options = output_request_.value("vtk", json::object());
+        const int num_partitions = vtk_options.value("partitions", 1);
+        if (num_partitions > 1 && cells_[instance_name].first.size() >=
+                                      vtk_options.value("min_cells", size_t{100000})) {
+            partition_instance(instance_name, num_partitions);
+        }
 
         std::cout << fmt::format("done\n");
         std::cout << std::flush;
     }
+
+    share_topology();
 }
 
 // ---------------------------------------------------------------------------------------
@@ -90,26 +236,51 @@ void Converter::convert_mesh(otk::Odb& odb) {
 //   Convert field data to VTK format
 //
 // ---------------------------------------------------------------------------------------
-void Converter::convert_fields(otk::Odb& odb, fs::path file, json field_summary,
+void Converter::convert_fields(otk::Source& source, fs::path file, json field_summary,
                                json instance_summary, json output_summary, json matches) {
     std::cout << fmt::format("Started field data conversion.\n");
     std::cout << std::flush;
 
+    // EnSight times run on across steps (step times restart at zero)
+    double step_start_time = 0.0;
+    double frame_time = 0.0;
+
     for (auto& [step, step_data] : matches.items()) {
+        step_start_time = frame_time;
         for (auto& frame_data : step_data["frames"]) {
             int frame_id = frame_data.get<int>();
+            ScopedTimer frame_timer{"convert_frame", [&] {
+                return json{{"step", step}, {"frame", frame_id}};
+            }};
 
-            cell_data_.clear();
-            point_data_.clear();
-            field_outputs_.clear();
+            clear_field_data();
 
             std::cout << fmt::format("Converting field data for {} frame {}:\n", step,
                                      frame_id);
             std::cout << std::flush;
 
-            json field_data = load_field_data(odb, matches, step, frame_id);
-            extract_field_data(odb, field_data, instance_summary, step, frame_id);
-            write(file, frame_id);
+            json field_data = load_field_data(source, matches, step, frame_id);
+            extract_field_data(source, field_data, instance_summary, step, frame_id);
+            sample_memory_phase("extract_field_data");
+            account_memory();
+
+            if (write_vtk_) {
+                write(file, frame_id);
+            }
+            if (store_) {
+                write_store_frame(step, frame_id);
+            }
+            if (write_npy_) {
+                write_numpy_frame(file, frame_id, false);
+            }
+            if (write_npz_) {
+                write_numpy_frame(file, frame_id, true);
+            }
+            if (ensight_) {
+                frame_time = step_start_time + source.frame(step, frame_id).value;
+                write_ensight_frame(frame_time);
+            }
+            sample_memory_phase("write");
         }
     }
 
@@ -119,663 +290,2677 @@ void Converter::convert_fields(otk::Odb& odb, fs::path file, json field_summary,
 
 // ---------------------------------------------------------------------------------------
 //
-//   Write mesh data to VTU file
+//   Plan the conversion from the metadata only
+//
+//   Only the frame tables, the field output descriptions and the node and element
+//   counts are read. Sizes follow the converter's arrays: float32 points, 64-bit
+//   offsets and connectivity, int32 labels, and one field value per node (NODAL,
+//   ELEMENT_NODAL and INTEGRATION_POINT rows are averaged to the nodes) or per element
+//   (WHOLE_ELEMENT), stored as double or at the quantized width. The connectivity is
+//   estimated at PLAN_NODES_PER_ELEMENT nodes per element since counting it would read
+//   the elements. Regions of interest, surface output and compression are not taken
+//   into account, so the sizes are upper bounds for those requests.
 //
 // ---------------------------------------------------------------------------------------
-void Converter::write(fs::path file, int frame_id) {
-    auto writer = vtkSmartPointer<vtkXMLPartitionedDataSetCollectionWriter>::New();
-    auto collection = vtkSmartPointer<vtkPartitionedDataSetCollection>::New();
-
-    std::vector<std::string> instance_names = extract_keys(points_);
-    std::sort(instance_names.begin(), instance_names.end());
-
-    int instance_id = 0;
+json Converter::plan(otk::Source& source) {
+    ScopedTimer timer{"plan"};
 
-    std::cout << fmt::format("    - Writing frame...  ", frame_id);
-    std::cout << std::flush;
-
-    for (auto& instance_name : instance_names) {
-        auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
-        grid->SetPoints(points_[instance_name]);
-        grid->SetCells(cells_[instance_name].first.data(), cells_[instance_name].second);
+    json field_summary = source.field_summary(output_request_["frames"]);
+    json output_summary = process_field_summary(field_summary);
+    json matches = match_request_to_available_data(output_summary["available_frames"],
+                                                   output_summary["available_fields"]);
 
-        for (auto& cell_array : cell_data_[instance_name]) {
-            grid->GetCellData()->AddArray(cell_array);
+    // Mesh: converted arrays, plus the source node and element arrays of one instance
+    // while it is converted
+    json instances = json::object();
+    size_t num_points = 0;
+    size_t num_cells = 0;
+    size_t mesh_transient = 0;
+    for (const auto& instance_name : source.instance_names()) {
+        if (source.dimension(instance_name) == Dimension::UNSUPPORTED) {
+            continue;
         }
-        for (auto& point_array : point_data_[instance_name]) {
-            if (point_array->GetNumberOfComponents() == 3) {
-                grid->GetPointData()->SetVectors(point_array);
-            } else {
-                grid->GetPointData()->AddArray(point_array);
+        const size_t nodes = static_cast<size_t>(source.num_nodes(instance_name));
+        const size_t elements = static_cast<size_t>(source.num_elements(instance_name));
+        instances[instance_name] = {{"nodes", nodes}, {"elements", elements}};
+        num_points += nodes;
+        num_cells += elements;
+        mesh_transient =
+            std::max(mesh_transient, 16 * nodes + (16 + 4 * PLAN_NODES_PER_ELEMENT) *
+                                                      elements);
+    }
+    const size_t num_connectivity = PLAN_NODES_PER_ELEMENT * num_cells;
+    const size_t label_bytes = 4 * (num_points + num_cells);
+    const size_t mesh_bytes =
+        12 * num_points + 8 * (num_cells + num_connectivity) + label_bytes;
+    // Cell types, section groups, label vectors and dense label maps
+    const size_t mesh_memory =
+        mesh_bytes + 8 * num_cells + label_bytes + 8 * (num_points + num_cells);
+
+    // Frames: the field arrays of a frame are held until it is written; one field at a
+    // time also holds its source rows and its double precision array
+    std::map<std::pair<std::string, std::string>, FieldInfo> field_infos;
+    json work = json::array();
+    size_t num_frames = 0;
+    size_t field_bytes = 0;
+    size_t float_field_bytes = 0;
+    size_t frame_memory = 0;
+    for (const auto& [step, step_data] : matches.items()) {
+        for (const auto& frame_fields : step_data["fields"]) {
+            const int frame_id = frame_fields["frame"].get<int>();
+            ++num_frames;
+
+            size_t held = 0;
+            size_t transient = 0;
+            for (const auto& field_value : frame_fields.value("fields", json::array())) {
+                const auto field = field_value.get<std::string>();
+                auto it = field_infos.find({step, field});
+                if (it == field_infos.end()) {
+                    it = field_infos
+                             .emplace(std::make_pair(step, field),
+                                      source.field_info(step, frame_id, field))
+                             .first;
+                }
+                const FieldInfo& info = it->second;
+
+                const auto& components = get_requested_components(field);
+                const size_t num_components = !components.empty() ? components.size()
+                                              : info.type == DataType::SCALAR      ? 1
+                                              : info.type == DataType::VECTOR      ? 3
+                                              : info.type != DataType::UNSUPPORTED ? 6
+                                                                                   : 0;
+                auto stored_at = [&info](Position position) {
+                    return std::find(info.positions.begin(), info.positions.end(),
+                                     position) != info.positions.end();
+                };
+                const bool per_element = stored_at(Position::WHOLE_ELEMENT);
+                const bool nodal = !info.positions.empty() &&
+                                   std::all_of(info.positions.begin(),
+                                               info.positions.end(), [](Position p) {
+                                                   return p == Position::NODAL;
+                                               });
+                const size_t num_values =
+                    (per_element ? num_cells : num_points) * num_components;
+                const size_t num_rows = per_element ? num_cells
+                                        : nodal     ? num_points
+                                                    : num_connectivity;
+
+                const int bits = get_quantization_bits(field);
+                const size_t bytes = num_values * (bits > 0 ? bits / 8 : sizeof(double));
+
+                json entry{{"step", step},
+                           {"frame", frame_id},
+                           {"field", field},
+                           {"values", num_values},
+                           {"bytes", bytes}};
+                if (num_components == 0) {
+                    entry["skipped"] = "unsupported data type";
+                }
+                work.push_back(entry);
+
+                field_bytes += bytes;
+                float_field_bytes += num_values * sizeof(float);
+                held += bytes;
+                const size_t width = static_cast<size_t>(std::max(info.width, 1));
+                transient = std::max(transient, num_rows * width * sizeof(float) +
+                                                    num_values * sizeof(double));
             }
+            frame_memory = std::max(frame_memory, held + transient);
         }
-
-        collection->SetPartition(instance_id, 0, grid);
-        collection->GetMetaData(instance_id)
-            ->Set(vtkCompositeDataSet::NAME(), instance_name);
-        instance_id++;
     }
 
-    writer->SetFileName(fmt::format("{}/{}/{}_{}.vtpc", file.parent_path().string(),
-                                    file.stem().string(), file.stem().string(), frame_id)
-                            .c_str());
-    writer->SetInputData(collection);
-    writer->Write();
-
-    std::cout << fmt::format("done\n");
-    std::cout << std::flush;
-}
-
-// ---------------------------------------------------------------------------------------
-//
-//   Get the base element type without derivatives
-//
-// ---------------------------------------------------------------------------------------
-std::string Converter::get_base_element_type(const std::string& element_type) {
-    std::vector<std::string> supported_elements = extract_keys(ABQ_VTK_CELL_MAP);
-    for (auto supported_element : supported_elements) {
-        if (element_type.rfind(supported_element, 0) != std::string::npos) {
-            return supported_element;
+    // Output files: VTK repeats the mesh in every frame (plus uint8 cell types), the
+    // store and NumPy files write it once (int32 cell types), EnSight writes it once
+    // with 32-bit connectivity and float32 fields
+    const std::set<std::string> formats = requested_formats(output_request_);
+    json outputs = json::object();
+    if (formats.contains("vtk")) {
+        outputs["vtk"] = num_frames * (mesh_bytes + num_cells) + field_bytes;
+    }
+    // Deformed coordinates add float32 points to every frame of the other formats
+    const size_t coordinate_bytes =
+        output_request_.contains("deformed") ? num_frames * 12 * num_points : 0;
+    for (const char* format : {"store", "npy", "npz"}) {
+        if (formats.contains(format)) {
+            outputs[format] = mesh_bytes + 4 * num_cells + field_bytes + coordinate_bytes;
         }
     }
-    return "Unsupported";
+    if (formats.contains("ensight")) {
+        outputs["ensight"] =
+            12 * num_points + 4 * num_connectivity + label_bytes + float_field_bytes;
+    }
+    size_t total_bytes = 0;
+    for (const auto& [format, bytes] : outputs.items()) {
+        total_bytes += bytes.get<size_t>();
+    }
+    const size_t peak_memory = mesh_memory + std::max(mesh_transient, frame_memory);
+
+    print_separator_2();
+    print_title("Conversion plan");
+    print_separator_2();
+    fmt::print("Instances: {} ({} nodes, {} elements)\n", instances.size(), num_points,
+               num_cells);
+    fmt::print("Frames: {} ({} field conversions)\n", num_frames, work.size());
+    for (const auto& [format, bytes] : outputs.items()) {
+        fmt::print(".. {}: {}\n", format, format_byte_size(bytes.get<size_t>()));
+    }
+    fmt::print("Total output size: {}\n", format_byte_size(total_bytes));
+    fmt::print("Estimated peak memory: {}\n", format_byte_size(peak_memory));
+
+    return {{"instances", instances},
+            {"frames", num_frames},
+            {"outputs", outputs},
+            {"total_output_bytes", total_bytes},
+            {"mesh_memory_bytes", mesh_memory},
+            {"peak_memory_bytes", peak_memory},
+            {"nodes_per_element", PLAN_NODES_PER_ELEMENT},
+            {"work", work}};
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Get the cell types from an element sequence
+//   Compute the cached ranges of the arrays of a grid
+//
+//   The XML writer reads RangeMin/RangeMax with GetRange(), which stores the range in
+//   the information of the array. Arrays shared between grids (quantization
+//   parameters, shared cell arrays) would be written to by concurrent writers, so the
+//   ranges are computed here, serially, and the writers only read them.
 //
 // ---------------------------------------------------------------------------------------
-std::set<VTKCellType> Converter::get_cell_types(
-    const odb_SequenceElement& element_sequence) {
-    std::set<VTKCellType> cell_types;
-    int num_elements = element_sequence.size();
-    for (int i = 0; i < num_elements; ++i) {
-        const odb_Element& element = element_sequence[i];
-        std::string element_type = get_base_element_type(element.type().CStr());
-
-        if (element_type == "Unsupported") {
-            continue;
+static void compute_ranges(vtkUnstructuredGrid* grid) {
+    auto compute = [](vtkDataArray* array) {
+        if (!array) {
+            return;
         }
-
-        cell_types.insert(ABQ_VTK_CELL_MAP.at(element_type));
-    }
-    return cell_types;
+        for (int component = -1; component < array->GetNumberOfComponents();
+             ++component) {
+            array->GetRange(component);
+        }
+    };
+    auto compute_all = [&](vtkFieldData* data) {
+        for (int i = 0; i < data->GetNumberOfArrays(); ++i) {
+            compute(data->GetArray(i));
+        }
+    };
+
+    compute(grid->GetPoints()->GetData());
+    compute(grid->GetCells()->GetOffsetsArray());
+    compute(grid->GetCells()->GetConnectivityArray());
+    compute_all(grid->GetPointData());
+    compute_all(grid->GetCellData());
+    compute_all(grid->GetFieldData());
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Get vtkCellArrays from an element sequence
+//   Write mesh data to VTU files
+//
+//   Same layout as vtkXMLPartitionedDataSetCollectionWriter (<odb>/<odb>_<frame>.vtpc
+//   listing <odb>/<odb>_<frame>/<odb>_<frame>_<i>_0.vtu), but the partitions are
+//   written concurrently by one vtkXMLUnstructuredGridWriter each. The array ranges
+//   are computed before, since the grids share arrays.
 //
 // ---------------------------------------------------------------------------------------
-Converter::CellArrayPair Converter::get_cells(
-    const std::unordered_map<int, vtkIdType>& node_map,
-    const odb_SequenceElement& element_sequence, const std::string& instance_name,
-    const odb_Instance& instance) {
-    CellArrayPair cells;
-
-    int num_elements = element_sequence.size();
-    int num_nodes = 0;
-
-    ElementLabelMap element_labels;
-
-    cells.second = vtkSmartPointer<vtkCellArray>::New();
-    cells.first.reserve(num_elements);
+void Converter::write(fs::path file, int frame_id) {
+    ScopedTimer timer{"write", [&] { return json{{"frame", frame_id}}; }};
 
-    for (int i = 0; i < num_elements; ++i) {
-        const odb_Element& element = element_sequence[i];
-        int element_label = element.label();
-        std::string raw_type{element.type().CStr()};
-        std::string element_type = get_base_element_type(raw_type);
-        std::string section_category{element.sectionCategory().name().CStr()};
-        std::string key = fmt::format("{} {}", section_category, raw_type);
-        int cell_type;
+    const json vtk_options = output_request_.value("vtk", json::object());
+    if (vtk_options.value("writer", "vtk") == "native") {
+        write_native(file, frame_id);
+        return;
+    }
 
-        if (element_type != "Unsupported") {
-            cell_type = static_cast<int>(ABQ_VTK_CELL_MAP.at(element_type));
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
 
-            const int* const element_connectivity = element.connectivity(num_nodes);
+    std::cout << fmt::format("    - Writing frame...  ", frame_id);
+    std::cout << std::flush;
 
-            std::vector<vtkIdType> connectivity(num_nodes);
-            for (int j = 0; j < num_nodes; ++j) {
-                connectivity[j] = node_map.at(element_connectivity[j]);
+    const std::string compression =
+        vtk_options.value("compression", DEFAULT_VTK_COMPRESSION);
+    const std::string name = fmt::format("{}_{}", file.stem().string(), frame_id);
+    const fs::path directory = file.parent_path() / file.stem();
+    fs::create_directories(directory / name);
+
+    std::vector<vtkSmartPointer<vtkXMLUnstructuredGridWriter>> writers;
+    std::vector<std::pair<std::string, std::vector<std::string>>> datasets;
+    for (size_t i = 0; i < instance_names.size(); ++i) {
+        const std::string& instance_name = instance_names[i];
+        std::vector<std::string>& vtu_files =
+            datasets.emplace_back(instance_name, std::vector<std::string>{}).second;
+
+        std::vector<FramePiece> pieces = get_frame_pieces(instance_name);
+        for (size_t j = 0; j < pieces.size(); ++j) {
+            const FramePiece& piece = pieces[j];
+
+            auto grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+            grid->SetPoints(piece.points);
+            grid->SetCells(piece.cells->first.data(), piece.cells->second);
+
+            for (auto& cell_array : piece.cell_data) {
+                grid->GetCellData()->AddArray(cell_array);
             }
-
-            cells.first.push_back(cell_type);
-            cells.second->InsertNextCell(num_nodes, connectivity.data());
-
-            if (!section_elements_[instance_name].contains(key)) {
-                odb_SequenceElement temp(instance);
-                temp.append(element);
-                section_elements_[instance_name][key] = temp;
-            } else {
-                section_elements_[instance_name][key].append(element);
+            for (auto& point_array : piece.point_data) {
+                if (point_array->GetNumberOfComponents() == 3) {
+                    grid->GetPointData()->SetVectors(point_array);
+                } else {
+                    grid->GetPointData()->AddArray(point_array);
+                }
             }
-            element_labels[element_label] = i;
-
-        } else {
-            fmt::print("WARNING: Element type {} is not supported.\n", element_type);
-            fmt::print("This element will be ignored.\n");
-            fmt::print("This may lead to incorrect results.\n");
+            for (auto& quantization : quantization_data_[instance_name]) {
+                grid->GetFieldData()->AddArray(quantization);
+            }
+            compute_ranges(grid);
+
+            std::string vtu_file = fmt::format("{}/{}_{}_{}.vtu", name, name, i, j);
+            auto writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
+            if (compression == "none") {
+                writer->SetCompressorTypeToNone();
+            } else if (compression == "lz4") {
+                writer->SetCompressorTypeToLZ4();
+            } else if (compression == "lzma") {
+                writer->SetCompressorTypeToLZMA();
+            }
+            writer->SetFileName((directory / vtu_file).string().c_str());
+            writer->SetInputData(grid);
+            writers.push_back(writer);
+            vtu_files.push_back(vtu_file);
         }
     }
 
-    element_map_[instance_name] = element_labels;
+    // The partitions are independent files: write them concurrently, then the index
+    parallel_for(writers.size(), thread_count(vtk_options.value("threads", 0)),
+                 [&](size_t i, int) {
+                     if (writers[i]->Write() == 0) {
+                         throw std::runtime_error(fmt::format(
+                             "Could not write {}.", writers[i]->GetFileName()));
+                     }
+                 });
+    write_vtpc(directory / (name + ".vtpc"), datasets);
 
-    return cells;
+    std::cout << fmt::format("done\n");
+    std::cout << std::flush;
 }
 
-// -----------------------------------------------------------------------------------
+// ---------------------------------------------------------------------------------------
 //
-//   Get vtkPoints from a node sequence
+//   Write mesh and field data with the native VTK XML writer
 //
-// -----------------------------------------------------------------------------------
-Converter::PointArray Converter::get_points(std::unordered_map<int, vtkIdType>& node_map,
-                                            const odb_SequenceNode& node_sequence,
-                                            odb_Enum::odb_DimensionEnum instance_type) {
-    auto points = vtkSmartPointer<vtkPoints>::New();
+//   Produces the same file layout as write() in raw appended-binary form, written
+//   straight from the converter's arrays. The threads are shared between the
+//   partitions, which are written concurrently, and the block compression of each.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::write_native(fs::path file, int frame_id) {
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
 
-    int num_nodes = node_sequence.size();
-    for (int i = 0; i < num_nodes; ++i) {
-        const odb_Node& node = node_sequence[i];
-        int node_label = node.label();
-        const float* const node_coordinates = node.coordinates();
+    std::cout << fmt::format("    - Writing frame...  ");
+    std::cout << std::flush;
 
-        if (instance_type == odb_Enum::THREE_D) {
-            node_map[node_label] = points->InsertNextPoint(node_coordinates);
-        } else if ((instance_type == odb_Enum::TWO_D_PLANAR) ||
-                   (instance_type == odb_Enum::AXISYMMETRIC)) {
-            node_map[node_label] =
-                points->InsertNextPoint(node_coordinates[0], node_coordinates[1], 0.0);
+    std::vector<FramePiece> frame_pieces;
+    std::vector<std::pair<std::string, std::vector<std::string>>> datasets;
+    std::vector<std::string> vtu_files;
+    std::vector<const FieldDataArray*> field_data;
+
+    const std::string name = fmt::format("{}_{}", file.stem().string(), frame_id);
+    for (size_t i = 0; i < instance_names.size(); ++i) {
+        const std::string& instance_name = instance_names[i];
+        std::vector<std::string>& files =
+            datasets.emplace_back(instance_name, std::vector<std::string>{}).second;
+
+        for (auto& piece : get_frame_pieces(instance_name)) {
+            std::string vtu_file =
+                fmt::format("{}/{}_{}_{}.vtu", name, name, i, files.size());
+            files.push_back(vtu_file);
+            vtu_files.push_back(vtu_file);
+            field_data.push_back(&quantization_data_[instance_name]);
+            frame_pieces.push_back(std::move(piece));
         }
     }
 
-    return points;
-}
-
-// ---------------------------------------------------------------------------------------
-//
-//   Process summary JSON from Odb class
-//
-// ---------------------------------------------------------------------------------------
-json Converter::process_field_summary(const json& summary) {
-    json frame_numbers;
-    json field_names;
-
-    std::cout << fmt::format("Processing ODB field summary...  ");
-    std::cout << std::flush;
+    const json vtk_options = output_request_.value("vtk", json::object());
+    const int num_threads = thread_count(vtk_options.value("threads", 0));
+    const int num_writers =
+        std::clamp(static_cast<int>(frame_pieces.size()), 1, num_threads);
 
-    for (const auto& step : summary["steps"]) {
-        auto step_name = step["name"].template get<std::string>();
-        for (const auto& frame : step["frames"]) {
-            auto frame_number = frame["index"].template get<int>();
-            frame_numbers[step_name].push_back(frame_number);
-            for (const auto& field : frame["fields"]) {
-                auto field_name = field["name"].template get<std::string>();
-                field_names[step_name][std::to_string(frame_number)].push_back(
-                    field_name);
-            }
+    VtuCompression compression;
+    compression.compressor = vtk_options.value("compression", DEFAULT_VTK_COMPRESSION);
+    if (compression.compressor == "none") {
+        compression.compressor.clear();
+    }
+    compression.threads = std::max(1, num_threads / num_writers);
+
+    const fs::path directory = file.parent_path() / file.stem();
+    fs::create_directories(directory / name);
+
+    std::vector<VtuPiece> pieces(frame_pieces.size());
+    for (size_t i = 0; i < frame_pieces.size(); ++i) {
+        const FramePiece& frame_piece = frame_pieces[i];
+
+        VtuPiece& piece = pieces[i];
+        piece.points = frame_piece.points->GetData();
+        piece.offsets = frame_piece.cells->second->GetOffsetsArray();
+        piece.connectivity = frame_piece.cells->second->GetConnectivityArray();
+        piece.types = frame_piece.cells->first.data();
+        piece.num_cells = frame_piece.cells->first.size();
+        for (const auto& array : frame_piece.point_data) {
+            piece.point_data.push_back(array);
+        }
+        for (const auto& array : frame_piece.cell_data) {
+            piece.cell_data.push_back(array);
+        }
+        for (const auto& array : *field_data[i]) {
+            piece.field_data.push_back(array);
         }
     }
-    json output;
-    output["available_frames"] = frame_numbers;
-    output["available_fields"] = field_names;
+
+    parallel_for(pieces.size(), num_writers, [&](size_t i, int) {
+        write_vtu(directory / vtu_files[i], pieces[i], compression);
+    });
+    write_vtpc(directory / (name + ".vtpc"), datasets);
 
     std::cout << fmt::format("done\n");
     std::cout << std::flush;
-
-    return output;
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Match output request to available data
+//   Write the mesh of each instance to the OTK frame store
+//
+//   The points, cell offsets, connectivity and VTK cell types are stored as they are
+//   handed to vtkUnstructuredGrid, so a reader can rebuild the grid without copies.
 //
 // ---------------------------------------------------------------------------------------
-json Converter::match_request_to_available_data(const json& frames, const json& fields) {
-    json matches;
+void Converter::write_store_mesh() {
+    ScopedTimer timer{"write_store_mesh"};
 
-    std::cout << fmt::format("Matching output request to available data...  ");
-    std::cout << std::flush;
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
 
-    // Get all the field names
-    json fields_request = output_request_["fields"];
-    std::vector<std::string> fields_requested;
-    for (const auto& field_info : fields_request) {
-        fields_requested.push_back(field_info["key"].template get<std::string>());
-    }
+    // Chunk ids of the offsets, connectivity and types of each cell array written
+    std::unordered_map<const vtkCellArray*, std::array<size_t, 3>> topology_chunks;
 
-    // Get all the frame numbers and match them to the available frames and fields
-    json frames_request = output_request_["frames"];
-    for (const auto& frame_info : frames_request) {
-        auto step_name = frame_info["step"].template get<std::string>();
-        auto frame_list = frame_info["list"].template get<std::vector<int>>();
-        std::sort(frame_list.begin(), frame_list.end());
+    for (const auto& instance_name : instance_names) {
+        const CellArrayPair& cells = cells_[instance_name];
+        json entry{{"kind", "mesh"}, {"instance", instance_name}};
 
-        // Intersect the requested frames with the available frames
-        std::vector<int> frame_matches;
-        std::set_intersection(frame_list.begin(), frame_list.end(),
-                              frames[step_name].begin(), frames[step_name].end(),
-                              std::back_inserter(frame_matches));
+        entry["name"] = "points";
+        store_->write(entry, points_[instance_name]->GetData());
 
-        // Regex match the requested fields with the available fields
-        json field_matches;
-        for (const auto& frame : frame_matches) {
-            json field_matches_frame;
-            field_matches_frame["frame"] = frame;
-            for (const auto& request : fields_requested) {
-                std::regex regex(request);
-                const auto& field_names = fields[step_name][std::to_string(frame)]
-                                              .template get<std::vector<std::string>>();
-                for (const auto& field_name : field_names) {
-                    if (std::regex_match(field_name, regex)) {
-                        field_matches_frame["fields"].push_back(field_name);
-                    }
-                }
-            }
-            field_matches.push_back(field_matches_frame);
+        auto shared = topology_chunks.find(cells.second.Get());
+        if (shared != topology_chunks.end()) {
+            entry["name"] = "offsets";
+            store_->link(entry, shared->second[0]);
+            entry["name"] = "connectivity";
+            store_->link(entry, shared->second[1]);
+            entry["name"] = "types";
+            store_->link(entry, shared->second[2]);
+            continue;
         }
-        matches[step_name]["fields"] = field_matches;
-        matches[step_name]["frames"] = frame_matches;
-    }
-
-    std::cout << fmt::format("done\n");
-    std::cout << std::flush;
-
-    // std::cout << "\nframes:\n" << frames.dump(2) << "\n\n" << std::flush;
-    // std::cout << "\nfields:\n" << fields.dump(2) << "\n\n" << std::flush;
-    // std::cout << "\nmatches\n" << matches.dump(2) << "\n\n" << std::flush;
 
-    return matches;
+        std::array<size_t, 3>& chunks = topology_chunks[cells.second.Get()];
+        entry["name"] = "offsets";
+        chunks[0] = store_->write(entry, cells.second->GetOffsetsArray());
+        entry["name"] = "connectivity";
+        chunks[1] = store_->write(entry, cells.second->GetConnectivityArray());
+        entry["name"] = "types";
+        chunks[2] =
+            store_->write(entry, "int32", cells.first.size(), 1, cells.first.data());
+    }
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Load field data from Odb class
+//   Write the field arrays of a frame to the OTK frame store
+//
+//   Quantized arrays keep their integer type; their offset and scale are stored in the
+//   chunk entry.
 //
 // ---------------------------------------------------------------------------------------
-json Converter::load_field_data(otk::Odb& odb, const json& request,
-                                const std::string& step_name, int frame_id) {
-    json data;
-
-    std::cout << fmt::format("    - Loading field data...  ");
-    std::cout << std::flush;
-
-    json frame_data;
+void Converter::write_store_frame(const std::string& step_name, int frame_id) {
+    ScopedTimer timer{"write_store_frame",
+                      [&] { return json{{"step", step_name}, {"frame", frame_id}}; }};
 
-    const odb_Step& step_obj = odb.handle()->steps().constGet(step_name.c_str());
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
 
-    const auto& fields_request = request[step_name]["fields"];
-    for (const auto& field_info : fields_request) {
-        int frame = field_info["frame"].get<int>();
-        if (frame != frame_id) {
-            continue;
+    for (const auto& instance_name : instance_names) {
+        auto write_arrays = [&](const auto& arrays, const char* kind) {
+            for (const auto& array : arrays) {
+                std::string field_name{array->GetName()};
+                json entry{{"kind", kind},
+                           {"step", step_name},
+                           {"frame", frame_id},
+                           {"instance", instance_name},
+                           {"name", field_name}};
+                if (auto* parameters = get_quantization(instance_name, field_name)) {
+                    entry["quantization"] = {{"offset", parameters->GetValue(0)},
+                                             {"scale", parameters->GetValue(1)}};
+                }
+                store_->write(entry, array);
+            }
+        };
+        write_arrays(point_data_[instance_name], "point");
+        write_arrays(cell_data_[instance_name], "cell");
+        if (auto deformed = deformed_points_.find(instance_name);
+            deformed != deformed_points_.end()) {
+            store_->write({{"kind", "coordinates"},
+                           {"step", step_name},
+                           {"frame", frame_id},
+                           {"instance", instance_name},
+                           {"name", "points"}},
+                          deformed->second->GetData());
         }
+    }
+}
 
-        auto fields = field_info["fields"].get<std::vector<std::string>>();
-        frame_data["frame"] = frame;
+// ---------------------------------------------------------------------------------------
+//
+//   Replace the characters of a name that are not safe in file names
+//
+// ---------------------------------------------------------------------------------------
+static std::string file_safe_name(std::string name) {
+    std::replace_if(
+        name.begin(), name.end(),
+        [](unsigned char c) { return !std::isalnum(c) && c != '-' && c != '_'; }, '_');
+    return name;
+}
 
-        const odb_Frame& frame_obj = step_obj.frames().constGet(frame);
-        const odb_FieldOutputRepository& fields_repo = frame_obj.fieldOutputs();
+// ---------------------------------------------------------------------------------------
+//
+//   Write the mesh of each instance as NumPy arrays
+//
+//   <odb>/<odb>_mesh/<instance>/{points, offsets, connectivity, types, node_labels,
+//   element_labels}.npy, or the same members in <odb>/<odb>_mesh.npz. The arrays are
+//   written straight from the VTK buffers.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::write_numpy_mesh(fs::path file, bool npz) {
+    ScopedTimer timer{"write_numpy_mesh", [&] { return json{{"npz", npz}}; }};
 
-        for (const auto& field : fields) {
-            field_outputs_.push_back(std::move(fields_repo.constGet(field.c_str())));
-            frame_data["fields"][field] = field_outputs_.size() - 1;
-        }
-    }
-    data[step_name] = frame_data;
+    std::string stem = file.stem().string();
+    // Built as strings: ODB names may contain dots, which replace_extension would cut
+    const fs::path path = file.parent_path() / stem /
+                          fmt::format("{}_mesh{}", stem, npz ? ".npz" : "");
+    NumpyWriter writer{path, npz};
 
-    std::cout << fmt::format("done\n");
-    std::cout << std::flush;
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
 
-    return data;
+    for (const auto& instance_name : instance_names) {
+        const std::string prefix = file_safe_name(instance_name) + "/";
+        const CellArrayPair& cells = cells_[instance_name];
+        const std::vector<int>& node_labels = node_labels_[instance_name];
+        std::vector<int> element_labels = get_cell_labels(instance_name);
+
+        writer.write(prefix + "points", points_[instance_name]->GetData());
+        writer.write(prefix + "offsets", cells.second->GetOffsetsArray());
+        writer.write(prefix + "connectivity", cells.second->GetConnectivityArray());
+        writer.write(prefix + "types", "int32", cells.first.size(), 1,
+                     cells.first.data());
+        writer.write(prefix + "node_labels", "int32", node_labels.size(), 1,
+                     node_labels.data());
+        writer.write(prefix + "element_labels", "int32", element_labels.size(), 1,
+                     element_labels.data());
+    }
+    writer.close();
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Extract field data from Odb class
+//   Write the field arrays of a frame as NumPy arrays
+//
+//   <odb>/<odb>_<frame>/<instance>/<field>.npy, or the same members in
+//   <odb>/<odb>_<frame>.npz. Quantized fields come with their <field>_quantization
+//   [offset, scale] array.
 //
 // ---------------------------------------------------------------------------------------
-void Converter::extract_field_data(otk::Odb& odb, const json& data,
-                                   const json& instance_summary,
-                                   const std::string& step_name, int frame_id) {
-    odb_Assembly& root_assembly = odb.handle()->rootAssembly();
-    odb_InstanceRepositoryIT it(root_assembly.instances());
+void Converter::write_numpy_frame(fs::path file, int frame_id, bool npz) {
+    ScopedTimer timer{"write_numpy_frame",
+                      [&] { return json{{"frame", frame_id}, {"npz", npz}}; }};
 
-    for (it.first(); !it.isDone(); it.next()) {
-        std::string instance_name{it.currentValue().name().cStr()};
+    std::string stem = file.stem().string();
+    const fs::path path = file.parent_path() / stem /
+                          fmt::format("{}_{}{}", stem, frame_id, npz ? ".npz" : "");
+    NumpyWriter writer{path, npz};
 
-        bool supported = instance_summary[instance_name]["supported"].get<bool>();
-        if (!supported) {
-            fmt::print("Instance {} is not supported.\n", instance_name);
-            fmt::print("This instance will be ignored.\n");
-            fmt::print(
-                "The instance has more than one section,"
-                " but they are of different types.\n{}\n",
-                instance_summary[instance_name]["section_categories"].dump(2));
-            continue;
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
+
+    for (const auto& instance_name : instance_names) {
+        const std::string prefix = file_safe_name(instance_name) + "/";
+        for (const auto& array : point_data_[instance_name]) {
+            writer.write(prefix + file_safe_name(array->GetName()), array);
+        }
+        for (const auto& array : cell_data_[instance_name]) {
+            writer.write(prefix + file_safe_name(array->GetName()), array);
+        }
+        for (const auto& array : quantization_data_[instance_name]) {
+            writer.write(prefix + file_safe_name(array->GetName()), array);
         }
+        if (auto deformed = deformed_points_.find(instance_name);
+            deformed != deformed_points_.end()) {
+            writer.write(prefix + "points", deformed->second->GetData());
+        }
+    }
+    writer.close();
+}
 
-        bool composite = instance_summary[instance_name]["composite"].get<bool>();
-        extract_instance_field_data(odb, data,
-                                    root_assembly.instances().get(it.currentKey()),
-                                    composite, step_name, frame_id);
+// ---------------------------------------------------------------------------------------
+//
+//   Write the mesh of each instance to the EnSight geometry file
+//
+// ---------------------------------------------------------------------------------------
+void Converter::write_ensight_geometry() {
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
+
+    std::vector<std::vector<int>> element_labels;
+    element_labels.reserve(instance_names.size());
+    std::vector<EnsightWriter::Part> parts;
+    for (const auto& instance_name : instance_names) {
+        const CellArrayPair& cells = cells_[instance_name];
+        element_labels.push_back(get_cell_labels(instance_name));
+
+        vtkPoints* points = points_[instance_name];
+        EnsightWriter::Part part;
+        part.name = instance_name;
+        part.points = static_cast<const float*>(points->GetVoidPointer(0));
+        part.num_points = static_cast<size_t>(points->GetNumberOfPoints());
+        part.offsets = static_cast<const vtkIdType*>(
+            cells.second->GetOffsetsArray()->GetVoidPointer(0));
+        part.connectivity = static_cast<const vtkIdType*>(
+            cells.second->GetConnectivityArray()->GetVoidPointer(0));
+        part.types = cells.first.data();
+        part.num_cells = cells.first.size();
+        part.node_labels = node_labels_[instance_name].data();
+        part.element_labels = element_labels.back().data();
+        parts.push_back(std::move(part));
     }
+    ensight_->write_geometry(parts);
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Extract field data from Instance
+//   Write the field arrays of a frame to EnSight variable files
 //
 // ---------------------------------------------------------------------------------------
-void Converter::extract_instance_field_data(otk::Odb& odb, const json& data,
-                                            odb_Instance& instance, bool composite,
-                                            const std::string& step_name, int frame_id) {
-    std::cout << fmt::format("    - Filtering {} elements and sections... ",
-                             instance.name().cStr());
-    std::cout << std::flush;
+void Converter::write_ensight_frame(double time) {
+    std::vector<std::string> instance_names = extract_keys(points_);
+    std::sort(instance_names.begin(), instance_names.end());
 
-    std::vector<odb_Set> element_sets;
-    for (const auto& [key, elements] : section_elements_[instance.name().cStr()]) {
-        const odb_String set_name{key.c_str()};
-        odb_Set set;
-        if (instance.elementSets().isMember(set_name) == false) {
-            set = instance.ElementSet(set_name, elements);
-        } else {
-            set = instance.elementSets().get(set_name);
-        }
-        element_sets.push_back(set);
+    std::map<std::string, std::vector<EnsightWriter::Variable>> variables;
+    for (size_t part = 0; part < instance_names.size(); ++part) {
+        const std::string& instance_name = instance_names[part];
+
+        auto add_arrays = [&](const auto& arrays, bool per_node) {
+            for (const auto& array : arrays) {
+                std::string field_name{array->GetName()};
+                EnsightWriter::Variable variable{part, array, per_node};
+                if (auto* parameters = get_quantization(instance_name, field_name)) {
+                    variable.offset = parameters->GetValue(0);
+                    variable.scale = parameters->GetValue(1);
+                }
+                variables[field_name].push_back(variable);
+            }
+        };
+        add_arrays(point_data_[instance_name], true);
+        add_arrays(cell_data_[instance_name], false);
     }
+    ensight_->write_frame(time, variables);
+}
 
-    std::cout << fmt::format("done\n");
-    std::cout << std::flush;
+// ---------------------------------------------------------------------------------------
+//
+//   Element label of each output cell (surface faces get the label of their cell)
+//
+// ---------------------------------------------------------------------------------------
+std::vector<int> Converter::get_cell_labels(const std::string& instance_name) {
+    const std::vector<int>& element_labels = element_labels_[instance_name];
 
-    std::cout << fmt::format("    - Processing {}... ", instance.name().cStr());
-    std::cout << std::flush;
+    auto faces = surface_faces_.find(instance_name);
+    if (faces == surface_faces_.end()) {
+        return element_labels;
+    }
 
-    for (auto& [field, field_data] : data[step_name]["fields"].items()) {
-        int field_id = field_data.get<int>();
-        const odb_FieldOutput& field_output = field_outputs_[field_id];
-        const odb_FieldOutput& instance_field = field_output.getSubset(instance);
-        if (instance_field.locations().size() == 0) {
-            continue;
+    std::vector<int> face_labels;
+    face_labels.reserve(faces->second.size());
+    for (const auto& cell : faces->second) {
+        face_labels.push_back(element_labels[cell]);
+    }
+    return face_labels;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Quantization parameters (offset, scale) of a field array of the frame
+//
+// ---------------------------------------------------------------------------------------
+vtkDoubleArray* Converter::get_quantization(const std::string& instance_name,
+                                            const std::string& field_name) {
+    const std::string name = field_name + "_quantization";
+    for (const auto& parameters : quantization_data_[instance_name]) {
+        if (name == parameters->GetName()) {
+            return parameters;
         }
+    }
+    return nullptr;
+}
 
-        const odb_Enum::odb_DataTypeEnum data_type = instance_field.type();
-        const bool is_scalar = (data_type == odb_Enum::SCALAR);
-        const bool is_vector = (data_type == odb_Enum::VECTOR);
-        const bool is_tensor = (data_type == odb_Enum::TENSOR_3D_FULL ||
-                                data_type == odb_Enum::TENSOR_3D_PLANAR ||
-                                data_type == odb_Enum::TENSOR_2D_PLANAR);
+// ---------------------------------------------------------------------------------------
+//
+//   Restrict the mesh of an instance to the region of interest
+//
+//   Elements of the listed element sets are kept, as are elements whose nodes all
+//   belong to one of the listed node sets. Without sets every element is a candidate.
+//   The bounding box [xmin, ymin, zmin, xmax, ymax, zmax] then keeps the candidates
+//   whose nodes all lie inside it. The element and node data are compacted in place,
+//   so the cell and field arrays and the element groups only cover the region.
+//
+// ---------------------------------------------------------------------------------------
+bool Converter::select_region(otk::Source& source, const std::string& instance_name,
+                              ElementData& elements, NodeData& nodes) {
+    ScopedTimer timer{"select_region", [&] { return json{{"instance", instance_name}}; }};
+
+    const json& region = output_request_["region"];
+    const size_t num_elements = elements.labels.size();
+    const size_t num_nodes = nodes.labels.size();
+
+    LabelIndex node_index;
+    node_index.build(nodes.labels);
+
+    auto all_nodes = [&](size_t element, const auto& predicate) {
+        for (int j = elements.offsets[element]; j < elements.offsets[element + 1]; ++j) {
+            std::int64_t node = node_index.find(elements.connectivity[j]);
+            if (node < 0 || !predicate(node)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Candidate elements from the element and node sets
+    bool has_sets = false;
+    std::vector<char> keep(num_elements, 0);
+    if (region.contains("element_sets")) {
+        has_sets = true;
+        LabelIndex element_index;
+        element_index.build(elements.labels);
+        for (const auto& entry : region["element_sets"]) {
+            if (entry["instance"].get<std::string>() != instance_name) {
+                continue;
+            }
+            auto set_name = entry["set"].get<std::string>();
+            for (const auto& label : source.element_set(instance_name, set_name)) {
+                if (std::int64_t element = element_index.find(label); element >= 0) {
+                    keep[element] = 1;
+                }
+            }
+        }
+    }
+    if (region.contains("node_sets")) {
+        has_sets = true;
+        for (const auto& entry : region["node_sets"]) {
+            if (entry["instance"].get<std::string>() != instance_name) {
+                continue;
+            }
+            std::vector<char> in_set(num_nodes, 0);
+            auto set_name = entry["set"].get<std::string>();
+            for (const auto& label : source.node_set(instance_name, set_name)) {
+                if (std::int64_t node = node_index.find(label); node >= 0) {
+                    in_set[node] = 1;
+                }
+            }
+            auto in_node_set = [&in_set](auto node) { return in_set[node] != 0; };
+            for (size_t i = 0; i < num_elements; ++i) {
+                if (!keep[i] && all_nodes(i, in_node_set)) {
+                    keep[i] = 1;
+                }
+            }
+        }
+    }
+    if (!has_sets) {
+        std::fill(keep.begin(), keep.end(), 1);
+    }
 
-        if (!(is_scalar || is_vector || is_tensor)) {
-            fmt::print("Field {} has unsupported data type ({}).\n", field,
-                       static_cast<int>(data_type));
-            continue;
+    // Bounding box filter
+    if (region.contains("box")) {
+        auto box = region["box"].get<std::vector<double>>();
+        auto inside = [&](auto node) {
+            for (int k = 0; k < 3; ++k) {
+                double x = nodes.coordinates[3 * node + k];
+                if (x < box[k] || x > box[k + 3]) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        for (size_t i = 0; i < num_elements; ++i) {
+            if (keep[i] && !all_nodes(i, inside)) {
+                keep[i] = 0;
+            }
         }
+    }
+
+    // Compact the elements and the nodes they reference
+    ElementData region_elements;
+    region_elements.type_names = std::move(elements.type_names);
+    region_elements.section_names = std::move(elements.section_names);
+    region_elements.offsets.push_back(0);
 
-        if (is_scalar) {
-            extract_scalar_field(instance_field, element_sets, instance, composite);
+    std::vector<char> node_used(num_nodes, 0);
+    for (size_t i = 0; i < num_elements; ++i) {
+        if (!keep[i]) {
             continue;
         }
-        if (is_vector) {
-            extract_vector_field(instance_field, element_sets, instance, composite);
-            continue;
+        region_elements.labels.push_back(elements.labels[i]);
+        region_elements.types.push_back(elements.types[i]);
+        region_elements.sections.push_back(elements.sections[i]);
+        for (int j = elements.offsets[i]; j < elements.offsets[i + 1]; ++j) {
+            region_elements.connectivity.push_back(elements.connectivity[j]);
+            std::int64_t node = node_index.find(elements.connectivity[j]);
+            if (node >= 0) {
+                node_used[node] = 1;
+            }
         }
-        extract_tensor_field(instance_field, element_sets, instance, composite);
+        region_elements.offsets.push_back(
+            static_cast<int>(region_elements.connectivity.size()));
+    }
+    if (region_elements.labels.empty()) {
+        return false;
     }
 
-    std::cout << fmt::format("done\n");
-    std::cout << std::flush;
+    NodeData region_nodes;
+    for (size_t i = 0; i < num_nodes; ++i) {
+        if (node_used[i]) {
+            region_nodes.labels.push_back(nodes.labels[i]);
+            region_nodes.coordinates.insert(region_nodes.coordinates.end(),
+                                            nodes.coordinates.begin() + 3 * i,
+                                            nodes.coordinates.begin() + 3 * i + 3);
+        }
+    }
+
+    elements = std::move(region_elements);
+    nodes = std::move(region_nodes);
+    return true;
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Extract scalar field data
+//   Get vtkCellArrays from the cells of an element scan
+//
+//   The offsets and connectivity arrays filled by the scan are handed to the
+//   vtkCellArray as they are; the labels and section groups are kept for the field
+//   extraction.
 //
 // ---------------------------------------------------------------------------------------
-void Converter::extract_scalar_field(const odb_FieldOutput& field,
-                                     const std::vector<odb_Set>& element_sets,
-                                     const odb_Instance& instance, bool composite) {
-    std::string field_name{field.name().cStr()};
-    std::string instance_name{instance.name().cStr()};
+Converter::CellArrayPair Converter::get_cells(ElementScan& scan,
+                                              const std::string& instance_name) {
+    ScopedTimer timer{"get_cells", [&] { return json{{"instance", instance_name}}; }};
+
+    CellArrayPair cells;
+    cells.first = std::move(scan.types);
+    cells.second = vtkSmartPointer<vtkCellArray>::New();
+    cells.second->SetData(scan.offsets, scan.connectivity);
 
-    ElementLabelMap element_labels = element_map_[instance_name];
+    section_elements_[instance_name] = std::move(scan.section_groups);
+    element_map_[instance_name].build(scan.labels);
+    element_labels_[instance_name] = std::move(scan.labels);
 
-    int num_instance_elements = instance.elements().size();
-    int num_instance_nodes = instance.nodes().size();
-    int num_section_assignments = instance.sectionAssignments().size();
+    return cells;
+}
 
-    std::vector<double> data_buffer(std::max(num_instance_elements, num_instance_nodes),
-                                    0.0);
-    std::vector<int> node_counts(num_instance_nodes, 0);
-    bool use_point_data = false;
-    bool use_cell_data = false;
-    bool requires_extrapolation = false;  // Interpolation to nodes
-    bool may_require_reduction = false;   // Reduction across section points
+// -----------------------------------------------------------------------------------
+//
+//   Get vtkPoints from the node data
+//
+// -----------------------------------------------------------------------------------
+Converter::PointArray Converter::get_points(LabelIndex& node_map, const NodeData& nodes,
+                                            Dimension instance_type) {
+    ScopedTimer timer{"get_points"};
+
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataTypeToFloat();
+
+    vtkIdType num_nodes = static_cast<vtkIdType>(nodes.labels.size());
+    points->SetNumberOfPoints(num_nodes);
+
+    float* point_values = static_cast<float*>(points->GetVoidPointer(0));
+    std::copy(nodes.coordinates.begin(), nodes.coordinates.end(), point_values);
 
-    for (const auto& set : element_sets) {
-        odb_FieldOutput localized_field = field.getSubset(set);
+    node_map.build(nodes.labels);
 
-        const odb_SequenceFieldLocation locations = localized_field.locations();
-        int num_locations = locations.size();
-        if (num_locations == 0) {
+    return points;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Replace the cells and points of an instance by its exterior surface
+//
+//   Faces of the 3D cells (corner nodes only for quadratic cells) are sorted by their
+//   node ids; a face found once is on the boundary. 2D cells are surfaces already and
+//   are kept whole. The points are compacted to the surface nodes, and each face
+//   remembers the cell it came from so that cell data can be gathered per face. The
+//   faces are taken from the volume cells of the instance, which are then replaced.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_surface(const std::string& instance_name, const NodeData& nodes) {
+    ScopedTimer timer{"extract_surface",
+                      [&] { return json{{"instance", instance_name}}; }};
+
+    // Faces of the linear 3D cells in VTK node order
+    using FaceList = std::vector<std::vector<int>>;
+    static const std::unordered_map<int, FaceList> CELL_FACES{
+        {VTK_TETRA, {{0, 1, 3}, {1, 2, 3}, {2, 0, 3}, {0, 2, 1}}},
+        {VTK_PYRAMID, {{0, 3, 2, 1}, {0, 1, 4}, {1, 2, 4}, {2, 3, 4}, {3, 0, 4}}},
+        {VTK_WEDGE, {{0, 1, 2}, {3, 5, 4}, {0, 3, 4, 1}, {1, 4, 5, 2}, {2, 5, 3, 0}}},
+        {VTK_HEXAHEDRON,
+         {{0, 4, 7, 3},
+          {1, 2, 6, 5},
+          {0, 1, 5, 4},
+          {3, 7, 6, 2},
+          {0, 3, 2, 1},
+          {4, 5, 6, 7}}},
+    };
+    static const std::unordered_map<int, int> LINEAR_CELL{
+        {VTK_QUADRATIC_TETRA, VTK_TETRA},
+        {VTK_QUADRATIC_WEDGE, VTK_WEDGE},
+        {VTK_QUADRATIC_HEXAHEDRON, VTK_HEXAHEDRON},
+    };
+
+    struct Face {
+        std::array<vtkIdType, 4> key;  // Sorted point ids, padded with -1
+        vtkIdType cell;
+        int face;  // Local face, -1 for a whole 2D cell
+    };
+
+    const LabelIndex& node_map = node_map_[instance_name];
+    CellArrayPair& cells = cells_[instance_name];
+    const std::vector<int>& cell_types = cells.first;
+    const vtkIdType* cell_points = static_cast<const vtkIdType*>(
+        cells.second->GetConnectivityArray()->GetVoidPointer(0));
+    const vtkIdType* cell_offsets =
+        static_cast<const vtkIdType*>(cells.second->GetOffsetsArray()->GetVoidPointer(0));
+
+    std::vector<Face> faces;
+
+    for (size_t i = 0; i < cell_types.size(); ++i) {
+        const vtkIdType cell = static_cast<vtkIdType>(i);
+        int cell_type = cell_types[i];
+        if (auto linear = LINEAR_CELL.find(cell_type); linear != LINEAR_CELL.end()) {
+            cell_type = linear->second;
+        }
+        auto face_list = CELL_FACES.find(cell_type);
+        if (face_list == CELL_FACES.end()) {
+            faces.push_back({{-1, -1, -1, -1}, cell, -1});
             continue;
         }
-
-        int location_index = 0;
-        for (int ilocation = 0; ilocation < num_locations; ++ilocation) {
-            switch (locations[ilocation].position()) {
-                case odb_Enum::odb_ResultPositionEnum::WHOLE_ELEMENT:
-                    location_index = ilocation;
-                    break;
-                case odb_Enum::odb_ResultPositionEnum::NODAL:
-                    location_index = ilocation;
-                    break;
-                case odb_Enum::odb_ResultPositionEnum::INTEGRATION_POINT:
-                    location_index = ilocation;
-                    requires_extrapolation = true;
-                    may_require_reduction = true;
-                    break;
-                default:
-                    fmt::print("Unsupported field output position for {} {} ({}).\n",
-                               field_name, instance_name,
-                               static_cast<int>(locations[ilocation].position()));
-                    return;
+        for (size_t f = 0; f < face_list->second.size(); ++f) {
+            const auto& local = face_list->second[f];
+            Face face{{-1, -1, -1, -1}, cell, static_cast<int>(f)};
+            for (size_t k = 0; k < local.size(); ++k) {
+                face.key[k] = cell_points[cell_offsets[cell] + local[k]];
             }
+            std::sort(face.key.begin(), face.key.begin() + local.size());
+            faces.push_back(face);
         }
-        const odb_FieldLocation location = locations[location_index];
-        localized_field = localized_field.getSubset(location);
+    }
+
+    std::sort(faces.begin(), faces.end(), [](const Face& a, const Face& b) {
+        return std::tie(a.key, a.cell, a.face) < std::tie(b.key, b.cell, b.face);
+    });
+
+    // Boundary faces, with the points renumbered to the surface nodes
+    std::vector<vtkIdType> point_ids(node_map.size(), -1);
+    std::vector<int> surface_labels;
 
-        const odb_SequenceSectionPoint section_pts =
-            localized_field.locations()[0].sectionPoint();
-        int num_section_pts = section_pts.size();
+    std::vector<int> face_types;
+    std::vector<vtkIdType>& face_cells = surface_faces_[instance_name];
+    face_cells.clear();
 
-        if (requires_extrapolation) {
-            localized_field = localized_field.getSubset(
-                odb_Enum::odb_ResultPositionEnum::ELEMENT_NODAL);
+    std::vector<vtkIdType> offset_values{0};
+    std::vector<vtkIdType> connectivity_values;
+
+    auto add_point = [&](vtkIdType point) {
+        if (point < 0) {
+            connectivity_values.push_back(-1);
+            return;
+        }
+        if (point_ids[point] < 0) {
+            point_ids[point] = static_cast<vtkIdType>(surface_labels.size());
+            surface_labels.push_back(nodes.labels[point]);
+        }
+        connectivity_values.push_back(point_ids[point]);
+    };
+
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const Face& face = faces[i];
+        if (face.face >= 0 && ((i > 0 && faces[i - 1].key == face.key) ||
+                               (i + 1 < faces.size() && faces[i + 1].key == face.key))) {
+            continue;
         }
-        if (composite && may_require_reduction) {
-            odb_SequenceFieldOutput composite_fields(num_section_pts);
-            for (int i = 0; i < num_section_pts; ++i) {
-                const odb_SectionPoint section_pt = section_pts.constGet(i);
-                odb_FieldOutput temp_field = localized_field.getSubset(section_pt);
-                temp_field = abs(temp_field);
-                composite_fields.append(temp_field);
+
+        const vtkIdType* points = cell_points + cell_offsets[face.cell];
+        if (face.face < 0) {
+            const vtkIdType* end = cell_points + cell_offsets[face.cell + 1];
+            for (const vtkIdType* point = points; point != end; ++point) {
+                add_point(*point);
+            }
+            face_types.push_back(cell_types[face.cell]);
+        } else {
+            int cell_type = cell_types[face.cell];
+            if (auto linear = LINEAR_CELL.find(cell_type); linear != LINEAR_CELL.end()) {
+                cell_type = linear->second;
+            }
+            const auto& local = CELL_FACES.at(cell_type)[face.face];
+            for (const auto& k : local) {
+                add_point(points[k]);
             }
-            composite_fields.append(localized_field);
-            composite_fields = maxEnvelope(composite_fields);
-            localized_field = composite_fields[0];
+            face_types.push_back(local.size() == 3 ? VTK_TRIANGLE : VTK_QUAD);
         }
+        face_cells.push_back(face.cell);
+        offset_values.push_back(static_cast<vtkIdType>(connectivity_values.size()));
+    }
 
-        const odb_SequenceFieldBulkData& blocks = localized_field.bulkDataBlocks();
-        int num_blocks = blocks.size();
+    // Surface points
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataTypeToFloat();
+    points->SetNumberOfPoints(static_cast<vtkIdType>(surface_labels.size()));
+    float* point_values = static_cast<float*>(points->GetVoidPointer(0));
+    for (size_t i = 0; i < point_ids.size(); ++i) {
+        if (point_ids[i] >= 0) {
+            std::copy(nodes.coordinates.begin() + 3 * i,
+                      nodes.coordinates.begin() + 3 * i + 3,
+                      point_values + 3 * point_ids[i]);
+        }
+    }
 
-        if (location.position() == odb_Enum::odb_ResultPositionEnum::WHOLE_ELEMENT) {
-            use_cell_data = true;
-            for (int iblock = 0; iblock < num_blocks; ++iblock) {
-                const odb_FieldBulkData& block = blocks[iblock];
-                int num_elements = block.numberOfElements();
-                int* labels = block.elementLabels();
-
-                if (block.width() != 1) {
-                    fmt::print("Unsupported field width for {} {} (block {}, {}).\n",
-                               field_name, instance_name, iblock, block.width());
-                    return;
-                }
+    // Surface cells
+    auto offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+    auto connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    offsets->SetNumberOfValues(static_cast<vtkIdType>(offset_values.size()));
+    connectivity->SetNumberOfValues(static_cast<vtkIdType>(connectivity_values.size()));
+    std::copy(offset_values.begin(), offset_values.end(), offsets->GetPointer(0));
+    std::copy(connectivity_values.begin(), connectivity_values.end(),
+              connectivity->GetPointer(0));
 
-                switch (block.precision()) {
-                    case odb_Enum::odb_PrecisionEnum::DOUBLE_PRECISION: {
-                        double* data = block.dataDouble();
-                        for (int i = 0; i < num_elements; ++i) {
-                            int id = element_labels[labels[i]];
-                            data_buffer[id] = data[i];
-                        }
-                        break;
-                    }
-                    case odb_Enum::odb_PrecisionEnum::SINGLE_PRECISION: {
-                        float* data = block.data();
-                        for (int i = 0; i < num_elements; ++i) {
-                            int id = element_labels[labels[i]];
-                            data_buffer[id] = data[i];
-                        }
-                        break;
-                    }
-                }
-            }
+    cells.first = std::move(face_types);
+    cells.second = vtkSmartPointer<vtkCellArray>::New();
+    cells.second->SetData(offsets, connectivity);
 
-        } else {
-            use_point_data = true;
-            for (int iblock = 0; iblock < num_blocks; ++iblock) {
-                const odb_FieldBulkData& block = blocks[iblock];
-                int num_nodes = block.numberOfNodes();
-                int* labels = block.nodeLabels();
-
-                if (block.width() != 1) {
-                    fmt::print("Unsupported field width for {} {} (block {}, {}).\n",
-                               field_name, instance_name, iblock, block.width());
-                    return;
-                }
+    points_[instance_name] = points;
+    node_map_[instance_name].build(surface_labels);
+    node_labels_[instance_name] = std::move(surface_labels);
+}
 
-                switch (block.precision()) {
-                    case odb_Enum::odb_PrecisionEnum::DOUBLE_PRECISION: {
-                        double* data = block.dataDouble();
-                        for (int i = 0; i < num_nodes; ++i) {
-                            data_buffer[labels[i] - 1] += data[i];
-                            node_counts[labels[i] - 1]++;
-                        }
-                        break;
-                    }
-                    case odb_Enum::odb_PrecisionEnum::SINGLE_PRECISION: {
-                        float* data = block.data();
-                        for (int i = 0; i < num_nodes; ++i) {
-                            data_buffer[labels[i] - 1] += data[i];
-                            node_counts[labels[i] - 1]++;
-                        }
-                        break;
-                    }
+// ---------------------------------------------------------------------------------------
+//
+//   Share the cell array of instances with an identical topology
+//
+//   Instances of the same part have the same cell types, offsets and connectivity (in
+//   local point ids). Cell arrays are grouped by a hash of their contents, compared in
+//   full, and every duplicate is replaced by a reference to the first instance's
+//   vtkCellArray. Only the points and field arrays stay per instance.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::share_topology() {
+    ScopedTimer timer{"share_topology"};
+
+    std::vector<std::string> instance_names = extract_keys(cells_);
+    std::sort(instance_names.begin(), instance_names.end());
+
+    auto hash_bytes = [](std::uint64_t hash, const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+        return hash;
+    };
+    auto array_bytes = [](vtkDataArray* array) {
+        return std::make_pair(static_cast<const char*>(array->GetVoidPointer(0)),
+                              static_cast<size_t>(array->GetNumberOfValues()) *
+                                  array->GetDataTypeSize());
+    };
+    auto same_array = [&](vtkDataArray* a, vtkDataArray* b) {
+        auto [a_data, a_size] = array_bytes(a);
+        auto [b_data, b_size] = array_bytes(b);
+        return a->GetDataType() == b->GetDataType() && a_size == b_size &&
+               std::equal(a_data, a_data + a_size, b_data);
+    };
+
+    shared_topology_.clear();
+    std::unordered_map<std::uint64_t, std::vector<std::string>> owners;
+    for (const auto& instance_name : instance_names) {
+        CellArrayPair& cells = cells_[instance_name];
+        vtkDataArray* offsets = cells.second->GetOffsetsArray();
+        vtkDataArray* connectivity = cells.second->GetConnectivityArray();
+
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        hash = hash_bytes(hash, cells.first.data(), cells.first.size() * sizeof(int));
+        auto [offset_data, offset_size] = array_bytes(offsets);
+        hash = hash_bytes(hash, offset_data, offset_size);
+        auto [connectivity_data, connectivity_size] = array_bytes(connectivity);
+        hash = hash_bytes(hash, connectivity_data, connectivity_size);
+
+        std::vector<std::string>& candidates = owners[hash];
+        auto owner = std::find_if(
+            candidates.begin(), candidates.end(), [&](const std::string& candidate) {
+                const CellArrayPair& other = cells_[candidate];
+                return other.first == cells.first &&
+                       same_array(other.second->GetOffsetsArray(), offsets) &&
+                       same_array(other.second->GetConnectivityArray(), connectivity);
+            });
+        if (owner == candidates.end()) {
+            candidates.push_back(instance_name);
+            continue;
+        }
+        cells.second = cells_[*owner].second;
+        shared_topology_[instance_name] = *owner;
+    }
+
+    if (!shared_topology_.empty()) {
+        fmt::print("Shared the topology of {} instances with an identical instance.\n",
+                   shared_topology_.size());
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Position of a point on a 3D space-filling curve of 2^bits cells per axis
+//
+//   Morton order interleaves the coordinate bits. Hilbert order first converts the
+//   coordinates to the transposed Hilbert index (J. Skilling, "Programming the Hilbert
+//   curve", AIP Conf. Proc. 707, 2004), whose interleaved bits are the index.
+//
+// ---------------------------------------------------------------------------------------
+static std::uint64_t curve_index(std::array<std::uint32_t, 3> x, int bits, bool hilbert) {
+    if (hilbert) {
+        const std::uint32_t top = 1u << (bits - 1);
+        for (std::uint32_t q = top; q > 1; q >>= 1) {
+            const std::uint32_t p = q - 1;
+            for (int i = 0; i < 3; ++i) {
+                if (x[i] & q) {
+                    x[0] ^= p;
+                } else {
+                    const std::uint32_t t = (x[0] ^ x[i]) & p;
+                    x[0] ^= t;
+                    x[i] ^= t;
                 }
             }
         }
+        for (int i = 1; i < 3; ++i) {
+            x[i] ^= x[i - 1];
+        }
+        std::uint32_t t = 0;
+        for (std::uint32_t q = top; q > 1; q >>= 1) {
+            if (x[2] & q) {
+                t ^= q - 1;
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            x[i] ^= t;
+        }
     }
 
-    if (use_cell_data) {
-        data_buffer.resize(num_instance_elements);
-        cell_data_[instance_name].push_back(vtkSmartPointer<vtkDoubleArray>::New());
-        auto& array = cell_data_[instance_name].back();
-        array->SetName(field_name.c_str());
-        array->SetNumberOfComponents(1);
-        for (const auto& value : data_buffer) {
-            array->InsertNextValue(value);
+    std::uint64_t index = 0;
+    for (int b = bits - 1; b >= 0; --b) {
+        for (int i = 0; i < 3; ++i) {
+            index = (index << 1) | ((x[i] >> b) & 1u);
+        }
+    }
+    return index;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Renumber the points and cells of an instance along a space-filling curve
+//
+//   Points are sorted by the curve index of their coordinates and cells by that of
+//   their centroids (ties keep the storage order). The permutations are folded into
+//   the label indices that scatter_field uses, so field extraction writes straight to
+//   the new positions. The Abaqus labels are kept as "node_labels" and
+//   "element_labels" arrays of the output.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::reorder_instance(const std::string& instance_name,
+                                 const std::string& curve) {
+    ScopedTimer timer{"reorder_instance", [&] {
+        return json{{"instance", instance_name}, {"curve", curve}};
+    }};
+
+    constexpr int BITS = 21;
+    const bool hilbert = curve == "hilbert";
+
+    PointArray& points = points_[instance_name];
+    CellArrayPair& cells = cells_[instance_name];
+    const vtkIdType num_points = points->GetNumberOfPoints();
+    const auto num_cells = static_cast<vtkIdType>(cells.first.size());
+    const auto* coordinates = static_cast<const float*>(points->GetVoidPointer(0));
+    const auto* offsets =
+        static_cast<const vtkIdType*>(cells.second->GetOffsetsArray()->GetVoidPointer(0));
+    const auto* connectivity = static_cast<const vtkIdType*>(
+        cells.second->GetConnectivityArray()->GetVoidPointer(0));
+
+    // One scale for all axes keeps the curve cells cubic
+    double bounds[6];
+    points->GetBounds(bounds);
+    const double extent = std::max(
+        {bounds[1] - bounds[0], bounds[3] - bounds[2], bounds[5] - bounds[4], 1e-30});
+    const double scale = ((1u << BITS) - 1) / extent;
+    auto index_of = [&](const double* x) {
+        std::array<std::uint32_t, 3> cell;
+        for (int k = 0; k < 3; ++k) {
+            cell[k] = static_cast<std::uint32_t>((x[k] - bounds[2 * k]) * scale);
         }
-    } else if (use_point_data) {
-        data_buffer.resize(num_instance_nodes);
-        if (requires_extrapolation) {
-            for (int i = 0; i < data_buffer.size(); ++i) {
-                data_buffer[i] /= node_counts[i];
+        return curve_index(cell, BITS, hilbert);
+    };
+    auto sorted_order = [](const std::vector<std::uint64_t>& keys) {
+        std::vector<vtkIdType> order(keys.size());
+        std::iota(order.begin(), order.end(), vtkIdType{0});
+        std::stable_sort(order.begin(), order.end(),
+                         [&](vtkIdType a, vtkIdType b) { return keys[a] < keys[b]; });
+        return order;
+    };
+
+    // Points
+    std::vector<std::uint64_t> keys(num_points);
+    for (vtkIdType i = 0; i < num_points; ++i) {
+        const double x[3] = {coordinates[3 * i], coordinates[3 * i + 1],
+                             coordinates[3 * i + 2]};
+        keys[i] = index_of(x);
+    }
+    const std::vector<vtkIdType> point_order = sorted_order(keys);
+    std::vector<vtkIdType> new_point_id(num_points);
+    for (vtkIdType i = 0; i < num_points; ++i) {
+        new_point_id[point_order[i]] = i;
+    }
+
+    // Cells
+    keys.assign(num_cells, 0);
+    for (vtkIdType i = 0; i < num_cells; ++i) {
+        double centroid[3] = {0.0, 0.0, 0.0};
+        for (vtkIdType j = offsets[i]; j < offsets[i + 1]; ++j) {
+            for (int k = 0; k < 3; ++k) {
+                centroid[k] += coordinates[3 * connectivity[j] + k];
             }
         }
-        point_data_[instance_name].push_back(vtkSmartPointer<vtkDoubleArray>::New());
-        auto& array = point_data_[instance_name].back();
-        array->SetName(field_name.c_str());
-        array->SetNumberOfComponents(1);
-        for (const auto& value : data_buffer) {
-            array->InsertNextValue(value);
+        for (int k = 0; k < 3; ++k) {
+            centroid[k] /= static_cast<double>(offsets[i + 1] - offsets[i]);
+        }
+        keys[i] = index_of(centroid);
+    }
+    const std::vector<vtkIdType> cell_order = sorted_order(keys);
+
+    // Renumbered mesh
+    auto new_points = vtkSmartPointer<vtkPoints>::New();
+    new_points->SetDataTypeToFloat();
+    new_points->SetNumberOfPoints(num_points);
+    float* point_values = static_cast<float*>(new_points->GetVoidPointer(0));
+    std::vector<int>& node_labels = node_labels_[instance_name];
+    std::vector<int> new_node_labels(num_points);
+    for (vtkIdType i = 0; i < num_points; ++i) {
+        const float* point = coordinates + 3 * point_order[i];
+        std::copy(point, point + 3, point_values + 3 * i);
+        new_node_labels[i] = node_labels[point_order[i]];
+    }
+
+    auto offset_array = vtkSmartPointer<vtkIdTypeArray>::New();
+    auto connectivity_array = vtkSmartPointer<vtkIdTypeArray>::New();
+    offset_array->SetNumberOfValues(num_cells + 1);
+    connectivity_array->SetNumberOfValues(offsets[num_cells]);
+    vtkIdType* offset_values = offset_array->GetPointer(0);
+    vtkIdType* connectivity_values = connectivity_array->GetPointer(0);
+    std::vector<int> types(num_cells);
+    offset_values[0] = 0;
+    for (vtkIdType i = 0; i < num_cells; ++i) {
+        const vtkIdType cell = cell_order[i];
+        vtkIdType n = offset_values[i];
+        for (vtkIdType j = offsets[cell]; j < offsets[cell + 1]; ++j) {
+            connectivity_values[n++] = new_point_id[connectivity[j]];
+        }
+        offset_values[i + 1] = n;
+        types[i] = cells.first[cell];
+    }
+
+    // Surface faces map to their volume cells; otherwise the cells are the elements
+    if (auto faces = surface_faces_.find(instance_name); faces != surface_faces_.end()) {
+        std::vector<vtkIdType> new_faces(num_cells);
+        for (vtkIdType i = 0; i < num_cells; ++i) {
+            new_faces[i] = faces->second[cell_order[i]];
+        }
+        faces->second = std::move(new_faces);
+    } else {
+        std::vector<int>& element_labels = element_labels_[instance_name];
+        std::vector<int> new_element_labels(num_cells);
+        for (vtkIdType i = 0; i < num_cells; ++i) {
+            new_element_labels[i] = element_labels[cell_order[i]];
         }
+        element_labels = std::move(new_element_labels);
+        element_map_[instance_name].build(element_labels);
     }
+
+    points = new_points;
+    cells.first = std::move(types);
+    cells.second = vtkSmartPointer<vtkCellArray>::New();
+    cells.second->SetData(offset_array, connectivity_array);
+    node_labels = std::move(new_node_labels);
+    node_map_[instance_name].build(node_labels);
+
+    // Traceability arrays
+    auto node_label_array = vtkSmartPointer<vtkIntArray>::New();
+    node_label_array->SetName("node_labels");
+    node_label_array->SetNumberOfValues(num_points);
+    std::copy(node_labels.begin(), node_labels.end(), node_label_array->GetPointer(0));
+
+    std::vector<int> cell_labels = get_cell_labels(instance_name);
+    auto element_label_array = vtkSmartPointer<vtkIntArray>::New();
+    element_label_array->SetName("element_labels");
+    element_label_array->SetNumberOfValues(num_cells);
+    std::copy(cell_labels.begin(), cell_labels.end(), element_label_array->GetPointer(0));
+
+    label_arrays_[instance_name] = {node_label_array, element_label_array};
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Extract vector field data
+//   Assign the cells order[begin, end) to the partitions [first, first + count) by
+//   recursive coordinate bisection: each range is split across the longest extent of
+//   its centroids, in proportion to the number of partitions on each side
 //
 // ---------------------------------------------------------------------------------------
-void Converter::extract_vector_field(const odb_FieldOutput& field_output,
-                                     const std::vector<odb_Set>& element_sets,
-                                     const odb_Instance& instance, bool composite) {
-    std::string field_name{field_output.name().cStr()};
-    std::string instance_name{instance.name().cStr()};
+static void bisect_cells(const std::vector<float>& centroids,
+                         std::vector<vtkIdType>& order, size_t begin, size_t end,
+                         int first, int count, std::vector<int>& partition_of) {
+    if (count == 1) {
+        for (size_t i = begin; i < end; ++i) {
+            partition_of[order[i]] = first;
+        }
+        return;
+    }
 
-    int num_instance_elements = instance.elements().size();
-    int num_instance_nodes = instance.nodes().size();
-    int num_section_assignments = instance.sectionAssignments().size();
+    std::array<float, 3> lower{std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::max()};
+    std::array<float, 3> upper{std::numeric_limits<float>::lowest(),
+                               std::numeric_limits<float>::lowest(),
+                               std::numeric_limits<float>::lowest()};
+    for (size_t i = begin; i < end; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            lower[k] = std::min(lower[k], centroids[3 * order[i] + k]);
+            upper[k] = std::max(upper[k], centroids[3 * order[i] + k]);
+        }
+    }
+    int axis = 0;
+    for (int k = 1; k < 3; ++k) {
+        if (upper[k] - lower[k] > upper[axis] - lower[axis]) {
+            axis = k;
+        }
+    }
 
-    std::vector<std::vector<double>> data_buffer(num_instance_nodes, {0.0, 0.0, 0.0});
-    const odb_SequenceFieldBulkData& blocks = field_output.bulkDataBlocks();
-    int num_blocks = blocks.size();
+    const int left = count / 2;
+    const size_t middle = begin + (end - begin) * left / count;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     [&](vtkIdType a, vtkIdType b) {
+                         return centroids[3 * a + axis] < centroids[3 * b + axis];
+                     });
 
-    for (int iblock = 0; iblock < num_blocks; ++iblock) {
-        const odb_FieldBulkData& block = blocks[iblock];
-        int num_nodes = block.numberOfNodes();
-        int num_components = block.width();
-        int* labels = block.nodeLabels();
+    bisect_cells(centroids, order, begin, middle, first, left, partition_of);
+    bisect_cells(centroids, order, middle, end, first + left, count - left, partition_of);
+}
 
-        if (num_components != 3 && num_components != 2) {
-            fmt::print("Unsupported field width for {} {} (block {}, {}).\n", field_name,
-                       instance_name, iblock, block.width());
-            return;
+// ---------------------------------------------------------------------------------------
+//
+//   Split the cells of an instance into spatially coherent partitions
+//
+//   Done once with the mesh: each partition keeps the ids of its cells and points in
+//   the instance (to gather the field arrays of every frame) and its own points and
+//   renumbered cells. Cells keep their instance order within a partition.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::partition_instance(const std::string& instance_name, int num_partitions) {
+    ScopedTimer timer{"partition_instance", [&] {
+        return json{{"instance", instance_name}, {"partitions", num_partitions}};
+    }};
+
+    const CellArrayPair& cells = cells_[instance_name];
+    const auto num_cells = static_cast<vtkIdType>(cells.first.size());
+    const auto* offsets =
+        static_cast<const vtkIdType*>(cells.second->GetOffsetsArray()->GetVoidPointer(0));
+    const auto* connectivity = static_cast<const vtkIdType*>(
+        cells.second->GetConnectivityArray()->GetVoidPointer(0));
+    const auto* coordinates =
+        static_cast<const float*>(points_[instance_name]->GetVoidPointer(0));
+    const vtkIdType num_points = points_[instance_name]->GetNumberOfPoints();
+
+    std::vector<float> centroids(3 * num_cells, 0.0f);
+    for (vtkIdType i = 0; i < num_cells; ++i) {
+        const vtkIdType num_nodes = offsets[i + 1] - offsets[i];
+        for (vtkIdType j = offsets[i]; j < offsets[i + 1]; ++j) {
+            for (int k = 0; k < 3; ++k) {
+                centroids[3 * i + k] += coordinates[3 * connectivity[j] + k];
+            }
         }
+        for (int k = 0; k < 3; ++k) {
+            centroids[3 * i + k] /= static_cast<float>(num_nodes);
+        }
+    }
 
-        switch (block.precision()) {
-            case odb_Enum::odb_PrecisionEnum::DOUBLE_PRECISION: {
-                double* data = block.dataDouble();
-                int pos = 0;
-                for (int i = 0; i < num_nodes; ++i) {
-                    for (int j = 0; j < num_components; ++j) {
-                        data_buffer[labels[i] - 1][j] = data[pos++];
-                    }
-                }
-                break;
-            }
-            case odb_Enum::odb_PrecisionEnum::SINGLE_PRECISION: {
-                float* data = block.data();
-                int pos = 0;
-                for (int i = 0; i < num_nodes; ++i) {
-                    for (int j = 0; j < num_components; ++j) {
-                        data_buffer[labels[i] - 1][j] = data[pos++];
-                    }
+    std::vector<vtkIdType> order(num_cells);
+    std::iota(order.begin(), order.end(), vtkIdType{0});
+    std::vector<int> partition_of(num_cells, 0);
+    bisect_cells(centroids, order, 0, order.size(), 0, num_partitions, partition_of);
+
+    std::vector<std::vector<vtkIdType>> partition_cells(num_partitions);
+    for (vtkIdType i = 0; i < num_cells; ++i) {
+        partition_cells[partition_of[i]].push_back(i);
+    }
+
+    std::vector<Partition>& partitions = partitions_[instance_name];
+    partitions.clear();
+    std::vector<vtkIdType> local_ids(num_points, -1);
+
+    for (const auto& cell_list : partition_cells) {
+        if (cell_list.empty()) {
+            continue;
+        }
+
+        // Points in first-use order, with their local ids
+        std::vector<vtkIdType> point_list;
+        std::vector<vtkIdType> local_offsets{0};
+        std::vector<vtkIdType> local_connectivity;
+        std::vector<int> types;
+        local_offsets.reserve(cell_list.size() + 1);
+        types.reserve(cell_list.size());
+        for (const auto& cell : cell_list) {
+            for (vtkIdType j = offsets[cell]; j < offsets[cell + 1]; ++j) {
+                vtkIdType& local = local_ids[connectivity[j]];
+                if (local < 0) {
+                    local = static_cast<vtkIdType>(point_list.size());
+                    point_list.push_back(connectivity[j]);
                 }
-                break;
+                local_connectivity.push_back(local);
             }
+            local_offsets.push_back(static_cast<vtkIdType>(local_connectivity.size()));
+            types.push_back(cells.first[cell]);
+        }
+        for (const auto& point : point_list) {
+            local_ids[point] = -1;
+        }
+
+        Partition partition;
+        partition.cell_ids = vtkSmartPointer<vtkIdList>::New();
+        partition.cell_ids->SetNumberOfIds(static_cast<vtkIdType>(cell_list.size()));
+        std::copy(cell_list.begin(), cell_list.end(), partition.cell_ids->GetPointer(0));
+        partition.point_ids = vtkSmartPointer<vtkIdList>::New();
+        partition.point_ids->SetNumberOfIds(static_cast<vtkIdType>(point_list.size()));
+        std::copy(point_list.begin(), point_list.end(),
+                  partition.point_ids->GetPointer(0));
+
+        partition.points = vtkSmartPointer<vtkPoints>::New();
+        partition.points->SetDataTypeToFloat();
+        partition.points->SetNumberOfPoints(static_cast<vtkIdType>(point_list.size()));
+        float* point_values = static_cast<float*>(partition.points->GetVoidPointer(0));
+        for (size_t i = 0; i < point_list.size(); ++i) {
+            const float* point = coordinates + 3 * point_list[i];
+            std::copy(point, point + 3, point_values + 3 * i);
         }
+
+        auto offset_array = vtkSmartPointer<vtkIdTypeArray>::New();
+        auto connectivity_array = vtkSmartPointer<vtkIdTypeArray>::New();
+        offset_array->SetNumberOfValues(static_cast<vtkIdType>(local_offsets.size()));
+        connectivity_array->SetNumberOfValues(
+            static_cast<vtkIdType>(local_connectivity.size()));
+        std::copy(local_offsets.begin(), local_offsets.end(),
+                  offset_array->GetPointer(0));
+        std::copy(local_connectivity.begin(), local_connectivity.end(),
+                  connectivity_array->GetPointer(0));
+
+        partition.cells.first = std::move(types);
+        partition.cells.second = vtkSmartPointer<vtkCellArray>::New();
+        partition.cells.second->SetData(offset_array, connectivity_array);
+        partitions.push_back(std::move(partition));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Gather the tuples of an array at the given ids into a new array of the same type
+//
+// ---------------------------------------------------------------------------------------
+static vtkSmartPointer<vtkDataArray> gather_tuples(vtkDataArray* array, vtkIdList* ids) {
+    vtkSmartPointer<vtkDataArray> subset;
+    subset.TakeReference(array->NewInstance());
+    subset->SetName(array->GetName());
+    subset->SetNumberOfComponents(array->GetNumberOfComponents());
+    subset->SetNumberOfTuples(ids->GetNumberOfIds());
+    array->GetTuples(ids, subset);
+    return subset;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Pieces of an instance written for the frame
+//
+// ---------------------------------------------------------------------------------------
+std::vector<Converter::FramePiece> Converter::get_frame_pieces(
+    const std::string& instance_name) {
+    PointDataArray point_data = point_data_[instance_name];
+    CellDataArray cell_data = cell_data_[instance_name];
+    if (auto labels = label_arrays_.find(instance_name); labels != label_arrays_.end()) {
+        point_data.push_back(labels->second.first);
+        cell_data.push_back(labels->second.second);
+    }
+
+    auto deformed = deformed_points_.find(instance_name);
+
+    auto it = partitions_.find(instance_name);
+    if (it == partitions_.end()) {
+        PointArray points = deformed != deformed_points_.end() ? deformed->second
+                                                               : points_[instance_name];
+        return {{points, &cells_[instance_name], std::move(point_data),
+                 std::move(cell_data)}};
     }
 
-    point_data_[instance_name].push_back(vtkSmartPointer<vtkDoubleArray>::New());
-    auto& array = point_data_[instance_name].back();
-    array->SetName(field_name.c_str());
-    array->SetNumberOfComponents(3);
-    for (const auto& value : data_buffer) {
-        array->InsertNextTuple3(value[0], value[1], value[2]);
+    std::vector<FramePiece> pieces;
+    for (const auto& partition : it->second) {
+        FramePiece& piece = pieces.emplace_back();
+        piece.points = partition.points;
+        if (deformed != deformed_points_.end()) {
+            piece.points = vtkSmartPointer<vtkPoints>::New();
+            piece.points->SetData(
+                gather_tuples(deformed->second->GetData(), partition.point_ids));
+        }
+        piece.cells = &partition.cells;
+        for (const auto& array : point_data) {
+            piece.point_data.push_back(gather_tuples(array, partition.point_ids));
+        }
+        for (const auto& array : cell_data) {
+            piece.cell_data.push_back(gather_tuples(array, partition.cell_ids));
+        }
     }
+    return pieces;
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Extract tensor field data
+//   Process summary JSON from Source class
 //
 // ---------------------------------------------------------------------------------------
-void Converter::extract_tensor_field(const odb_FieldOutput& field_output,
-                                     const std::vector<odb_Set>& element_sets,
-                                     const odb_Instance& instance, bool composite) {}
+json Converter::process_field_summary(const json& summary) {
+    ScopedTimer timer{"process_field_summary"};
+
+    json frame_numbers;
+    json field_names;
+
+    std::cout << fmt::format("Processing ODB field summary...  ");
+    std::cout << std::flush;
+
+    for (const auto& step : summary["steps"]) {
+        auto step_name = step["name"].template get<std::string>();
+        for (const auto& frame : step["frames"]) {
+            auto frame_number = frame["index"].template get<int>();
+            frame_numbers[step_name].push_back(frame_number);
+            for (const auto& field : frame["fields"]) {
+                auto field_name = field["name"].template get<std::string>();
+                field_names[step_name][std::to_string(frame_number)].push_back(
+                    field_name);
+            }
+        }
+    }
+    json output;
+    output["available_frames"] = frame_numbers;
+    output["available_fields"] = field_names;
+
+    std::cout << fmt::format("done\n");
+    std::cout << std::flush;
+
+    return output;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Match output request to available data
+//
+// ---------------------------------------------------------------------------------------
+json Converter::match_request_to_available_data(const json& frames, const json& fields) {
+    ScopedTimer timer{"match_request_to_available_data"};
+
+    json matches;
+
+    std::cout << fmt::format("Matching output request to available data...  ");
+    std::cout << std::flush;
+
+    // Get all the field names
+    json fields_request = output_request_["fields"];
+    std::vector<std::string> fields_requested;
+    for (const auto& field_info : fields_request) {
+        fields_requested.push_back(field_info["key"].template get<std::string>());
+    }
+
+    // Get all the frame numbers and match them to the available frames and fields
+    json frames_request = output_request_["frames"];
+    for (const auto& frame_info : frames_request) {
+        auto step_name = frame_info["step"].template get<std::string>();
+        auto frame_list = frame_info["list"].template get<std::vector<int>>();
+        std::sort(frame_list.begin(), frame_list.end());
+
+        // Intersect the requested frames with the available frames
+        std::vector<int> frame_matches;
+        std::set_intersection(frame_list.begin(), frame_list.end(),
+                              frames[step_name].begin(), frames[step_name].end(),
+                              std::back_inserter(frame_matches));
+
+        // Regex match the requested fields with the available fields
+        json field_matches;
+        for (const auto& frame : frame_matches) {
+            json field_matches_frame;
+            field_matches_frame["frame"] = frame;
+            field_matches_frame["fields"] = json::array();
+            for (const auto& request : fields_requested) {
+                std::regex regex(request);
+                const auto& field_names = fields[step_name][std::to_string(frame)]
+                                              .template get<std::vector<std::string>>();
+                for (const auto& field_name : field_names) {
+                    if (std::regex_match(field_name, regex)) {
+                        field_matches_frame["fields"].push_back(field_name);
+                    }
+                }
+            }
+            field_matches.push_back(field_matches_frame);
+        }
+        matches[step_name]["fields"] = field_matches;
+        matches[step_name]["frames"] = frame_matches;
+    }
+
+    std::cout << fmt::format("done\n");
+    std::cout << std::flush;
+
+    // std::cout << "\nframes:\n" << frames.dump(2) << "\n\n" << std::flush;
+    // std::cout << "\nfields:\n" << fields.dump(2) << "\n\n" << std::flush;
+    // std::cout << "\nmatches\n" << matches.dump(2) << "\n\n" << std::flush;
+
+    return matches;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Load field data from Source class
+//
+//   Field outputs are fetched per instance by extract_instance_field_data, so this only
+//   resolves the list of fields matched for the frame.
+//
+// ---------------------------------------------------------------------------------------
+json Converter::load_field_data(otk::Source& source, const json& request,
+                                const std::string& step_name, int frame_id) {
+    ScopedTimer timer{"load_field_data",
+                      [&] { return json{{"step", step_name}, {"frame", frame_id}}; }};
+
+    json data;
+
+    std::cout << fmt::format("    - Loading field data...  ");
+    std::cout << std::flush;
+
+    json frame_data;
+
+    const auto& fields_request = request[step_name]["fields"];
+    for (const auto& field_info : fields_request) {
+        int frame = field_info["frame"].get<int>();
+        if (frame != frame_id) {
+            continue;
+        }
+
+        frame_data["frame"] = frame;
+        for (const auto& field : field_info["fields"]) {
+            frame_data["fields"].push_back(field);
+        }
+    }
+    data[step_name] = frame_data;
+
+    std::cout << fmt::format("done\n");
+    std::cout << std::flush;
+
+    return data;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Extract field data from Source class
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_field_data(otk::Source& source, const json& data,
+                                   const json& instance_summary,
+                                   const std::string& step_name, int frame_id) {
+    ScopedTimer timer{"extract_field_data",
+                      [&] { return json{{"step", step_name}, {"frame", frame_id}}; }};
+
+    resolve_derived_inputs(source, step_name, frame_id);
+
+    for (const auto& instance_name : source.instance_names()) {
+        if (!points_.contains(instance_name)) {
+            continue;
+        }
+
+        bool supported = instance_summary[instance_name]["supported"].get<bool>();
+        if (!supported) {
+            fmt::print("Instance {} is not supported.\n", instance_name);
+            fmt::print("This instance will be ignored.\n");
+            fmt::print(
+                "The instance has more than one section,"
+                " but they are of different types.\n{}\n",
+                instance_summary[instance_name]["section_categories"].dump(2));
+            continue;
+        }
+
+        bool composite = instance_summary[instance_name]["composite"].get<bool>();
+        extract_instance_field_data(source, data, instance_name, composite, step_name,
+                                    frame_id);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Extract field data from Instance
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_instance_field_data(otk::Source& source, const json& data,
+                                            const std::string& instance_name,
+                                            bool composite, const std::string& step_name,
+                                            int frame_id) {
+    ScopedTimer timer{"extract_instance_field_data",
+                      [&] { return json{{"instance", instance_name}}; }};
+
+    std::cout << fmt::format("    - Processing {}... ", instance_name);
+    std::cout << std::flush;
+
+    const ElementGroups& groups = section_elements_[instance_name];
+    const std::vector<int>& region_nodes = region_nodes_[instance_name];
+
+    // Field outputs also used by the derived fields are only fetched once
+    std::map<std::string, FieldData> fetched;
+
+    for (const auto& field_value : data[step_name]["fields"]) {
+        auto field = field_value.get<std::string>();
+
+        FieldData field_data;
+        {
+            ScopedTimer load_timer{"field_data", [&] {
+                return json{{"instance", instance_name}, {"field", field}};
+            }};
+            field_data = source.field_data(step_name, frame_id, field, instance_name,
+                                           groups, composite, region_nodes);
+        }
+        if (derived_input_fields_.contains(field) ||
+            (deformation_ && field == deformation_->field)) {
+            fetched[field] = field_data;
+        }
+        if (field_data.blocks.empty()) {
+            continue;
+        }
+
+        if (const auto& components = get_requested_components(field);
+            !components.empty()) {
+            scatter_components(
+                field_data, instance_name,
+                resolve_components(field, output_type(field_data.type), components));
+            continue;
+        }
+
+        switch (field_data.type) {
+            case DataType::SCALAR:
+                extract_scalar_field(field_data, instance_name);
+                break;
+            case DataType::VECTOR:
+                extract_vector_field(field_data, instance_name);
+                break;
+            case DataType::TENSOR_3D_FULL:
+            case DataType::TENSOR_3D_PLANAR:
+            case DataType::TENSOR_2D_PLANAR:
+                extract_tensor_field(field_data, instance_name);
+                break;
+            default:
+                fmt::print("Field {} has unsupported data type ({}).\n", field,
+                           static_cast<int>(field_data.type));
+                break;
+        }
+    }
+
+    extract_deformed_points(source, instance_name, fetched, composite, step_name,
+                            frame_id);
+    extract_derived_fields(source, instance_name, fetched, composite, step_name,
+                           frame_id);
+
+    std::cout << fmt::format("done\n");
+    std::cout << std::flush;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Parse the derived fields of the request
+//
+//   "constants" values are folded into the expressions, so that only field values are
+//   loaded during the conversion.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::parse_derived_fields() {
+    derived_fields_.clear();
+    if (!output_request_.contains("derived")) {
+        return;
+    }
+
+    std::map<std::string, double> constants;
+    if (output_request_.contains("constants")) {
+        constants = output_request_["constants"].get<std::map<std::string, double>>();
+    }
+    for (const auto& derived : output_request_["derived"]) {
+        derived_fields_.push_back({derived["name"].get<std::string>(),
+                                   Expression{derived["expression"].get<std::string>(),
+                                              constants},
+                                   {}});
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Resolve the variables of the derived fields to the field outputs of a frame
+//
+//   A variable is a scalar field (PEEQ), a component (U1, S11) or a field and an
+//   invariant joined by an underscore (S_MISES). The longest field name the variable
+//   starts with and that has such a component wins, so that UR1 is read from UR.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::resolve_derived_inputs(otk::Source& source, const std::string& step_name,
+                                       int frame_id) {
+    derived_input_fields_.clear();
+    if (derived_fields_.empty()) {
+        return;
+    }
+
+    std::vector<std::string> field_names = source.field_names(step_name, frame_id);
+    std::sort(field_names.begin(), field_names.end(),
+              [](const auto& a, const auto& b) { return a.size() > b.size(); });
+    std::map<std::string, DataType> field_types;
+
+    auto resolve = [&](const std::string& variable, const std::string& field) {
+        if (!field_types.contains(field)) {
+            field_types[field] =
+                output_type(source.field_info(step_name, frame_id, field).type);
+        }
+        std::string selector = variable;
+        if (variable.size() > field.size() + 1 && variable[field.size()] == '_') {
+            selector = variable.substr(field.size() + 1);
+        }
+        return resolve_components(field, field_types[field], {selector})[0];
+    };
+
+    for (auto& derived : derived_fields_) {
+        derived.inputs.clear();
+        for (const auto& variable : derived.expression.variables()) {
+            bool found = false;
+            for (const auto& field : field_names) {
+                if (variable.rfind(field, 0) != 0) {
+                    continue;
+                }
+                try {
+                    derived.inputs.emplace_back(field, resolve(variable, field));
+                    found = true;
+                    break;
+                } catch (const std::runtime_error&) {
+                    continue;
+                }
+            }
+            if (!found) {
+                fmt::print("Derived field {} skipped: {} is not a field output of {} "
+                           "frame {}.\n",
+                           derived.name, variable, step_name, frame_id);
+                derived.inputs.clear();
+                break;
+            }
+        }
+        for (const auto& [field, selector] : derived.inputs) {
+            derived_input_fields_.insert(field);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Evaluate the derived fields for an instance
+//
+//   The variables of all the expressions are scattered once per field output, like
+//   selected components, and each expression is evaluated in batches over them. Only
+//   the results are added to the output.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_derived_fields(otk::Source& source,
+                                       const std::string& instance_name,
+                                       std::map<std::string, FieldData>& fetched,
+                                       bool composite, const std::string& step_name,
+                                       int frame_id) {
+    if (derived_fields_.empty()) {
+        return;
+    }
+    ScopedTimer timer{"extract_derived_fields",
+                      [&] { return json{{"instance", instance_name}}; }};
+
+    std::map<std::string, std::vector<ComponentSelector>> field_selectors;
+    for (const auto& derived : derived_fields_) {
+        for (const auto& [field, selector] : derived.inputs) {
+            auto& selectors = field_selectors[field];
+            if (std::none_of(selectors.begin(), selectors.end(),
+                             [&](const auto& s) { return s.name == selector.name; })) {
+                selectors.push_back(selector);
+            }
+        }
+    }
+
+    // Scattered variables and whether they are cell arrays
+    std::map<std::string, std::pair<vtkSmartPointer<vtkDoubleArray>, bool>> variables;
+    for (const auto& [field, selectors] : field_selectors) {
+        auto it = fetched.find(field);
+        if (it == fetched.end()) {
+            ScopedTimer load_timer{"field_data", [&] {
+                return json{{"instance", instance_name}, {"field", field}};
+            }};
+            it = fetched
+                     .emplace(field, source.field_data(step_name, frame_id, field,
+                                                       instance_name,
+                                                       section_elements_[instance_name],
+                                                       composite,
+                                                       region_nodes_[instance_name]))
+                     .first;
+        }
+        if (it->second.blocks.empty()) {
+            continue;
+        }
+        bool use_cell_data = false;
+        FieldDataArray arrays =
+            scatter_selectors(it->second, instance_name, selectors, use_cell_data);
+        for (size_t k = 0; k < selectors.size(); ++k) {
+            variables[selectors[k].name] = {arrays[k], use_cell_data};
+        }
+        fetched.erase(it);  // Release the bulk data
+    }
+
+    for (const auto& derived : derived_fields_) {
+        if (derived.inputs.size() != derived.expression.variables().size()) {
+            continue;
+        }
+
+        std::vector<const double*> inputs;
+        bool use_cell_data = false;
+        bool valid = true;
+        for (size_t i = 0; i < derived.inputs.size(); ++i) {
+            auto it = variables.find(derived.inputs[i].second.name);
+            if (it == variables.end()) {
+                valid = false;  // No values in this instance
+                break;
+            }
+            if (i > 0 && it->second.second != use_cell_data) {
+                fmt::print("Derived field {} mixes nodal and element values.\n",
+                           derived.name);
+                valid = false;
+                break;
+            }
+            use_cell_data = it->second.second;
+            inputs.push_back(it->second.first->GetPointer(0));
+        }
+        if (!valid) {
+            continue;
+        }
+
+        const LabelIndex& label_map =
+            use_cell_data ? element_map_[instance_name] : node_map_[instance_name];
+        auto array = vtkSmartPointer<vtkDoubleArray>::New();
+        array->SetName(derived.name.c_str());
+        array->SetNumberOfTuples(static_cast<vtkIdType>(label_map.size()));
+        derived.expression.evaluate(inputs, array->GetPointer(0), label_map.size());
+        add_field_array(array, instance_name, derived.name, use_cell_data);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Extract scalar field data
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_scalar_field(const FieldData& field,
+                                     const std::string& instance_name) {
+    ScopedTimer timer{"extract_scalar_field", [&] {
+        return json{{"instance", instance_name}, {"field", field.name}};
+    }};
+
+    for (size_t iblock = 0; iblock < field.blocks.size(); ++iblock) {
+        if (field.blocks[iblock].width != 1) {
+            fmt::print("Unsupported field width for {} {} (block {}, {}).\n", field.name,
+                       instance_name, iblock, field.blocks[iblock].width);
+            return;
+        }
+    }
+
+    scatter_field(field, instance_name, 1);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Extract vector field data
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_vector_field(const FieldData& field,
+                                     const std::string& instance_name) {
+    ScopedTimer timer{"extract_vector_field", [&] {
+        return json{{"instance", instance_name}, {"field", field.name}};
+    }};
+
+    for (size_t iblock = 0; iblock < field.blocks.size(); ++iblock) {
+        int num_components = field.blocks[iblock].width;
+        if (num_components != 3 && num_components != 2) {
+            fmt::print("Unsupported field width for {} {} (block {}, {}).\n", field.name,
+                       instance_name, iblock, num_components);
+            return;
+        }
+    }
+
+    scatter_field(field, instance_name, 3);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Extract tensor field data
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_tensor_field(const FieldData& field,
+                                     const std::string& instance_name) {
+    ScopedTimer timer{"extract_tensor_field", [&] {
+        return json{{"instance", instance_name}, {"field", field.name}};
+    }};
+
+    const int width = field.type == DataType::TENSOR_3D_FULL     ? 6
+                      : field.type == DataType::TENSOR_3D_PLANAR ? 4
+                                                                 : 3;
+    for (size_t iblock = 0; iblock < field.blocks.size(); ++iblock) {
+        if (field.blocks[iblock].width != width) {
+            fmt::print("Unsupported field width for {} {} (block {}, {}).\n", field.name,
+                       instance_name, iblock, field.blocks[iblock].width);
+            return;
+        }
+    }
+
+    scatter_field(field, instance_name, 6);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Pass the rows of a block to visit(labels, rows, stride, count)
+//
+//   With output axes, vector and tensor rows are first rotated in batches of
+//   ORIENTATION_BATCH rows into a buffer (3 or 6 values per row), so that the rotation
+//   runs in the same pass as the scatter. Otherwise the rows of the block are passed
+//   as they are.
+//
+// ---------------------------------------------------------------------------------------
+template <typename Visit>
+static void visit_rows(const FieldData& field, const FieldBlock& block,
+                       const std::optional<Matrix3>& axes, Visit&& visit) {
+    auto visit_data = [&](const auto* data, const auto* orientation) {
+        if (!axes || !is_rotatable(field.type)) {
+            visit(block.labels, data, block.width, block.length);
+            return;
+        }
+
+        const int width = rotated_width(field.type);
+        std::vector<double> rotated(static_cast<size_t>(ORIENTATION_BATCH) * width);
+        for (int first = 0; first < block.length; first += ORIENTATION_BATCH) {
+            const int count = std::min(ORIENTATION_BATCH, block.length - first);
+            const auto* quaternions =
+                orientation ? orientation + static_cast<size_t>(first) *
+                                                block.orientation_width
+                            : nullptr;
+            rotate_rows(field.type, field.engineering,
+                        data + static_cast<size_t>(first) * block.width, block.width,
+                        quaternions, block.orientation_width, *axes, count,
+                        rotated.data());
+            visit(block.labels + first, rotated.data(), width, count);
+        }
+    };
+
+    switch (block.precision) {
+        case Precision::DOUBLE:
+            visit_data(block.data_double, block.orientation_double);
+            break;
+        case Precision::SINGLE:
+            visit_data(block.data, block.orientation);
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Scatter the bulk data blocks of a field into a point or cell array
+//
+//   WHOLE_ELEMENT rows are written to the cell of their element label. Nodal rows are
+//   accumulated per node and averaged, which extrapolates ELEMENT_NODAL results and
+//   is harmless for NODAL rows repeated across element groups. Blocks narrower than
+//   the array (2D vectors, planar tensors) leave the remaining components at zero.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::scatter_field(const FieldData& field, const std::string& instance_name,
+                              int num_components, bool add_array) {
+    bool use_cell_data = false;
+    for (const auto& block : field.blocks) {
+        if (block.position == Position::WHOLE_ELEMENT) {
+            use_cell_data = true;
+        }
+    }
+
+    const LabelIndex& label_map =
+        use_cell_data ? element_map_[instance_name] : node_map_[instance_name];
+    vtkIdType num_tuples = static_cast<vtkIdType>(label_map.size());
+
+    auto array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(field.name.c_str());
+    array->SetNumberOfComponents(num_components);
+    array->SetNumberOfTuples(num_tuples);
+    double* values = array->GetPointer(0);
+    std::fill(values, values + num_tuples * num_components, 0.0);
+
+    std::vector<int> counts(use_cell_data ? 0 : num_tuples, 0);
+
+    // Array component of each row value. Tensor rows (11, 22, 33, 12, 13, 23) are
+    // written in the VTK symmetric tensor order (XX, YY, ZZ, XY, YZ, XZ), and 2D
+    // planar rows (11, 22, 12) have no 33 component.
+    std::array<int, 6> columns{0, 1, 2, 3, 4, 5};
+    switch (output_type(field.type)) {
+        case DataType::TENSOR_3D_FULL:
+            columns = {0, 1, 2, 3, 5, 4};
+            break;
+        case DataType::TENSOR_2D_PLANAR:
+            columns = {0, 1, 3};
+            break;
+        default:
+            break;
+    }
+    if (num_components == 6) {
+        constexpr std::array<const char*, 6> suffixes{"11", "22", "33", "12", "23", "13"};
+        for (int k = 0; k < 6; ++k) {
+            array->SetComponentName(k, (field.name + suffixes[k]).c_str());
+        }
+    }
+
+    for (const auto& block : field.blocks) {
+        if ((block.position == Position::WHOLE_ELEMENT) != use_cell_data) {
+            continue;
+        }
+        auto scatter = [&](const int* labels, const auto* rows, int stride, int count) {
+            const int width = std::min(stride, num_components);
+            for (int i = 0; i < count; ++i) {
+                std::int64_t id = label_map.find(labels[i]);
+                if (id < 0) {
+                    continue;
+                }
+                const auto* row = rows + static_cast<size_t>(i) * stride;
+                double* tuple = values + id * num_components;
+                if (use_cell_data) {
+                    for (int j = 0; j < width; ++j) {
+                        tuple[columns[j]] = row[j];
+                    }
+                } else {
+                    for (int j = 0; j < width; ++j) {
+                        tuple[columns[j]] += row[j];
+                    }
+                    counts[id]++;
+                }
+            }
+        };
+        visit_rows(field, block, orientation_axes_, scatter);
+    }
+
+    if (!use_cell_data) {
+        if (deformation_ && field.name == deformation_->field) {
+            deform_points(array, counts, instance_name);
+        } else {
+            average_tuples(array, counts);
+        }
+    }
+    if (add_array) {
+        add_field_array(array, instance_name, field.name, use_cell_data);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Data type of the converted rows of a field (tensors become full 3D tensors when
+//   they are rotated to output axes)
+//
+// ---------------------------------------------------------------------------------------
+DataType Converter::output_type(DataType type) const {
+    return orientation_axes_ ? rotated_type(type) : type;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Scatter the selected components and invariants of a field into scalar arrays
+//
+//   Same placement as scatter_field, but each row is read once for all the selectors
+//   and only the columns they use are read. Invariants are computed per row before the
+//   nodal averaging. scatter_components adds the arrays to the output, while derived
+//   fields use them as the inputs of their expressions.
+//
+// ---------------------------------------------------------------------------------------
+Converter::FieldDataArray Converter::scatter_selectors(
+    const FieldData& field, const std::string& instance_name,
+    const std::vector<ComponentSelector>& selectors, bool& use_cell_data) {
+    ScopedTimer timer{"scatter_selectors", [&] {
+        return json{{"instance", instance_name}, {"field", field.name}};
+    }};
+
+    use_cell_data = false;
+    for (const auto& block : field.blocks) {
+        if (block.position == Position::WHOLE_ELEMENT) {
+            use_cell_data = true;
+        }
+    }
+
+    const LabelIndex& label_map =
+        use_cell_data ? element_map_[instance_name] : node_map_[instance_name];
+    vtkIdType num_tuples = static_cast<vtkIdType>(label_map.size());
+
+    const size_t num_selectors = selectors.size();
+    FieldDataArray arrays(num_selectors);
+    std::vector<double*> values(num_selectors);
+    for (size_t k = 0; k < num_selectors; ++k) {
+        arrays[k] = vtkSmartPointer<vtkDoubleArray>::New();
+        arrays[k]->SetName(selectors[k].name.c_str());
+        arrays[k]->SetNumberOfTuples(num_tuples);
+        values[k] = arrays[k]->GetPointer(0);
+        std::fill(values[k], values[k] + num_tuples, 0.0);
+    }
+
+    std::vector<int> counts(use_cell_data ? 0 : num_tuples, 0);
+    const DataType row_type = output_type(field.type);
+
+    for (const auto& block : field.blocks) {
+        if ((block.position == Position::WHOLE_ELEMENT) != use_cell_data) {
+            continue;
+        }
+
+        auto scatter = [&](const int* labels, const auto* rows, int stride, int count) {
+            for (int i = 0; i < count; ++i) {
+                std::int64_t id = label_map.find(labels[i]);
+                if (id < 0) {
+                    continue;
+                }
+                const auto* row = rows + static_cast<size_t>(i) * stride;
+                for (size_t k = 0; k < num_selectors; ++k) {
+                    const double value =
+                        evaluate_component(selectors[k], row_type, row, stride);
+                    values[k][id] = use_cell_data ? value : values[k][id] + value;
+                }
+                if (!use_cell_data) {
+                    counts[id]++;
+                }
+            }
+        };
+        visit_rows(field, block, orientation_axes_, scatter);
+    }
+
+    if (!use_cell_data) {
+        for (const auto& array : arrays) {
+            average_tuples(array, counts);
+        }
+    }
+    return arrays;
+}
+
+void Converter::scatter_components(const FieldData& field,
+                                   const std::string& instance_name,
+                                   const std::vector<ComponentSelector>& selectors) {
+    bool use_cell_data = false;
+    for (const auto& array :
+         scatter_selectors(field, instance_name, selectors, use_cell_data)) {
+        add_field_array(array, instance_name, field.name, use_cell_data);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Average the tuples of a point array over the number of rows accumulated per node
+//
+// ---------------------------------------------------------------------------------------
+void Converter::average_tuples(vtkDoubleArray* array, const std::vector<int>& counts) {
+    const int num_components = array->GetNumberOfComponents();
+    double* values = array->GetPointer(0);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] > 1) {
+            double* tuple = values + i * num_components;
+            for (int j = 0; j < num_components; ++j) {
+                tuple[j] /= counts[i];
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Average the displacement tuples and write the deformed points of an instance
+//
+//   Each node is averaged and moved to X + scale * u in one pass, while its
+//   displacement is still in registers. Displacements rotated to user axes are
+//   rotated back to the global axes of the points.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::deform_points(vtkDoubleArray* displacement,
+                              const std::vector<int>& counts,
+                              const std::string& instance_name) {
+    ScopedTimer timer{"deform_points", [&] { return json{{"instance", instance_name}}; }};
+
+    vtkPoints* points = points_[instance_name];
+    if (static_cast<size_t>(points->GetNumberOfPoints()) != counts.size()) {
+        throw std::runtime_error(fmt::format(
+            "Displacement {} does not match the points of {}.",
+            displacement->GetName(), instance_name));
+    }
+
+    auto deformed = vtkSmartPointer<vtkPoints>::New();
+    deformed->SetDataTypeToFloat();
+    deformed->SetNumberOfPoints(points->GetNumberOfPoints());
+
+    const float* x = static_cast<const float*>(points->GetVoidPointer(0));
+    float* y = static_cast<float*>(deformed->GetVoidPointer(0));
+    double* u = displacement->GetPointer(0);
+    const double scale = deformation_->scale;
+    const Matrix3 axes = orientation_axes_.value_or(IDENTITY_AXES);
+
+    for (size_t i = 0; i < counts.size(); ++i) {
+        double* tuple = u + 3 * i;
+        if (counts[i] > 1) {
+            tuple[0] /= counts[i];
+            tuple[1] /= counts[i];
+            tuple[2] /= counts[i];
+        }
+        for (int k = 0; k < 3; ++k) {
+            const double global =
+                axes[k] * tuple[0] + axes[3 + k] * tuple[1] + axes[6 + k] * tuple[2];
+            y[3 * i + k] = static_cast<float>(x[3 * i + k] + scale * global);
+        }
+    }
+    deformed_points_[instance_name] = deformed;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Deformed points of an instance whose displacement field was not scattered as a
+//   whole vector field (not requested, or only some of its components)
+//
+// ---------------------------------------------------------------------------------------
+void Converter::extract_deformed_points(otk::Source& source,
+                                        const std::string& instance_name,
+                                        const std::map<std::string, FieldData>& fetched,
+                                        bool composite, const std::string& step_name,
+                                        int frame_id) {
+    if (!deformation_ || deformed_points_.contains(instance_name)) {
+        return;
+    }
+    const std::string& field = deformation_->field;
+
+    FieldData field_data;
+    if (auto it = fetched.find(field); it != fetched.end()) {
+        field_data = it->second;
+    } else {
+        ScopedTimer load_timer{"field_data", [&] {
+            return json{{"instance", instance_name}, {"field", field}};
+        }};
+        field_data = source.field_data(step_name, frame_id, field, instance_name,
+                                       section_elements_[instance_name], composite,
+                                       region_nodes_[instance_name]);
+    }
+    if (field_data.blocks.empty()) {
+        return;
+    }
+    if (field_data.type != DataType::VECTOR) {
+        fmt::print("Deformed geometry skipped: {} is not a vector field.\n", field);
+        return;
+    }
+    scatter_field(field_data, instance_name, 3, false);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Add a field array to the point or cell data of an instance
+//
+//   Cell arrays are gathered per face for surface output. The request of field_name
+//   decides the quantization.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::add_field_array(vtkSmartPointer<vtkDoubleArray> array,
+                                const std::string& instance_name,
+                                const std::string& field_name, bool use_cell_data) {
+    if (use_cell_data) {
+        // Surface output: gather the values of the cell each face comes from
+        auto faces = surface_faces_.find(instance_name);
+        if (faces != surface_faces_.end()) {
+            const int num_components = array->GetNumberOfComponents();
+            const double* values = array->GetPointer(0);
+            auto face_array = vtkSmartPointer<vtkDoubleArray>::New();
+            face_array->SetName(array->GetName());
+            face_array->SetNumberOfComponents(num_components);
+            face_array->SetNumberOfTuples(static_cast<vtkIdType>(faces->second.size()));
+            double* face_values = face_array->GetPointer(0);
+            for (size_t i = 0; i < faces->second.size(); ++i) {
+                std::copy_n(values + faces->second[i] * num_components, num_components,
+                            face_values + i * num_components);
+            }
+            array = face_array;
+        }
+        cell_data_[instance_name].push_back(
+            quantize_field(array, instance_name, field_name));
+        return;
+    }
+    point_data_[instance_name].push_back(
+        quantize_field(array, instance_name, field_name));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Quantization bits requested for a field
+//
+//   A derived field is decided by its own entry, a field output by the first "fields"
+//   entry whose key matches its name (also for its components). "bits" selects
+//   8- or 16-bit integers directly, while "error" is a bound relative to the value range
+//   and selects the narrowest type whose half step meets it. A bound too tight for 16
+//   bits keeps the field in double precision.
+//
+// ---------------------------------------------------------------------------------------
+int Converter::get_quantization_bits(const std::string& field_name) {
+    if (auto it = quantization_bits_.find(field_name); it != quantization_bits_.end()) {
+        return it->second;
+    }
+
+    json quantize;
+    bool derived = false;
+    for (const auto& derived_info : output_request_.value("derived", json::array())) {
+        if (derived_info["name"] == field_name) {
+            quantize = derived_info.value("quantize", json{});
+            derived = true;
+            break;
+        }
+    }
+    if (!derived) {
+        for (const auto& field_info : output_request_["fields"]) {
+            std::regex regex(field_info["key"].get<std::string>());
+            if (std::regex_match(field_name, regex)) {
+                quantize = field_info.value("quantize", json{});
+                break;
+            }
+        }
+    }
+
+    int bits = 0;
+    if (quantize.contains("bits")) {
+        bits = quantize["bits"].get<int>();
+    } else if (quantize.contains("error")) {
+        double error = quantize["error"].get<double>();
+        for (int candidate : {8, 16}) {
+            if (0.5 / ((1 << candidate) - 1) <= error) {
+                bits = candidate;
+                break;
+            }
+        }
+    }
+
+    quantization_bits_[field_name] = bits;
+    return bits;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Components and invariants requested for a field
+//
+//   The first "fields" entry whose key matches the field name decides, as for the
+//   quantization. An empty list converts the whole field.
+//
+// ---------------------------------------------------------------------------------------
+const std::vector<std::string>& Converter::get_requested_components(
+    const std::string& field_name) {
+    if (auto it = requested_components_.find(field_name);
+        it != requested_components_.end()) {
+        return it->second;
+    }
+
+    std::vector<std::string> components;
+    for (const auto& field_info : output_request_["fields"]) {
+        std::regex regex(field_info["key"].get<std::string>());
+        if (!std::regex_match(field_name, regex)) {
+            continue;
+        }
+        if (field_info.contains("components")) {
+            components = field_info["components"].get<std::vector<std::string>>();
+        }
+        break;
+    }
+
+    return requested_components_[field_name] = std::move(components);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Quantize the values of a double array to an unsigned integer array
+//
+// ---------------------------------------------------------------------------------------
+template <typename ArrayType>
+static vtkSmartPointer<vtkDataArray> quantize_values(vtkDoubleArray* array, double offset,
+                                                     double scale) {
+    using ValueType = typename ArrayType::ValueType;
+
+    auto quantized = vtkSmartPointer<ArrayType>::New();
+    quantized->SetName(array->GetName());
+    quantized->SetNumberOfComponents(array->GetNumberOfComponents());
+    quantized->SetNumberOfTuples(array->GetNumberOfTuples());
+    quantized->CopyComponentNames(array);
+
+    const vtkIdType num_values = array->GetNumberOfValues();
+    const double* values = array->GetPointer(0);
+    const double inverse = (scale > 0.0) ? 1.0 / scale : 0.0;
+    ValueType* quantized_values = quantized->GetPointer(0);
+    for (vtkIdType i = 0; i < num_values; ++i) {
+        quantized_values[i] =
+            static_cast<ValueType>(std::lround((values[i] - offset) * inverse));
+    }
+    return quantized;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Quantize a field array to 8- or 16-bit integers with a scale and offset
+//
+//   The offset is the minimum value and the scale spreads the value range over the
+//   integer range, so value = offset + scale * q. Both are stored per array in a
+//   "<field>_quantization" field data array (components "offset" and "scale").
+//
+// ---------------------------------------------------------------------------------------
+vtkSmartPointer<vtkDataArray> Converter::quantize_field(
+    const vtkSmartPointer<vtkDoubleArray>& array, const std::string& instance_name,
+    const std::string& field_name) {
+    int bits = get_quantization_bits(field_name);
+    const vtkIdType num_values = array->GetNumberOfValues();
+    if (bits == 0 || num_values == 0) {
+        return array;
+    }
+
+    ScopedTimer timer{"quantize_field", [&] {
+        return json{{"instance", instance_name}, {"field", array->GetName()}};
+    }};
+
+    const double* values = array->GetPointer(0);
+    auto [min_value, max_value] = std::minmax_element(values, values + num_values);
+    const double offset = *min_value;
+    const double scale = (*max_value - *min_value) / ((1 << bits) - 1);
+
+    auto quantization = vtkSmartPointer<vtkDoubleArray>::New();
+    quantization->SetName(fmt::format("{}_quantization", array->GetName()).c_str());
+    quantization->SetNumberOfComponents(2);
+    quantization->SetComponentName(0, "offset");
+    quantization->SetComponentName(1, "scale");
+    quantization->InsertNextTuple2(offset, scale);
+    quantization_data_[instance_name].push_back(quantization);
+
+    if (bits == 8) {
+        return quantize_values<vtkUnsignedCharArray>(array, offset, scale);
+    }
+    return quantize_values<vtkUnsignedShortArray>(array, offset, scale);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Release the field arrays of the previous frame
+//
+// ---------------------------------------------------------------------------------------
+void Converter::clear_field_data() {
+    cell_data_.clear();
+    point_data_.clear();
+    quantization_data_.clear();
+    deformed_points_.clear();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Sample the RSS at a phase boundary
+//
+// ---------------------------------------------------------------------------------------
+void Converter::sample_memory_phase(const std::string& phase) {
+    memory_samples_.push_back(sample_memory(phase));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Account the bytes held by the VTK arrays and lookup tables of each instance
+//
+//   vtkAbstractArray::GetActualMemorySize() reports kibibytes. Field bytes are kept as
+//   the maximum over the frames converted so far.
+//
+// ---------------------------------------------------------------------------------------
+void Converter::account_memory() {
+    constexpr size_t KIB = 1024;
+
+    json counters;
+    for (const auto& [instance_name, points] : points_) {
+        json& report = memory_report_[instance_name];
+
+        size_t point_bytes = points->GetData()->GetActualMemorySize() * KIB;
+        size_t cell_bytes = 0;
+        size_t cell_type_bytes = 0;
+        if (auto it = cells_.find(instance_name); it != cells_.end()) {
+            // A shared cell array is counted once, for the instance that owns it
+            if (!shared_topology_.contains(instance_name)) {
+                cell_bytes = it->second.second->GetActualMemorySize() * KIB;
+            }
+            cell_type_bytes = it->second.first.capacity() * sizeof(int);
+        }
+        if (auto it = surface_faces_.find(instance_name); it != surface_faces_.end()) {
+            cell_type_bytes += it->second.capacity() * sizeof(vtkIdType);
+        }
+
+        size_t section_bytes = 0;
+        for (const auto& [key, labels] : section_elements_[instance_name]) {
+            section_bytes += labels.capacity() * sizeof(int);
+        }
+
+        size_t partition_bytes = 0;
+        for (const auto& partition : partitions_[instance_name]) {
+            partition_bytes += partition.points->GetData()->GetActualMemorySize() * KIB +
+                               partition.cells.second->GetActualMemorySize() * KIB +
+                               partition.cells.first.capacity() * sizeof(int) +
+                               (partition.cell_ids->GetNumberOfIds() +
+                                partition.point_ids->GetNumberOfIds()) *
+                                   sizeof(vtkIdType);
+        }
+
+        size_t label_bytes = element_map_[instance_name].memory_size() +
+                             node_map_[instance_name].memory_size() +
+                             element_labels_[instance_name].capacity() * sizeof(int) +
+                             node_labels_[instance_name].capacity() * sizeof(int);
+        if (auto it = label_arrays_.find(instance_name); it != label_arrays_.end()) {
+            label_bytes += (it->second.first->GetActualMemorySize() +
+                            it->second.second->GetActualMemorySize()) *
+                           KIB;
+        }
+
+        report["points"] = point_bytes;
+        report["cells"] = cell_bytes;
+        report["cell_types"] = cell_type_bytes;
+        report["section_elements"] = section_bytes;
+        report["label_maps"] = label_bytes;
+        report["partitions"] = partition_bytes;
+
+        auto account_fields = [&report](const auto& arrays) {
+            for (const auto& array : arrays) {
+                std::string field_name{array->GetName()};
+                size_t bytes = array->GetActualMemorySize() * KIB;
+                json& entry = report["fields"][field_name];
+                size_t previous = entry.is_null() ? size_t{0} : entry.get<size_t>();
+                entry = std::max(bytes, previous);
+            }
+        };
+        account_fields(cell_data_[instance_name]);
+        account_fields(point_data_[instance_name]);
+
+        size_t total = point_bytes + cell_bytes + cell_type_bytes + section_bytes +
+                       label_bytes + partition_bytes;
+        for (const auto& [field_name, bytes] : report["fields"].items()) {
+            total += bytes.get<size_t>();
+        }
+        report["total"] = total;
+        counters[instance_name] = total / (1024.0 * 1024.0);
+    }
+
+    Tracer::instance().counter("vtk_mb", counters);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Report the memory samples and byte accounting (console and trace)
+//
+// ---------------------------------------------------------------------------------------
+void Converter::report_memory() {
+    print_separator_2();
+    print_title("Memory summary");
+    print_separator_2();
+
+    size_t peak = 0;
+    std::unordered_map<std::string, size_t> phase_peaks;
+    for (const auto& sample : memory_samples_) {
+        peak = std::max(peak, sample.peak);
+        phase_peaks[sample.phase] = std::max(phase_peaks[sample.phase], sample.rss);
+    }
+    fmt::print("RSS high-water mark: {}\n", format_byte_size(peak));
+    for (const auto& [phase, rss] : phase_peaks) {
+        fmt::print(".. after {}: {}\n", phase, format_byte_size(rss));
+    }
+
+    for (const auto& [instance_name, report] : memory_report_.items()) {
+        fmt::print("{}: {}\n", instance_name,
+                   format_byte_size(report["total"].get<size_t>()));
+        for (const char* key :
+             {"points", "cells", "cell_types", "section_elements", "label_maps",
+              "partitions"}) {
+            fmt::print(".. {}: {}\n", key, format_byte_size(report[key].get<size_t>()));
+        }
+        if (report.contains("fields")) {
+            for (const auto& [field_name, bytes] : report["fields"].items()) {
+                fmt::print(".. field {}: {}\n", field_name,
+                           format_byte_size(bytes.get<size_t>()));
+            }
+        }
+    }
+
+    json samples;
+    for (const auto& sample : memory_samples_) {
+        samples.push_back({{"phase", sample.phase}, {"rss", sample.rss},
+                           {"peak", sample.peak}});
+    }
+    Tracer::instance().metadata("memory", {{"peak_rss", peak},
+                                           {"samples", samples},
+                                           {"instances", memory_report_}});
+}
 
 }  // namespace otk
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "otk/element_scan.hpp"
+
+#include <fmt/format.h>
+
+#include "otk/trace.hpp"
+
+using namespace nlohmann;
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   VTK cell type of an Abaqus element type
+//
+// ---------------------------------------------------------------------------------------
+int vtk_cell_type(const std::string& element_type) {
+    for (const auto& [base_type, cell_type] : ABQ_VTK_CELL_MAP) {
+        if (element_type.rfind(base_type, 0) == 0) {
+            return static_cast<int>(cell_type);
+        }
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Abaqus node of each VTK cell node, for the cell types whose node order differs
+//
+//   Abaqus wedges wind the face 1-2-3 toward the face 4-5-6, while the VTK base
+//   triangle faces away from the top triangle, so both triangles (and their edges)
+//   are reversed.
+//
+// ---------------------------------------------------------------------------------------
+static const std::map<int, std::vector<int>> ABQ_VTK_NODE_ORDER{
+    {VTK_WEDGE, {0, 2, 1, 3, 5, 4}},
+    {VTK_QUADRATIC_WEDGE, {0, 2, 1, 3, 5, 4, 8, 7, 6, 11, 10, 9, 12, 14, 13}},
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Scan the elements of an instance
+//
+//   Per-element work is limited to counting the type and section indices and, with a
+//   node index, appending the cell in VTK node order; names are resolved per distinct
+//   type and section before the pass and the counts are turned into the summary after
+//   it.
+//
+// ---------------------------------------------------------------------------------------
+ElementScan scan_elements(const ElementData& elements, const LabelIndex* node_map) {
+    ScopedTimer timer{"scan_elements"};
+
+    ElementScan scan;
+
+    const size_t num_elements = elements.labels.size();
+    const size_t num_types = elements.type_names.size();
+    const size_t num_sections = elements.section_names.size();
+
+    std::vector<int> type_cells(num_types);
+    std::vector<const std::vector<int>*> type_orders(num_types, nullptr);
+    for (size_t i = 0; i < num_types; ++i) {
+        type_cells[i] = vtk_cell_type(elements.type_names[i]);
+        if (auto order = ABQ_VTK_NODE_ORDER.find(type_cells[i]);
+            order != ABQ_VTK_NODE_ORDER.end()) {
+            type_orders[i] = &order->second;
+        }
+    }
+    scan.category_names.resize(num_sections);
+    for (size_t i = 0; i < num_sections; ++i) {
+        scan.category_names[i] = get_section_category_name(elements.section_names[i]);
+    }
+
+    std::vector<int> type_counts(num_types, 0);
+    std::vector<int> section_counts(num_sections, 0);
+    std::vector<std::vector<int>*> groups(num_sections * num_types, nullptr);
+
+    vtkIdType* offset_values = nullptr;
+    vtkIdType* connectivity_values = nullptr;
+    vtkIdType num_connectivity = 0;
+    if (node_map) {
+        scan.offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+        scan.connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+        scan.offsets->SetNumberOfValues(static_cast<vtkIdType>(num_elements + 1));
+        scan.connectivity->SetNumberOfValues(
+            static_cast<vtkIdType>(elements.connectivity.size()));
+        offset_values = scan.offsets->GetPointer(0);
+        connectivity_values = scan.connectivity->GetPointer(0);
+        offset_values[0] = 0;
+        scan.types.reserve(num_elements);
+        scan.labels.reserve(num_elements);
+    }
+
+    for (size_t i = 0; i < num_elements; ++i) {
+        const int type = elements.types[i];
+        const int section = elements.sections[i];
+        ++type_counts[type];
+        ++section_counts[section];
+
+        const int cell_type = type_cells[type];
+        if (!node_map || cell_type < 0) {
+            continue;
+        }
+
+        const int first = elements.offsets[i];
+        const int num_nodes = elements.offsets[i + 1] - first;
+        const std::vector<int>* order = type_orders[type];
+        if (order && static_cast<int>(order->size()) == num_nodes) {
+            for (const int node : *order) {
+                connectivity_values[num_connectivity++] =
+                    node_map->find(elements.connectivity[first + node]);
+            }
+        } else {
+            for (int j = first; j < first + num_nodes; ++j) {
+                connectivity_values[num_connectivity++] =
+                    node_map->find(elements.connectivity[j]);
+            }
+        }
+        scan.types.push_back(cell_type);
+        offset_values[scan.types.size()] = num_connectivity;
+
+        std::vector<int>*& group = groups[section * num_types + type];
+        if (!group) {
+            group = &scan.section_groups[fmt::format(
+                "{} {}", elements.section_names[section], elements.type_names[type])];
+        }
+        group->push_back(elements.labels[i]);
+        scan.labels.push_back(elements.labels[i]);
+    }
+
+    if (node_map) {
+        scan.offsets->SetNumberOfValues(static_cast<vtkIdType>(scan.types.size() + 1));
+        scan.connectivity->SetNumberOfValues(num_connectivity);
+    }
+
+    for (size_t i = 0; i < num_types; ++i) {
+        if (type_counts[i] == 0) {
+            continue;
+        }
+        scan.element_types[elements.type_names[i]] += type_counts[i];
+        if (type_cells[i] < 0) {
+            scan.unsupported_types.push_back(elements.type_names[i]);
+        } else {
+            scan.cell_types.insert(static_cast<VTKCellType>(type_cells[i]));
+        }
+    }
+
+    bool has_composite_section = false;
+    bool has_non_composite_section = false;
+    for (size_t i = 0; i < num_sections; ++i) {
+        if (section_counts[i] == 0) {
+            continue;
+        }
+        const std::string& category = scan.category_names[i];
+        scan.section_categories[category] += section_counts[i];
+        if (category.find("composite") != std::string::npos) {
+            has_composite_section = true;
+        } else {
+            has_non_composite_section = true;
+        }
+    }
+    scan.supported = !(has_composite_section && has_non_composite_section);
+    scan.composite = has_composite_section;
+
+    return scan;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   JSON summary of a scan
+//
+// ---------------------------------------------------------------------------------------
+json scan_summary(const ElementScan& scan) {
+    json summary;
+    summary["element_types"] = json::array();
+    for (const auto& [element_type, count] : scan.element_types) {
+        summary["element_types"].push_back(element_type);
+    }
+    summary["section_categories"] = json::array();
+    for (const auto& [section_category, count] : scan.section_categories) {
+        summary["section_categories"].push_back(section_category);
+    }
+    summary["supported"] = scan.supported;
+    summary["composite"] = scan.composite;
+    return summary;
+}
+
+}  // namespace otk
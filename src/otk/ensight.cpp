@@ -0,0 +1,362 @@
+#include "otk/ensight.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include <vtkCellType.h>
+
+#include "otk/trace.hpp"
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   EnSight element type of each VTK cell type; order[k] is the VTK node of EnSight
+//   node k (EnSight wedges have the opposite orientation)
+//
+// ---------------------------------------------------------------------------------------
+struct EnsightType {
+    const char *name;
+    int num_nodes;
+    std::vector<int> order;
+};
+
+static const std::map<int, EnsightType> ENSIGHT_TYPES{
+    {VTK_TRIANGLE, {"tria3", 3, {}}},
+    {VTK_QUAD, {"quad4", 4, {}}},
+    {VTK_QUADRATIC_TRIANGLE, {"tria6", 6, {}}},
+    {VTK_QUADRATIC_QUAD, {"quad8", 8, {}}},
+    {VTK_TETRA, {"tetra4", 4, {}}},
+    {VTK_PYRAMID, {"pyramid5", 5, {}}},
+    {VTK_WEDGE, {"penta6", 6, {0, 2, 1, 3, 5, 4}}},
+    {VTK_HEXAHEDRON, {"hexa8", 8, {}}},
+    {VTK_QUADRATIC_TETRA, {"tetra10", 10, {}}},
+    {VTK_QUADRATIC_WEDGE,
+     {"penta15", 15, {0, 2, 1, 3, 5, 4, 8, 7, 6, 11, 10, 9, 12, 14, 13}}},
+    {VTK_QUADRATIC_HEXAHEDRON, {"hexa20", 20, {}}},
+};
+
+// Array component of each "tensor symm" component (11, 22, 33, 12, 13, 23) in the VTK
+// tensor order (XX, YY, ZZ, XY, YZ, XZ)
+constexpr std::array<int, 6> SYMM_COMPONENTS{0, 1, 2, 3, 5, 4};
+
+// ---------------------------------------------------------------------------------------
+//
+//   EnSight variable type of a number of components
+//
+// ---------------------------------------------------------------------------------------
+static std::string variable_type(int num_components) {
+    switch (num_components) {
+        case 1:
+            return "scalar";
+        case 3:
+            return "vector";
+        case 6:
+            return "tensor symm";
+        case 9:
+            return "tensor asym";
+        default:
+            return {};
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Binary records (80 character strings, 32-bit integers and floats)
+//
+// ---------------------------------------------------------------------------------------
+static void write_string(std::ofstream &stream, const std::string &text) {
+    char line[80] = {};
+    std::strncpy(line, text.c_str(), sizeof(line) - 1);
+    stream.write(line, sizeof(line));
+}
+
+static void write_int(std::ofstream &stream, std::int32_t value) {
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+static void write_values(std::ofstream &stream, const std::vector<T> &values) {
+    stream.write(reinterpret_cast<const char *>(values.data()),
+                 static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+static std::ofstream open_file(const fs::path &file) {
+    std::ofstream stream(file, std::ios::binary);
+    if (!stream) {
+        throw std::runtime_error(
+            fmt::format("Could not open {} for writing.", file.string()));
+    }
+    return stream;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Constructor
+//
+// ---------------------------------------------------------------------------------------
+EnsightWriter::EnsightWriter(const fs::path &directory, const std::string &name)
+    : directory_(directory), name_(name) {
+    fs::create_directories(directory_);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Destructor
+//
+// ---------------------------------------------------------------------------------------
+EnsightWriter::~EnsightWriter() {
+    if (closed_) {
+        return;
+    }
+    try {
+        close();
+    } catch (const std::exception &err) {
+        fmt::print("ERROR: {}\n", err.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the geometry file
+//
+//   Cells are grouped by element type once; the groups are reused to order the
+//   per-element variables.
+//
+// ---------------------------------------------------------------------------------------
+void EnsightWriter::write_geometry(const std::vector<Part> &parts) {
+    ScopedTimer timer{"ensight_geometry"};
+
+    blocks_.assign(parts.size(), {});
+
+    std::ofstream stream = open_file(directory_ / fmt::format("{}.geo", name_));
+    write_string(stream, "C Binary");
+    write_string(stream, fmt::format("{} geometry", name_));
+    write_string(stream, "Written by OTK");
+    write_string(stream, "node id given");
+    write_string(stream, "element id given");
+
+    std::vector<std::int32_t> ints;
+    std::vector<float> floats;
+
+    for (size_t p = 0; p < parts.size(); ++p) {
+        const Part &part = parts[p];
+
+        write_string(stream, "part");
+        write_int(stream, static_cast<std::int32_t>(p + 1));
+        write_string(stream, part.name);
+        write_string(stream, "coordinates");
+        write_int(stream, static_cast<std::int32_t>(part.num_points));
+
+        ints.assign(part.node_labels, part.node_labels + part.num_points);
+        write_values(stream, ints);
+        floats.resize(part.num_points);
+        for (int k = 0; k < 3; ++k) {
+            for (size_t i = 0; i < part.num_points; ++i) {
+                floats[i] = part.points[3 * i + k];
+            }
+            write_values(stream, floats);
+        }
+
+        std::map<int, std::vector<vtkIdType>> cells_by_type;
+        for (size_t i = 0; i < part.num_cells; ++i) {
+            if (ENSIGHT_TYPES.contains(part.types[i])) {
+                cells_by_type[part.types[i]].push_back(static_cast<vtkIdType>(i));
+            }
+        }
+
+        for (auto &[vtk_type, cells] : cells_by_type) {
+            const EnsightType &type = ENSIGHT_TYPES.at(vtk_type);
+            write_string(stream, type.name);
+            write_int(stream, static_cast<std::int32_t>(cells.size()));
+
+            ints.resize(cells.size());
+            for (size_t i = 0; i < cells.size(); ++i) {
+                ints[i] = part.element_labels[cells[i]];
+            }
+            write_values(stream, ints);
+
+            ints.resize(cells.size() * type.num_nodes);
+            for (size_t i = 0; i < cells.size(); ++i) {
+                const vtkIdType *nodes = part.connectivity + part.offsets[cells[i]];
+                for (int k = 0; k < type.num_nodes; ++k) {
+                    int node = type.order.empty() ? k : type.order[k];
+                    ints[i * type.num_nodes + k] =
+                        static_cast<std::int32_t>(nodes[node] + 1);
+                }
+            }
+            write_values(stream, ints);
+
+            blocks_[p].push_back({vtk_type, std::move(cells)});
+        }
+    }
+
+    if (!stream) {
+        throw std::runtime_error(
+            fmt::format("Could not write the geometry of {}.", name_));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the variable files of a frame
+//
+// ---------------------------------------------------------------------------------------
+void EnsightWriter::write_frame(
+    double time, const std::map<std::string, std::vector<Variable>> &variables) {
+    ScopedTimer timer{"ensight_frame", [&] { return nlohmann::json{{"time", time}}; }};
+
+    for (const auto &[name, values] : variables) {
+        if (values.empty()) {
+            continue;
+        }
+        const Variable &first = values.front();
+        std::string type = variable_type(first.array->GetNumberOfComponents());
+        if (type.empty()) {
+            fmt::print("Variable {} has an unsupported number of components ({}).\n",
+                       name, first.array->GetNumberOfComponents());
+            continue;
+        }
+
+        auto [it, inserted] = series_.try_emplace(name);
+        Series &series = it->second;
+        if (inserted) {
+            std::string safe_name = name;
+            std::replace_if(
+                safe_name.begin(), safe_name.end(),
+                [](unsigned char c) { return !std::isalnum(c) && c != '-' && c != '_'; },
+                '_');
+            series.type = type + (first.per_node ? " per node" : " per element");
+            series.description = safe_name;
+            series.file = fmt::format("{}_{}", name_, safe_name);
+        }
+
+        fs::path file =
+            directory_ / fmt::format("{}.{:05d}", series.file, series.times.size());
+        write_variable(file, name, values);
+        series.times.push_back(time);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write one variable file
+//
+//   Values are converted to float32 one component at a time, straight from the
+//   extraction arrays (EnSight stores components one after the other). Tensors are
+//   held in the VTK order (XX, YY, ZZ, XY, YZ, XZ) and written in the "tensor symm"
+//   order (11, 22, 33, 12, 13, 23).
+//
+// ---------------------------------------------------------------------------------------
+void EnsightWriter::write_variable(const fs::path &file, const std::string &name,
+                                   const std::vector<Variable> &values) {
+    std::ofstream stream = open_file(file);
+    write_string(stream, name);
+
+    std::vector<float> buffer;
+    for (const auto &variable : values) {
+        vtkDataArray *array = variable.array;
+        const int num_components = array->GetNumberOfComponents();
+
+        auto gather = [&](const auto *data, const vtkIdType *cells, size_t count) {
+            buffer.resize(count);
+            for (int k = 0; k < num_components; ++k) {
+                const int component = (num_components == 6) ? SYMM_COMPONENTS[k] : k;
+                for (size_t i = 0; i < count; ++i) {
+                    vtkIdType tuple = cells ? cells[i] : static_cast<vtkIdType>(i);
+                    buffer[i] = static_cast<float>(
+                        variable.offset +
+                        variable.scale * data[tuple * num_components + component]);
+                }
+                write_values(stream, buffer);
+            }
+        };
+        auto write_block = [&](const vtkIdType *cells, size_t count) {
+            switch (array->GetDataType()) {
+                case VTK_DOUBLE:
+                    gather(static_cast<const double *>(array->GetVoidPointer(0)), cells,
+                           count);
+                    break;
+                case VTK_FLOAT:
+                    gather(static_cast<const float *>(array->GetVoidPointer(0)), cells,
+                           count);
+                    break;
+                case VTK_UNSIGNED_CHAR:
+                    gather(static_cast<const unsigned char *>(array->GetVoidPointer(0)),
+                           cells, count);
+                    break;
+                case VTK_UNSIGNED_SHORT:
+                    gather(static_cast<const unsigned short *>(array->GetVoidPointer(0)),
+                           cells, count);
+                    break;
+                default:
+                    throw std::runtime_error(fmt::format(
+                        "Unsupported data type {} of {}.", array->GetDataTypeAsString(),
+                        name));
+            }
+        };
+
+        write_string(stream, "part");
+        write_int(stream, static_cast<std::int32_t>(variable.part + 1));
+        if (variable.per_node) {
+            write_string(stream, "coordinates");
+            write_block(nullptr, static_cast<size_t>(array->GetNumberOfTuples()));
+            continue;
+        }
+        for (const auto &block : blocks_[variable.part]) {
+            write_string(stream, ENSIGHT_TYPES.at(block.vtk_type).name);
+            write_block(block.cells.data(), block.cells.size());
+        }
+    }
+
+    if (!stream) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", file.string()));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the case file
+//
+// ---------------------------------------------------------------------------------------
+void EnsightWriter::close() {
+    closed_ = true;
+
+    std::ofstream stream(directory_ / fmt::format("{}.case", name_));
+    if (!stream) {
+        throw std::runtime_error(fmt::format("Could not write the case of {}.", name_));
+    }
+
+    stream << "FORMAT\ntype: ensight gold\n\n";
+    stream << fmt::format("GEOMETRY\nmodel: {}.geo\n\n", name_);
+
+    if (series_.empty()) {
+        return;
+    }
+
+    stream << "VARIABLE\n";
+    int time_set = 1;
+    for (const auto &[name, series] : series_) {
+        stream << fmt::format("{}: {} {} {}.*****\n", series.type, time_set++,
+                              series.description, series.file);
+    }
+
+    stream << "\nTIME\n";
+    time_set = 1;
+    for (const auto &[name, series] : series_) {
+        stream << fmt::format("time set: {}\n", time_set++);
+        stream << fmt::format("number of steps: {}\n", series.times.size());
+        stream << "filename start number: 0\nfilename increment: 1\ntime values:\n";
+        for (const auto &time : series.times) {
+            stream << fmt::format("{}\n", time);
+        }
+    }
+}
+
+}  // namespace otk
@@ -0,0 +1,433 @@
+#include "otk/expression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Recursive descent parser emitting the bytecode of an expression
+//
+//       comparison := sum [(< | <= | > | >= | == | !=) sum]
+//       sum        := product {(+ | -) product}
+//       product    := unary {(* | /) unary}
+//       unary      := - unary | power
+//       power      := primary [^ unary]
+//       primary    := number | name | name ( comparison {, comparison} )
+//                     | ( comparison )
+//
+// ---------------------------------------------------------------------------------------
+class Expression::Parser {
+   public:
+    Parser(Expression &expression, const std::map<std::string, double> &constants)
+        : expression_(expression), text_(expression.text_), constants_(constants) {}
+
+    void parse() {
+        comparison();
+        skip_spaces();
+        if (position_ < text_.size()) {
+            fail("unexpected character");
+        }
+    }
+
+   private:
+    void comparison() {
+        sum();
+        skip_spaces();
+        static const std::vector<std::pair<std::string, Op>> operators{
+            {"<=", Op::LESS_EQUAL}, {">=", Op::GREATER_EQUAL}, {"==", Op::EQUAL},
+            {"!=", Op::NOT_EQUAL},  {"<", Op::LESS},           {">", Op::GREATER}};
+        for (const auto &[symbol, op] : operators) {
+            if (text_.compare(position_, symbol.size(), symbol) == 0) {
+                position_ += symbol.size();
+                sum();
+                expression_.emit(op);
+                return;
+            }
+        }
+    }
+
+    void sum() {
+        product();
+        while (true) {
+            if (accept('+')) {
+                product();
+                expression_.emit(Op::ADD);
+            } else if (accept('-')) {
+                product();
+                expression_.emit(Op::SUBTRACT);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void product() {
+        unary();
+        while (true) {
+            if (accept('*')) {
+                unary();
+                expression_.emit(Op::MULTIPLY);
+            } else if (accept('/')) {
+                unary();
+                expression_.emit(Op::DIVIDE);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void unary() {
+        if (accept('-')) {
+            unary();
+            expression_.emit(Op::NEGATE);
+            return;
+        }
+        power();
+    }
+
+    void power() {
+        primary();
+        if (accept('^')) {
+            unary();
+            expression_.emit(Op::POWER);
+        }
+    }
+
+    void primary() {
+        skip_spaces();
+        if (position_ >= text_.size()) {
+            fail("unexpected end");
+        }
+
+        if (accept('(')) {
+            comparison();
+            expect(')');
+            return;
+        }
+
+        const char c = text_[position_];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char *begin = text_.c_str() + position_;
+            char *end = nullptr;
+            const double value = std::strtod(begin, &end);
+            if (end == begin) {
+                fail("invalid number");
+            }
+            position_ += static_cast<size_t>(end - begin);
+            expression_.emit(Op::CONSTANT, value);
+            return;
+        }
+
+        if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_') {
+            fail("expected a number, a name or (");
+        }
+        const size_t begin = position_;
+        while (position_ < text_.size() &&
+               (std::isalnum(static_cast<unsigned char>(text_[position_])) ||
+                text_[position_] == '_')) {
+            ++position_;
+        }
+        const std::string name = text_.substr(begin, position_ - begin);
+
+        if (accept('(')) {
+            function(name);
+            return;
+        }
+        if (auto it = constants_.find(name); it != constants_.end()) {
+            expression_.emit(Op::CONSTANT, it->second);
+            return;
+        }
+        auto &variables = expression_.variables_;
+        auto it = std::find(variables.begin(), variables.end(), name);
+        if (it == variables.end()) {
+            it = variables.insert(variables.end(), name);
+        }
+        expression_.emit(Op::VARIABLE, 0.0, static_cast<int>(it - variables.begin()));
+    }
+
+    void function(const std::string &name) {
+        static const std::map<std::string, std::pair<Op, int>> functions{
+            {"sqrt", {Op::SQRT, 1}}, {"abs", {Op::ABS, 1}}, {"exp", {Op::EXP, 1}},
+            {"log", {Op::LOG, 1}},   {"sin", {Op::SIN, 1}}, {"cos", {Op::COS, 1}},
+            {"min", {Op::MIN, 2}},   {"max", {Op::MAX, 2}}};
+        auto it = functions.find(name);
+        if (it == functions.end()) {
+            fail(fmt::format("unknown function {}", name));
+        }
+        const auto [op, num_arguments] = it->second;
+        for (int i = 0; i < num_arguments; ++i) {
+            if (i > 0) {
+                expect(',');
+            }
+            comparison();
+        }
+        expect(')');
+        expression_.emit(op);
+    }
+
+    void skip_spaces() {
+        while (position_ < text_.size() &&
+               std::isspace(static_cast<unsigned char>(text_[position_]))) {
+            ++position_;
+        }
+    }
+
+    bool accept(char c) {
+        skip_spaces();
+        if (position_ < text_.size() && text_[position_] == c) {
+            ++position_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!accept(c)) {
+            fail(fmt::format("expected {}", c));
+        }
+    }
+
+    [[noreturn]] void fail(const std::string &message) const {
+        throw std::runtime_error(
+            fmt::format("Invalid expression \"{}\": {} at position {}.", text_, message,
+                        position_ + 1));
+    }
+
+    Expression &expression_;
+    const std::string &text_;
+    const std::map<std::string, double> &constants_;
+    size_t position_ = 0;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Constructor
+//
+// ---------------------------------------------------------------------------------------
+Expression::Expression(const std::string &text,
+                       const std::map<std::string, double> &constants)
+    : text_(text) {
+    Parser{*this, constants}.parse();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Append an instruction
+//
+//   Operations on constants are folded, and x^2 becomes a multiplication.
+//
+// ---------------------------------------------------------------------------------------
+void Expression::emit(Op op, double value, int index) {
+    const size_t size = code_.size();
+    auto is_constant = [this](size_t i) { return code_[i].op == Op::CONSTANT; };
+
+    if (op == Op::CONSTANT || op == Op::VARIABLE) {
+        code_.push_back({op, value, index});
+        max_depth_ = std::max(max_depth_, ++depth_);
+        return;
+    }
+    if (!is_binary(op)) {
+        if (is_constant(size - 1)) {
+            code_.back().value = apply(op, code_.back().value);
+            return;
+        }
+        code_.push_back({op});
+        return;
+    }
+
+    // Binary operations
+    --depth_;
+    if (is_constant(size - 1) && is_constant(size - 2)) {
+        code_[size - 2].value = apply(op, code_[size - 2].value, code_.back().value);
+        code_.pop_back();
+        return;
+    }
+    if (op == Op::POWER && is_constant(size - 1) && code_.back().value == 2.0) {
+        code_.back() = {Op::SQUARE};
+        return;
+    }
+    code_.push_back({op});
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Operations taking two operands from the stack
+//
+// ---------------------------------------------------------------------------------------
+bool Expression::is_binary(Op op) {
+    switch (op) {
+        case Op::SQUARE:
+        case Op::NEGATE:
+        case Op::SQRT:
+        case Op::ABS:
+        case Op::EXP:
+        case Op::LOG:
+        case Op::SIN:
+        case Op::COS:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Value of an operation on scalars (y is ignored by unary operations)
+//
+// ---------------------------------------------------------------------------------------
+double Expression::apply(Op op, double x, double y) {
+    switch (op) {
+        case Op::ADD:
+            return x + y;
+        case Op::SUBTRACT:
+            return x - y;
+        case Op::MULTIPLY:
+            return x * y;
+        case Op::DIVIDE:
+            return x / y;
+        case Op::POWER:
+            return std::pow(x, y);
+        case Op::SQUARE:
+            return x * x;
+        case Op::NEGATE:
+            return -x;
+        case Op::LESS:
+            return x < y ? 1.0 : 0.0;
+        case Op::LESS_EQUAL:
+            return x <= y ? 1.0 : 0.0;
+        case Op::GREATER:
+            return x > y ? 1.0 : 0.0;
+        case Op::GREATER_EQUAL:
+            return x >= y ? 1.0 : 0.0;
+        case Op::EQUAL:
+            return x == y ? 1.0 : 0.0;
+        case Op::NOT_EQUAL:
+            return x != y ? 1.0 : 0.0;
+        case Op::SQRT:
+            return std::sqrt(x);
+        case Op::ABS:
+            return std::abs(x);
+        case Op::EXP:
+            return std::exp(x);
+        case Op::LOG:
+            return std::log(x);
+        case Op::SIN:
+            return std::sin(x);
+        case Op::COS:
+            return std::cos(x);
+        case Op::MIN:
+            return std::min(x, y);
+        case Op::MAX:
+            return std::max(x, y);
+        default:
+            return 0.0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Evaluate the expression over arrays
+//
+//   Stack level k is a pointer to the values of the batch: variables point into their
+//   input array, the other levels into buffer k. Each operation is a loop over the
+//   batch with the operation known at compile time.
+//
+// ---------------------------------------------------------------------------------------
+void Expression::evaluate(const std::vector<const double *> &inputs, double *output,
+                          size_t count) const {
+    if (inputs.size() != variables_.size()) {
+        throw std::runtime_error(
+            fmt::format("Expression \"{}\" expects {} inputs, got {}.", text_,
+                        variables_.size(), inputs.size()));
+    }
+
+    std::vector<double> buffers(static_cast<size_t>(max_depth_) * EXPRESSION_BATCH);
+    std::vector<const double *> stack(max_depth_);
+
+    for (size_t first = 0; first < count; first += EXPRESSION_BATCH) {
+        const size_t n = std::min(EXPRESSION_BATCH, count - first);
+
+        int top = 0;
+        for (const auto &instruction : code_) {
+            const Op op = instruction.op;
+
+            if (op == Op::CONSTANT) {
+                double *values = buffers.data() + top * EXPRESSION_BATCH;
+                std::fill_n(values, n, instruction.value);
+                stack[top++] = values;
+                continue;
+            }
+            if (op == Op::VARIABLE) {
+                stack[top++] = inputs[instruction.index] + first;
+                continue;
+            }
+
+            const bool binary = is_binary(op);
+            if (binary) {
+                --top;
+            }
+            const double *x = stack[top - 1];
+            const double *y = binary ? stack[top] : x;
+            double *out = buffers.data() + (top - 1) * EXPRESSION_BATCH;
+
+            auto loop = [&](auto function) {
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] = function(x[i], y[i]);
+                }
+            };
+            switch (op) {
+                case Op::ADD:
+                    loop([](double a, double b) { return a + b; });
+                    break;
+                case Op::SUBTRACT:
+                    loop([](double a, double b) { return a - b; });
+                    break;
+                case Op::MULTIPLY:
+                    loop([](double a, double b) { return a * b; });
+                    break;
+                case Op::DIVIDE:
+                    loop([](double a, double b) { return a / b; });
+                    break;
+                case Op::SQUARE:
+                    loop([](double a, double) { return a * a; });
+                    break;
+                case Op::NEGATE:
+                    loop([](double a, double) { return -a; });
+                    break;
+                case Op::LESS:
+                    loop([](double a, double b) { return a < b ? 1.0 : 0.0; });
+                    break;
+                case Op::GREATER:
+                    loop([](double a, double b) { return a > b ? 1.0 : 0.0; });
+                    break;
+                case Op::SQRT:
+                    loop([](double a, double) { return std::sqrt(a); });
+                    break;
+                case Op::ABS:
+                    loop([](double a, double) { return std::abs(a); });
+                    break;
+                case Op::MIN:
+                    loop([](double a, double b) { return std::min(a, b); });
+                    break;
+                case Op::MAX:
+                    loop([](double a, double b) { return std::max(a, b); });
+                    break;
+                default:
+                    loop([op](double a, double b) { return apply(op, a, b); });
+                    break;
+            }
+            stack[top - 1] = out;
+        }
+
+        std::copy_n(stack[0], n, output + first);
+    }
+}
+
+}  // namespace otk
@@ -0,0 +1,588 @@
+#include "otk/history.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "otk/cli.hpp"
+#include "otk/trace.hpp"
+
+using namespace nlohmann;
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Extract the history of the requested frames and fields
+//
+// ---------------------------------------------------------------------------------------
+void History::extract(otk::Source &source, fs::path file) {
+    ScopedTimer timer{"history"};
+
+    const json &history_request = output_request_["history"];
+    if (history_request.contains("format")) {
+        json formats = history_request["format"];
+        if (formats.is_string()) {
+            formats = json::array({formats});
+        }
+        write_csv_ = std::find(formats.begin(), formats.end(), "csv") != formats.end();
+        write_binary_ =
+            std::find(formats.begin(), formats.end(), "binary") != formats.end();
+    }
+
+    field_keys_.clear();
+    field_matches_.clear();
+    for (const auto &field_info : output_request_["fields"]) {
+        field_keys_.emplace_back(field_info["key"].get<std::string>());
+    }
+
+    fs::path directory = file.parent_path() / file.stem();
+    fs::create_directories(directory);
+
+    if (history_request.contains("regions")) {
+        extract_regions(source, directory, file.stem().string());
+    }
+    if (!history_request.contains("nodes") && !history_request.contains("elements")) {
+        return;
+    }
+
+    std::map<std::string, Selection> selection = resolve_selection(source);
+    if (selection.empty()) {
+        fmt::print("ERROR - No nodes or elements selected for the history output.\n");
+        return;
+    }
+
+    std::map<std::string, Series> series;
+    std::vector<std::string> step_names = source.step_names();
+
+    for (const auto &frame_info : output_request_["frames"]) {
+        auto step_name = frame_info["step"].get<std::string>();
+        if (std::find(step_names.begin(), step_names.end(), step_name) ==
+            step_names.end()) {
+            fmt::print("ERROR - Step {} not found.\n", step_name);
+            continue;
+        }
+
+        int num_frames = source.num_frames(step_name);
+        std::vector<int> frame_ids;
+        if (frame_info.contains("list")) {
+            frame_ids = frame_info["list"].get<std::vector<int>>();
+        } else {
+            frame_ids.resize(num_frames);
+            std::iota(frame_ids.begin(), frame_ids.end(), 0);
+        }
+
+        ScopedTimer step_timer{"history_step", [&] { return json{{"step", step_name}}; }};
+
+        std::cout << fmt::format("Extracting history for {} ({} frames)...  ", step_name,
+                                 frame_ids.size());
+        std::cout << std::flush;
+
+        for (const auto &frame_id : frame_ids) {
+            if (frame_id < 0 || frame_id >= num_frames) {
+                continue;
+            }
+            ScopedTimer frame_timer{"history_frame",
+                                    [&] { return json{{"frame", frame_id}}; }};
+
+            FrameInfo info = source.frame(step_name, frame_id);
+
+            for (const auto &field : source.field_names(step_name, frame_id)) {
+                if (!is_field_requested(field)) {
+                    continue;
+                }
+
+                std::map<std::string, FieldData> data;
+                for (const auto &[instance_name, instance_selection] : selection) {
+                    FieldData field_data =
+                        source.field_values(step_name, frame_id, field, instance_name,
+                                            instance_selection.nodes,
+                                            instance_selection.elements);
+                    if (!field_data.blocks.empty()) {
+                        data[instance_name] = std::move(field_data);
+                    }
+                }
+                if (data.empty()) {
+                    continue;
+                }
+
+                auto [it, inserted] = series.try_emplace(field);
+                Series &field_series = it->second;
+                if (inserted) {
+                    field_series.field = field;
+                    build_layout(field_series, data);
+                    open_series(field_series, directory, file.stem().string());
+                }
+                append_record(field_series, data, step_name, frame_id, info.value);
+            }
+        }
+
+        std::cout << fmt::format("done\n");
+        std::cout << std::flush;
+    }
+
+    for (auto &[field, field_series] : series) {
+        close_series(field_series);
+        fmt::print("History of {}: {} records x {} columns\n", field,
+                   field_series.records["frames"].size(), field_series.columns.size());
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Resolve the node and element selection of the request (labels and sets)
+//
+// ---------------------------------------------------------------------------------------
+std::map<std::string, History::Selection> History::resolve_selection(
+    otk::Source &source) {
+    ScopedTimer timer{"history_selection"};
+
+    const json &history_request = output_request_["history"];
+    std::vector<std::string> instance_names = source.instance_names();
+
+    std::map<std::string, Selection> selection;
+    for (const std::string kind : {"nodes", "elements"}) {
+        if (!history_request.contains(kind)) {
+            continue;
+        }
+        for (const auto &entry : history_request[kind]) {
+            auto instance_name = entry["instance"].get<std::string>();
+            if (std::find(instance_names.begin(), instance_names.end(), instance_name) ==
+                instance_names.end()) {
+                fmt::print("ERROR - Instance {} not found.\n", instance_name);
+                continue;
+            }
+
+            std::vector<int> labels;
+            if (entry.contains("labels")) {
+                labels = entry["labels"].get<std::vector<int>>();
+            }
+            if (entry.contains("set")) {
+                auto set_name = entry["set"].get<std::string>();
+                std::vector<int> set_labels =
+                    (kind == "nodes") ? source.node_set(instance_name, set_name)
+                                      : source.element_set(instance_name, set_name);
+                labels.insert(labels.end(), set_labels.begin(), set_labels.end());
+            }
+
+            Selection &instance_selection = selection[instance_name];
+            std::vector<int> &selected = (kind == "nodes") ? instance_selection.nodes
+                                                           : instance_selection.elements;
+            selected.insert(selected.end(), labels.begin(), labels.end());
+        }
+    }
+
+    for (auto &[instance_name, instance_selection] : selection) {
+        for (auto *labels : {&instance_selection.nodes, &instance_selection.elements}) {
+            std::sort(labels->begin(), labels->end());
+            labels->erase(std::unique(labels->begin(), labels->end()), labels->end());
+        }
+        fmt::print("History selection for {}: {} nodes, {} elements\n", instance_name,
+                   instance_selection.nodes.size(), instance_selection.elements.size());
+    }
+    return selection;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Copy the history outputs of the requested regions of each requested step
+//
+//   The binary store holds the float64 time and value arrays of every output one after
+//   the other; the JSON index gives their byte offsets and lengths.
+//
+// ---------------------------------------------------------------------------------------
+void History::extract_regions(otk::Source &source, const fs::path &directory,
+                              const std::string &stem) {
+    ScopedTimer timer{"history_regions"};
+
+    std::vector<std::regex> region_keys;
+    for (const auto &key : output_request_["history"]["regions"]) {
+        region_keys.emplace_back(key.get<std::string>());
+    }
+
+    fs::path binary_file = directory / fmt::format("{}_history_regions.bin", stem);
+    std::ofstream binary;
+    if (write_binary_) {
+        binary.open(binary_file, std::ios::binary);
+        if (!binary) {
+            throw std::runtime_error(
+                fmt::format("Could not open {} for writing.", binary_file.string()));
+        }
+    }
+
+    json index = json::array();
+    size_t offset = 0;
+    size_t num_regions = 0;
+
+    std::vector<std::string> step_names = source.step_names();
+    std::set<std::string> steps_done;
+
+    for (const auto &frame_info : output_request_["frames"]) {
+        auto step_name = frame_info["step"].get<std::string>();
+        if (std::find(step_names.begin(), step_names.end(), step_name) ==
+                step_names.end() ||
+            !steps_done.insert(step_name).second) {
+            continue;
+        }
+
+        std::cout << fmt::format("Extracting history outputs for {}...  ", step_name);
+        std::cout << std::flush;
+
+        for (const auto &region : source.history_region_names(step_name)) {
+            bool requested = std::any_of(region_keys.begin(), region_keys.end(),
+                                         [&region](const std::regex &key) {
+                                             return std::regex_match(region, key);
+                                         });
+            if (!requested) {
+                continue;
+            }
+
+            std::vector<HistoryData> outputs;
+            {
+                ScopedTimer region_timer{"history_region",
+                                         [&] { return json{{"region", region}}; }};
+                for (const auto &output :
+                     source.history_output_names(step_name, region)) {
+                    if (is_field_requested(output)) {
+                        outputs.push_back(
+                            source.history_output(step_name, region, output));
+                    }
+                }
+            }
+            if (outputs.empty()) {
+                continue;
+            }
+            num_regions++;
+
+            if (write_csv_) {
+                std::string region_name = fmt::format("{}_{}", step_name, region);
+                std::replace_if(
+                    region_name.begin(), region_name.end(),
+                    [](unsigned char c) { return !std::isalnum(c) && c != '-'; }, '_');
+                write_region_csv(
+                    directory / fmt::format("{}_history_{}.csv", stem, region_name),
+                    outputs);
+            }
+
+            if (binary.is_open()) {
+                for (const auto &output : outputs) {
+                    const size_t num_bytes = output.time.size() * sizeof(double);
+                    binary.write(reinterpret_cast<const char *>(output.time.data()),
+                                 num_bytes);
+                    binary.write(reinterpret_cast<const char *>(output.values.data()),
+                                 num_bytes);
+
+                    json entry;
+                    entry["step"] = step_name;
+                    entry["region"] = region;
+                    entry["output"] = output.name;
+                    entry["description"] = output.description;
+                    entry["length"] = output.time.size();
+                    entry["time_offset"] = offset;
+                    entry["values_offset"] = offset + num_bytes;
+                    index.push_back(std::move(entry));
+                    offset += 2 * num_bytes;
+                }
+            }
+        }
+
+        std::cout << fmt::format("done\n");
+        std::cout << std::flush;
+    }
+
+    if (binary.is_open()) {
+        binary.close();
+
+        json description;
+        description["file"] = binary_file.filename().string();
+        description["dtype"] = "float64";
+        description["byte_order"] = "little";
+        description["outputs"] = index;
+
+        fs::path description_file = fs::path{binary_file}.replace_extension(".json");
+        std::ofstream stream(description_file);
+        if (!stream) {
+            throw std::runtime_error(fmt::format("Could not open {} for writing.",
+                                                 description_file.string()));
+        }
+        stream << description.dump(2);
+    }
+
+    fmt::print("History outputs: {} regions\n", num_regions);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the history outputs of a region to CSV
+//
+// ---------------------------------------------------------------------------------------
+void History::write_region_csv(const fs::path &csv_file,
+                               const std::vector<HistoryData> &outputs) {
+    std::ofstream stream(csv_file, std::ios::binary);
+    if (!stream) {
+        throw std::runtime_error(
+            fmt::format("Could not open {} for writing.", csv_file.string()));
+    }
+
+    std::vector<const std::vector<double> *> columns{&outputs.front().time};
+    fmt::memory_buffer buffer;
+    fmt::format_to(std::back_inserter(buffer), "time");
+    size_t num_rows = 0;
+    for (const auto &output : outputs) {
+        if (output.time != outputs.front().time) {
+            columns.push_back(&output.time);
+            fmt::format_to(std::back_inserter(buffer), ",{}.time", output.name);
+        }
+        columns.push_back(&output.values);
+        fmt::format_to(std::back_inserter(buffer), ",{}", output.name);
+        num_rows = std::max(num_rows, output.time.size());
+    }
+    buffer.push_back('\n');
+
+    for (size_t i = 0; i < num_rows; ++i) {
+        for (size_t j = 0; j < columns.size(); ++j) {
+            if (j > 0) {
+                buffer.push_back(',');
+            }
+            if (i < columns[j]->size()) {
+                fmt::format_to(std::back_inserter(buffer), "{}", (*columns[j])[i]);
+            }
+        }
+        buffer.push_back('\n');
+    }
+    stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Match a field name with the regex keys of the request (cached)
+//
+// ---------------------------------------------------------------------------------------
+bool History::is_field_requested(const std::string &field) {
+    auto it = field_matches_.find(field);
+    if (it != field_matches_.end()) {
+        return it->second;
+    }
+    bool requested = std::any_of(
+        field_keys_.begin(), field_keys_.end(),
+        [&field](const std::regex &key) { return std::regex_match(field, key); });
+    field_matches_[field] = requested;
+    return requested;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Build the column layout of a series from the first frame holding the field
+//
+//   Entities keep the order of their labels; an entity has one column per row (node,
+//   element or integration point) and component. Entities without data in the first
+//   frame get no columns.
+//
+// ---------------------------------------------------------------------------------------
+void History::build_layout(Series &series, const std::map<std::string, FieldData> &data) {
+    for (const auto &[instance_name, field_data] : data) {
+        std::vector<int> labels;
+        for (const auto &block : field_data.blocks) {
+            labels.insert(labels.end(), block.labels, block.labels + block.length);
+        }
+        std::vector<int> row_labels = labels;
+        std::sort(labels.begin(), labels.end());
+        labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+
+        Layout &layout = series.layouts[instance_name];
+        layout.index.build(labels);
+        layout.num_rows.assign(labels.size(), 0);
+        layout.width = field_data.blocks.front().width;
+        for (const auto &label : row_labels) {
+            layout.num_rows[layout.index.find(label)]++;
+        }
+
+        const Position position = field_data.blocks.front().position;
+        const char prefix = (position == Position::NODAL) ? 'N' : 'E';
+        series.double_precision |=
+            (field_data.blocks.front().precision == Precision::DOUBLE);
+
+        layout.first_column.resize(labels.size());
+        for (size_t i = 0; i < labels.size(); ++i) {
+            layout.first_column[i] = static_cast<int>(series.columns.size());
+            for (int row = 0; row < layout.num_rows[i]; ++row) {
+                for (int component = 0; component < layout.width; ++component) {
+                    std::string name =
+                        fmt::format("{}.{}{}", instance_name, prefix, labels[i]);
+                    if (layout.num_rows[i] > 1) {
+                        name += fmt::format(".{}", row + 1);
+                    }
+                    if (layout.width > 1) {
+                        name += fmt::format(".{}", component + 1);
+                    }
+                    series.columns.push_back(std::move(name));
+                }
+            }
+        }
+    }
+    series.values.resize(series.columns.size());
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Gather the values of a frame into the record and append it to the stores
+//
+// ---------------------------------------------------------------------------------------
+void History::append_record(Series &series, const std::map<std::string, FieldData> &data,
+                            const std::string &step_name, int frame_id,
+                            double frame_value) {
+    std::fill(series.values.begin(), series.values.end(),
+              std::numeric_limits<double>::quiet_NaN());
+
+    std::vector<int> seen;
+    for (const auto &[instance_name, field_data] : data) {
+        auto layout_it = series.layouts.find(instance_name);
+        if (layout_it == series.layouts.end()) {
+            continue;
+        }
+        const Layout &layout = layout_it->second;
+        seen.assign(layout.num_rows.size(), 0);
+
+        for (const auto &block : field_data.blocks) {
+            if (block.width != layout.width) {
+                continue;
+            }
+            for (int i = 0; i < block.length; ++i) {
+                std::int64_t entity = layout.index.find(block.labels[i]);
+                if (entity < 0 || seen[entity] >= layout.num_rows[entity]) {
+                    continue;
+                }
+                int column = layout.first_column[entity] + seen[entity]++ * layout.width;
+                for (int j = 0; j < layout.width; ++j) {
+                    size_t k = static_cast<size_t>(i) * block.width + j;
+                    series.values[column + j] = (block.precision == Precision::DOUBLE)
+                                                    ? block.data_double[k]
+                                                    : block.data[k];
+                }
+            }
+        }
+    }
+
+    if (series.csv.is_open()) {
+        fmt::memory_buffer line;
+        fmt::format_to(std::back_inserter(line), "{},{},{}", step_name, frame_id,
+                       frame_value);
+        for (const auto &value : series.values) {
+            if (std::isnan(value)) {
+                fmt::format_to(std::back_inserter(line), ",");
+            } else if (series.double_precision) {
+                fmt::format_to(std::back_inserter(line), ",{}", value);
+            } else {
+                fmt::format_to(std::back_inserter(line), ",{}",
+                               static_cast<float>(value));
+            }
+        }
+        line.push_back('\n');
+        series.csv.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+
+    if (series.binary.is_open()) {
+        if (series.double_precision) {
+            series.binary.write(reinterpret_cast<const char *>(series.values.data()),
+                                series.values.size() * sizeof(double));
+        } else {
+            std::vector<float> record(series.values.begin(), series.values.end());
+            series.binary.write(reinterpret_cast<const char *>(record.data()),
+                                record.size() * sizeof(float));
+        }
+    }
+
+    series.records["steps"].push_back(step_name);
+    series.records["frames"].push_back(frame_id);
+    series.records["values"].push_back(frame_value);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Open the stores of a series
+//
+// ---------------------------------------------------------------------------------------
+void History::open_series(Series &series, const fs::path &directory,
+                          const std::string &stem) {
+    std::string field_name = series.field;
+    std::replace_if(
+        field_name.begin(), field_name.end(),
+        [](unsigned char c) { return !std::isalnum(c) && c != '-' && c != '_'; }, '_');
+    // Built as strings: ODB names may contain dots, which replace_extension would cut
+    const std::string base = fmt::format("{}_history_{}", stem, field_name);
+
+    if (write_csv_) {
+        fs::path csv_file = directory / (base + ".csv");
+        series.csv.open(csv_file, std::ios::binary);
+        if (!series.csv) {
+            throw std::runtime_error(
+                fmt::format("Could not open {} for writing.", csv_file.string()));
+        }
+        series.csv << "step,frame,value";
+        for (const auto &column : series.columns) {
+            series.csv << "," << column;
+        }
+        series.csv << "\n";
+    }
+
+    if (write_binary_) {
+        series.binary_file = directory / (base + ".bin");
+        series.binary.open(series.binary_file, std::ios::binary);
+        if (!series.binary) {
+            throw std::runtime_error(fmt::format("Could not open {} for writing.",
+                                                 series.binary_file.string()));
+        }
+    }
+
+    series.records["steps"] = json::array();
+    series.records["frames"] = json::array();
+    series.records["values"] = json::array();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Close the stores of a series and describe the binary layout
+//
+//   The binary file holds one record per frame of little-endian float32 (float64 for
+//   double precision fields) values in column order, i.e. a row-major
+//   [records x columns] array.
+//
+// ---------------------------------------------------------------------------------------
+void History::close_series(Series &series) {
+    if (series.csv.is_open()) {
+        series.csv.close();
+    }
+    if (!series.binary.is_open()) {
+        return;
+    }
+    series.binary.close();
+
+    json description;
+    description["field"] = series.field;
+    description["file"] = series.binary_file.filename().string();
+    description["dtype"] = series.double_precision ? "float64" : "float32";
+    description["byte_order"] = "little";
+    description["shape"] = {series.records["frames"].size(), series.columns.size()};
+    description["columns"] = series.columns;
+    description["steps"] = series.records["steps"];
+    description["frames"] = series.records["frames"];
+    description["values"] = series.records["values"];
+
+    fs::path description_file = fs::path{series.binary_file}.replace_extension(".json");
+    std::ofstream stream(description_file);
+    if (!stream) {
+        throw std::runtime_error(
+            fmt::format("Could not open {} for writing.", description_file.string()));
+    }
+    stream << description.dump(2);
+}
+
+}  // namespace otk
@@ -0,0 +1,313 @@
+#include "otk/info.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "otk/element_scan.hpp"
+#include "otk/parallel.hpp"
+#include "otk/trace.hpp"
+
+using namespace nlohmann;
+
+namespace otk {
+
+// Rows formatted by one task
+constexpr size_t INFO_CHUNK_ROWS = 1 << 14;
+
+// ---------------------------------------------------------------------------------------
+//
+//   Display name of an embedded space
+//
+// ---------------------------------------------------------------------------------------
+static std::string dimension_name(Dimension dimension) {
+    switch (dimension) {
+        case Dimension::THREE_D:
+            return "3D";
+        case Dimension::TWO_D_PLANAR:
+            return "2D planar";
+        case Dimension::AXISYMMETRIC:
+            return "Axisymmetric";
+        default:
+            return "Unsupported";
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   CSV field, quoted if needed
+//
+// ---------------------------------------------------------------------------------------
+static std::string csv_field(const std::string &text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        return text;
+    }
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+static std::ofstream open_file(const fs::path &file) {
+    std::ofstream stream(file, std::ios::binary);
+    if (!stream) {
+        throw std::runtime_error(
+            fmt::format("Could not open {} for writing.", file.string()));
+    }
+    return stream;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Format rows [0, num_rows) with format_row(buffer, i) and write them in order
+//
+//   Chunks of INFO_CHUNK_ROWS rows are formatted in parallel into their own buffers,
+//   a few chunks per thread at a time, and each buffer is written with a single call.
+//
+// ---------------------------------------------------------------------------------------
+template <typename FormatRow>
+static void write_rows(std::ofstream &stream, size_t num_rows, int threads,
+                       FormatRow &&format_row) {
+    const size_t num_chunks = (num_rows + INFO_CHUNK_ROWS - 1) / INFO_CHUNK_ROWS;
+    const size_t batch_size = 4 * static_cast<size_t>(threads);
+    std::vector<fmt::memory_buffer> buffers(std::min(batch_size, num_chunks));
+
+    for (size_t first = 0; first < num_chunks; first += batch_size) {
+        const size_t count = std::min(batch_size, num_chunks - first);
+        parallel_for(count, threads, [&](size_t c, int) {
+            fmt::memory_buffer &buffer = buffers[c];
+            buffer.clear();
+            const size_t begin = (first + c) * INFO_CHUNK_ROWS;
+            const size_t end = std::min(begin + INFO_CHUNK_ROWS, num_rows);
+            for (size_t i = begin; i < end; ++i) {
+                format_row(buffer, i);
+            }
+        });
+        for (size_t c = 0; c < count; ++c) {
+            stream.write(buffers[c].data(),
+                         static_cast<std::streamsize>(buffers[c].size()));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Summary of an instance and of the steps
+//
+// ---------------------------------------------------------------------------------------
+static json instance_info(const Source &source, const std::string &instance,
+                          const ElementData &elements) {
+    ElementScan scan = scan_elements(elements);
+
+    json info;
+    info["dimension"] = dimension_name(source.dimension(instance));
+    info["num_nodes"] = source.num_nodes(instance);
+    info["num_elements"] = elements.labels.size();
+    info["element_types"] = scan.element_types;
+    info["section_categories"] = scan.section_categories;
+    info["supported"] = scan.supported;
+    info["composite"] = scan.composite;
+    return info;
+}
+
+static json steps_info(const Source &source) {
+    json steps = json::array();
+    for (const auto &step_name : source.step_names()) {
+        const int num_frames = source.num_frames(step_name);
+
+        json step;
+        step["name"] = step_name;
+        step["frames"] = json::array();
+        for (int i = 0; i < num_frames; ++i) {
+            FrameInfo info = source.frame(step_name, i);
+            step["frames"].push_back({{"index", i},
+                                      {"id", info.id},
+                                      {"increment", info.increment},
+                                      {"value", info.value}});
+        }
+        step["fields"] = json::array();
+        if (num_frames > 0) {
+            step["fields"] = source.field_names(step_name, 0);
+        }
+        steps.push_back(std::move(step));
+    }
+    return steps;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   JSON summary of a model
+//
+// ---------------------------------------------------------------------------------------
+json info_summary(const Source &source) {
+    ScopedTimer timer{"info_summary"};
+
+    json summary;
+    summary["instances"] = json::object();
+    for (const auto &instance : source.instance_names()) {
+        summary["instances"][instance] =
+            instance_info(source, instance, source.elements(instance));
+    }
+    summary["steps"] = steps_info(source);
+    return summary;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   JSON output; with verbose, the instance objects are written one at a time with
+//   their node and element rows appended
+//
+// ---------------------------------------------------------------------------------------
+static void write_info_json(const Source &source, const fs::path &file, bool verbose,
+                            int threads) {
+    std::ofstream stream = open_file(file);
+    if (!verbose) {
+        stream << info_summary(source).dump(2) << '\n';
+        return;
+    }
+
+    stream << "{\"instances\":{";
+    bool first_instance = true;
+    for (const auto &instance : source.instance_names()) {
+        ElementData elements = source.elements(instance);
+        NodeData nodes = source.nodes(instance);
+
+        std::string header = instance_info(source, instance, elements).dump();
+        header.pop_back();  // Reopen the object for the mesh arrays
+        stream << (first_instance ? "" : ",") << json(instance).dump() << ':' << header;
+        first_instance = false;
+
+        auto format_node = [&](fmt::memory_buffer &buffer, size_t i) {
+            const float *xyz = nodes.coordinates.data() + 3 * i;
+            fmt::format_to(std::back_inserter(buffer), "{}[{},{},{},{}]",
+                           i > 0 ? "," : "", nodes.labels[i], xyz[0], xyz[1], xyz[2]);
+        };
+        stream << ",\"nodes\":[";
+        write_rows(stream, nodes.labels.size(), threads, format_node);
+
+        std::vector<std::string> types;
+        for (const auto &name : elements.type_names) {
+            types.push_back(json(name).dump());
+        }
+        std::vector<std::string> sections;
+        for (const auto &name : elements.section_names) {
+            sections.push_back(json(get_section_category_name(name)).dump());
+        }
+
+        auto format_element = [&](fmt::memory_buffer &buffer, size_t i) {
+            fmt::format_to(std::back_inserter(buffer), "{}[{},{},{},[", i > 0 ? "," : "",
+                           elements.labels[i], types[elements.types[i]],
+                           sections[elements.sections[i]]);
+            for (int j = elements.offsets[i]; j < elements.offsets[i + 1]; ++j) {
+                fmt::format_to(std::back_inserter(buffer), "{}{}",
+                               j > elements.offsets[i] ? "," : "",
+                               elements.connectivity[j]);
+            }
+            fmt::format_to(std::back_inserter(buffer), "]]");
+        };
+        stream << "],\"elements\":[";
+        write_rows(stream, elements.labels.size(), threads, format_element);
+        stream << "]}";
+    }
+    stream << "},\"steps\":" << steps_info(source).dump() << "}\n";
+
+    if (!stream) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", file.string()));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   CSV output: one row per instance, and with verbose the node and element tables
+//   next to it (<stem>_nodes.csv, <stem>_elements.csv)
+//
+// ---------------------------------------------------------------------------------------
+static void write_info_csv(const Source &source, const fs::path &file, bool verbose,
+                           int threads) {
+    std::ofstream stream = open_file(file);
+    stream << "instance,dimension,num_nodes,num_elements\n";
+    for (const auto &instance : source.instance_names()) {
+        stream << fmt::format("{},{},{},{}\n", csv_field(instance),
+                              dimension_name(source.dimension(instance)),
+                              source.num_nodes(instance), source.num_elements(instance));
+    }
+    if (!verbose) {
+        return;
+    }
+
+    const std::string stem = file.stem().string();
+    std::ofstream node_stream = open_file(file.parent_path() / (stem + "_nodes.csv"));
+    std::ofstream element_stream =
+        open_file(file.parent_path() / (stem + "_elements.csv"));
+    node_stream << "instance,label,x,y,z\n";
+    element_stream << "instance,label,type,section,connectivity\n";
+
+    for (const auto &instance : source.instance_names()) {
+        const std::string name = csv_field(instance);
+
+        NodeData nodes = source.nodes(instance);
+        auto format_node = [&](fmt::memory_buffer &buffer, size_t i) {
+            const float *xyz = nodes.coordinates.data() + 3 * i;
+            fmt::format_to(std::back_inserter(buffer), "{},{},{},{},{}\n", name,
+                           nodes.labels[i], xyz[0], xyz[1], xyz[2]);
+        };
+        write_rows(node_stream, nodes.labels.size(), threads, format_node);
+
+        ElementData elements = source.elements(instance);
+        std::vector<std::string> types;
+        for (const auto &type_name : elements.type_names) {
+            types.push_back(csv_field(type_name));
+        }
+        std::vector<std::string> sections;
+        for (const auto &section_name : elements.section_names) {
+            sections.push_back(csv_field(get_section_category_name(section_name)));
+        }
+
+        auto format_element = [&](fmt::memory_buffer &buffer, size_t i) {
+            fmt::format_to(std::back_inserter(buffer), "{},{},{},{},", name,
+                           elements.labels[i], types[elements.types[i]],
+                           sections[elements.sections[i]]);
+            for (int j = elements.offsets[i]; j < elements.offsets[i + 1]; ++j) {
+                fmt::format_to(std::back_inserter(buffer), "{}{}",
+                               j > elements.offsets[i] ? " " : "",
+                               elements.connectivity[j]);
+            }
+            buffer.push_back('\n');
+        };
+        write_rows(element_stream, elements.labels.size(), threads, format_element);
+    }
+
+    if (!stream || !node_stream || !element_stream) {
+        throw std::runtime_error(fmt::format("Could not write the mesh of {}.", stem));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the model info to a .json or .csv file
+//
+// ---------------------------------------------------------------------------------------
+void write_info(const Source &source, const fs::path &file, bool verbose, int threads) {
+    ScopedTimer timer{"write_info", [&] { return json{{"file", file.string()}}; }};
+
+    threads = thread_count(threads);
+    if (file.extension() == ".json") {
+        write_info_json(source, file, verbose, threads);
+    } else if (file.extension() == ".csv") {
+        write_info_csv(source, file, verbose, threads);
+    } else {
+        throw std::runtime_error(fmt::format(
+            "Unsupported info file {} (expected a .json or .csv file).", file.string()));
+    }
+}
+
+}  // namespace otk
@@ -0,0 +1,95 @@
+#include "otk/memory.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "otk/trace.hpp"
+
+namespace otk {
+
+#if defined(__linux__)
+// ---------------------------------------------------------------------------------------
+//
+//   Read a "kB" entry from /proc/self/status
+//
+// ---------------------------------------------------------------------------------------
+static size_t read_proc_status(const std::string &key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind(key, 0) == 0) {
+            std::istringstream stream(line.substr(key.size()));
+            size_t value = 0;
+            stream >> value;
+            return value * 1024;
+        }
+    }
+    return 0;
+}
+#endif
+
+// ---------------------------------------------------------------------------------------
+//
+//   Current resident set size
+//
+// ---------------------------------------------------------------------------------------
+size_t current_rss() {
+#if defined(_WIN32) || defined(_WIN64)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__linux__)
+    return read_proc_status("VmRSS:");
+#else
+    return 0;
+#endif
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Resident set size high-water mark
+//
+// ---------------------------------------------------------------------------------------
+size_t peak_rss() {
+#if defined(_WIN32) || defined(_WIN64)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(__linux__)
+    return read_proc_status("VmHWM:");
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Sample the RSS and record it as a "memory" counter in the trace
+//
+// ---------------------------------------------------------------------------------------
+MemorySample sample_memory(const std::string &phase) {
+    MemorySample sample{phase, current_rss(), peak_rss()};
+    Tracer::instance().counter("memory", {{"rss_mb", sample.rss / (1024.0 * 1024.0)},
+                                          {"peak_mb", sample.peak / (1024.0 * 1024.0)}});
+    return sample;
+}
+
+}  // namespace otk
@@ -0,0 +1,322 @@
+#include "otk/npy.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+#include "otk/store.hpp"
+
+namespace otk {
+
+static constexpr std::uint64_t ZIP32_LIMIT = 0xFFFFFFFFull;
+
+// ---------------------------------------------------------------------------------------
+//
+//   NumPy type descriptor of a store dtype
+//
+// ---------------------------------------------------------------------------------------
+static std::string npy_descr(const std::string &dtype) {
+    static const std::unordered_map<std::string, std::string> descrs{
+        {"float32", "<f4"}, {"float64", "<f8"}, {"uint8", "|u1"},
+        {"uint16", "<u2"},  {"int32", "<i4"},   {"int64", "<i8"},
+    };
+    return descrs.at(dtype);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Size in bytes of a store dtype
+//
+// ---------------------------------------------------------------------------------------
+static size_t npy_item_size(const std::string &dtype) {
+    return std::stoul(npy_descr(dtype).substr(2));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   CRC-32 (zip polynomial) of a buffer, continuing from a previous value
+//
+// ---------------------------------------------------------------------------------------
+static std::uint32_t crc32(const void *data, size_t size, std::uint32_t crc = 0) {
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> entries{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+        return entries;
+    }();
+
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Append a little-endian integer to a byte buffer
+//
+// ---------------------------------------------------------------------------------------
+template <typename T>
+static void put(std::string &buffer, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    buffer.append(bytes, sizeof(T));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Header of a .npy array
+//
+// ---------------------------------------------------------------------------------------
+std::string npy_header(const std::string &dtype, const std::vector<size_t> &shape) {
+    std::string dims;
+    for (const auto &dim : shape) {
+        dims += fmt::format("{}, ", dim);
+    }
+    if (shape.size() > 1) {
+        dims.resize(dims.size() - 2);
+    } else if (!shape.empty()) {
+        dims.pop_back();
+    }
+
+    std::string dict =
+        fmt::format("{{'descr': '{}', 'fortran_order': False, 'shape': ({}), }}",
+                    npy_descr(dtype), dims);
+
+    // Magic, version and header length take 10 bytes; the header ends with a newline
+    size_t total = 10 + dict.size() + 1;
+    dict.append((64 - total % 64) % 64, ' ');
+    dict.push_back('\n');
+
+    std::string header{"\x93NUMPY\x01\x00", 8};
+    put(header, static_cast<std::uint16_t>(dict.size()));
+    return header + dict;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Constructor
+//
+// ---------------------------------------------------------------------------------------
+NumpyWriter::NumpyWriter(const fs::path &path, bool npz) : path_(path), npz_(npz) {
+    if (!npz_) {
+        fs::create_directories(path_);
+        return;
+    }
+    if (path_.has_parent_path()) {
+        fs::create_directories(path_.parent_path());
+    }
+    stream_.open(path_, std::ios::binary);
+    if (!stream_) {
+        throw std::runtime_error(
+            fmt::format("Could not open {} for writing.", path_.string()));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Destructor
+//
+// ---------------------------------------------------------------------------------------
+NumpyWriter::~NumpyWriter() {
+    if (!stream_.is_open()) {
+        return;
+    }
+    try {
+        close();
+    } catch (const std::exception &err) {
+        fmt::print("ERROR: {}\n", err.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write an array
+//
+//   .npz members are stored without compression behind a zip local header; sizes past
+//   4 GiB use the zip64 extra field.
+//
+// ---------------------------------------------------------------------------------------
+void NumpyWriter::write(const std::string &name, const std::string &dtype,
+                        size_t num_rows, int num_components, const void *data) {
+    std::vector<size_t> shape{num_rows};
+    if (num_components > 1) {
+        shape.push_back(static_cast<size_t>(num_components));
+    }
+    const std::string header = npy_header(dtype, shape);
+    const size_t data_size = num_rows * num_components * npy_item_size(dtype);
+
+    if (!npz_) {
+        fs::path file = path_ / (name + ".npy");
+        fs::create_directories(file.parent_path());
+        std::ofstream stream(file, std::ios::binary);
+        stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+        stream.write(static_cast<const char *>(data),
+                     static_cast<std::streamsize>(data_size));
+        if (!stream) {
+            throw std::runtime_error(
+                fmt::format("Could not write to {}.", file.string()));
+        }
+        return;
+    }
+
+    Member member;
+    member.name = name + ".npy";
+    member.size = header.size() + data_size;
+    member.offset = position_;
+    member.crc = crc32(data, data_size, crc32(header.data(), header.size()));
+
+    const bool zip64 = member.size >= ZIP32_LIMIT;
+    const std::uint32_t size32 =
+        zip64 ? static_cast<std::uint32_t>(ZIP32_LIMIT)
+              : static_cast<std::uint32_t>(member.size);
+
+    std::string local;
+    put<std::uint32_t>(local, 0x04034b50);
+    put<std::uint16_t>(local, zip64 ? 45 : 20);  // Version needed
+    put<std::uint16_t>(local, 0);                // Flags
+    put<std::uint16_t>(local, 0);                // Stored
+    put<std::uint16_t>(local, 0);                // Time
+    put<std::uint16_t>(local, 0x21);             // Date (1980-01-01)
+    put<std::uint32_t>(local, member.crc);
+    put<std::uint32_t>(local, size32);
+    put<std::uint32_t>(local, size32);
+    put<std::uint16_t>(local, static_cast<std::uint16_t>(member.name.size()));
+    put<std::uint16_t>(local, zip64 ? 20 : 0);
+    local += member.name;
+    if (zip64) {
+        put<std::uint16_t>(local, 0x0001);
+        put<std::uint16_t>(local, 16);
+        put<std::uint64_t>(local, member.size);
+        put<std::uint64_t>(local, member.size);
+    }
+
+    stream_.write(local.data(), static_cast<std::streamsize>(local.size()));
+    stream_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    stream_.write(static_cast<const char *>(data),
+                  static_cast<std::streamsize>(data_size));
+    if (!stream_) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", path_.string()));
+    }
+
+    position_ += local.size() + member.size;
+    members_.push_back(std::move(member));
+}
+
+void NumpyWriter::write(const std::string &name, vtkDataArray *array) {
+    std::string dtype = store_dtype(array->GetDataType());
+    if (dtype.empty()) {
+        throw std::runtime_error(fmt::format("Unsupported data type {} of array {}.",
+                                             array->GetDataTypeAsString(), name));
+    }
+    write(name, dtype, static_cast<size_t>(array->GetNumberOfTuples()),
+          array->GetNumberOfComponents(), array->GetVoidPointer(0));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Close the .npz archive (central directory and end records)
+//
+// ---------------------------------------------------------------------------------------
+void NumpyWriter::close() {
+    if (!npz_) {
+        return;
+    }
+
+    std::string directory;
+    for (const auto &member : members_) {
+        const bool large_size = member.size >= ZIP32_LIMIT;
+        const bool large_offset = member.offset >= ZIP32_LIMIT;
+
+        std::string extra;
+        if (large_size || large_offset) {
+            put<std::uint16_t>(extra, 0x0001);
+            put<std::uint16_t>(extra, (large_size ? 16 : 0) + (large_offset ? 8 : 0));
+            if (large_size) {
+                put<std::uint64_t>(extra, member.size);
+                put<std::uint64_t>(extra, member.size);
+            }
+            if (large_offset) {
+                put<std::uint64_t>(extra, member.offset);
+            }
+        }
+
+        put<std::uint32_t>(directory, 0x02014b50);
+        put<std::uint16_t>(directory, 45);  // Version made by
+        put<std::uint16_t>(directory, extra.empty() ? 20 : 45);
+        put<std::uint16_t>(directory, 0);
+        put<std::uint16_t>(directory, 0);
+        put<std::uint16_t>(directory, 0);
+        put<std::uint16_t>(directory, 0x21);
+        put<std::uint32_t>(directory, member.crc);
+        const auto size32 =
+            static_cast<std::uint32_t>(std::min(member.size, ZIP32_LIMIT));
+        put<std::uint32_t>(directory, size32);
+        put<std::uint32_t>(directory, size32);
+        put<std::uint16_t>(directory, static_cast<std::uint16_t>(member.name.size()));
+        put<std::uint16_t>(directory, static_cast<std::uint16_t>(extra.size()));
+        put<std::uint16_t>(directory, 0);  // Comment
+        put<std::uint16_t>(directory, 0);  // Disk
+        put<std::uint16_t>(directory, 0);  // Internal attributes
+        put<std::uint32_t>(directory, 0);  // External attributes
+        put<std::uint32_t>(
+            directory, static_cast<std::uint32_t>(std::min(member.offset, ZIP32_LIMIT)));
+        directory += member.name;
+        directory += extra;
+    }
+
+    const std::uint64_t directory_offset = position_;
+    const std::uint64_t num_members = members_.size();
+    const bool zip64 = directory_offset >= ZIP32_LIMIT || num_members >= 0xFFFF;
+
+    std::string end;
+    if (zip64) {
+        const std::uint64_t record_offset = directory_offset + directory.size();
+        put<std::uint32_t>(end, 0x06064b50);
+        put<std::uint64_t>(end, 44);
+        put<std::uint16_t>(end, 45);
+        put<std::uint16_t>(end, 45);
+        put<std::uint32_t>(end, 0);
+        put<std::uint32_t>(end, 0);
+        put<std::uint64_t>(end, num_members);
+        put<std::uint64_t>(end, num_members);
+        put<std::uint64_t>(end, directory.size());
+        put<std::uint64_t>(end, directory_offset);
+
+        put<std::uint32_t>(end, 0x07064b50);
+        put<std::uint32_t>(end, 0);
+        put<std::uint64_t>(end, record_offset);
+        put<std::uint32_t>(end, 1);
+    }
+    put<std::uint32_t>(end, 0x06054b50);
+    put<std::uint16_t>(end, 0);
+    put<std::uint16_t>(end, 0);
+    const auto num_members16 =
+        static_cast<std::uint16_t>(std::min<std::uint64_t>(num_members, 0xFFFF));
+    put<std::uint16_t>(end, num_members16);
+    put<std::uint16_t>(end, num_members16);
+    put<std::uint32_t>(end, static_cast<std::uint32_t>(directory.size()));
+    put<std::uint32_t>(
+        end, static_cast<std::uint32_t>(std::min(directory_offset, ZIP32_LIMIT)));
+    put<std::uint16_t>(end, 0);
+
+    stream_.write(directory.data(), static_cast<std::streamsize>(directory.size()));
+    stream_.write(end.data(), static_cast<std::streamsize>(end.size()));
+    stream_.close();
+    if (!stream_) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", path_.string()));
+    }
+}
+
+}  // namespace otk
@@ -1,12 +1,15 @@
 #include "otk/odb.hpp"
 
 #include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include <fmt/format.h>
@@ -15,10 +18,34 @@
 #include <odb_MaterialTypes.h>
 #include <odb_SectionTypes.h>
 
+#include "otk/element_scan.hpp"
+
 using namespace nlohmann;
 
 namespace otk {
 
+// ---------------------------------------------------------------------------------------
+//
+//   ODB API session
+//
+// ---------------------------------------------------------------------------------------
+static bool session_active = false;
+
+OdbSession::OdbSession() {
+    if (session_active) {
+        throw std::runtime_error("The ODB API is already initialized.");
+    }
+    odb_initializeAPI();
+    session_active = true;
+}
+
+OdbSession::~OdbSession() {
+    odb_finalizeAPI();
+    session_active = false;
+}
+
+bool OdbSession::active() { return session_active; }
+
 // ---------------------------------------------------------------------------------------
 //
 //   Constructor
@@ -31,8 +58,9 @@ Odb::Odb(fs::path path) {
     if (path.extension().string() != ".odb") {
         throw std::runtime_error("File is not an ODB file.");
     }
-
-    odb_initializeAPI();
+    if (!OdbSession::active()) {
+        throw std::runtime_error("The ODB API is not initialized (no otk::OdbSession).");
+    }
 
     odb_ = &openOdb(path.string().c_str());
     path_ = path;
@@ -43,11 +71,7 @@ Odb::Odb(fs::path path) {
 //   Destructor
 //
 // ---------------------------------------------------------------------------------------
-Odb::~Odb() {
-    odb_->close();
-
-    odb_finalizeAPI();
-}
+Odb::~Odb() { odb_->close(); }
 
 // ---------------------------------------------------------------------------------------
 //
@@ -132,62 +156,14 @@ void Odb::nodes_info(const std::string &instance, bool verbose) const {
 //
 // ---------------------------------------------------------------------------------------
 void Odb::elements_info(const std::string &instance, bool verbose) const {
-    odb_Assembly &root_assembly = odb_->rootAssembly();
-    const odb_Instance &instance_object =
-        root_assembly.instances().constGet(instance.c_str());
-    const odb_SequenceElement &instance_elements = instance_object.elements();
-
-    int number_elements = instance_elements.size();
-
-    auto get_section_category_name = [](const odb_SectionCategory &section_category) {
-        std::string section_category_raw_name{section_category.name().CStr()};
-        std::string section_category_name;
-
-        if (section_category_raw_name.find("shell < composite >") != std::string::npos) {
-            section_category_name = "Shell composite";
-        } else if (section_category_raw_name.find("shell") != std::string::npos) {
-            section_category_name = "Shell";
-        } else if (section_category_raw_name.find("solid < composite >") !=
-                   std::string::npos) {
-            section_category_name = "Solid composite";
-        } else if (section_category_raw_name.find("solid") != std::string::npos) {
-            section_category_name = "Solid";
-        } else {
-            section_category_name = "Other";
-        }
-
-        return section_category_name;
-    };
-
-    std::map<std::string, int> element_types;
-    std::map<std::string, int> section_categories;
-    for (int i = 0; i < number_elements; ++i) {
-        const odb_Element &element = instance_elements[i];
-        const odb_SectionCategory &section_category = element.sectionCategory();
-
-        std::string element_type = element.type().CStr();
-        std::string section_category_raw_name{section_category.name().CStr()};
-        std::string section_category_name = get_section_category_name(section_category);
+    ElementData elements = this->elements(instance);
+    ElementScan scan = scan_elements(elements);
 
-        if (auto it = element_types.find(element_type); it != element_types.end()) {
-            it->second++;
-        } else {
-            element_types[element_type] = 1;
-        }
-
-        if (auto it = section_categories.find(section_category_name);
-            it != section_categories.end()) {
-            it->second++;
-        } else {
-            section_categories[section_category_name] = 1;
-        }
-    }
-
-    fmt::print(".... Number of elements: {}\n", number_elements);
-    for (const auto &[element_type, count] : element_types) {
+    fmt::print(".... Number of elements: {}\n", elements.labels.size());
+    for (const auto &[element_type, count] : scan.element_types) {
         fmt::print("...... {} elements: {} \n", element_type, count);
     }
-    for (const auto &[section_category, count] : section_categories) {
+    for (const auto &[section_category, count] : scan.section_categories) {
         fmt::print("...... {} sections: {} \n", section_category, count);
     }
 
@@ -195,19 +171,13 @@ void Odb::elements_info(const std::string &instance, bool verbose) const {
         fmt::print("       | {:^11} | {:^11} | {:^19} | {}\n", "Label", "Type", "Section",
                    "Connectivity");
 
-        for (int i = 0; i < number_elements; ++i) {
-            const odb_Element &element = instance_elements[i];
-            int num_nodes = 0;
-            const int *const element_connectivity = element.connectivity(num_nodes);
-            const odb_SectionCategory &section_category = element.sectionCategory();
-            std::string section_category_name =
-                get_section_category_name(section_category);
-
-            fmt::print("       | {:^11d} | {:^11} | {:^19} | ", element.label(),
-                       element.type().CStr(), section_category_name);
+        for (size_t i = 0; i < elements.labels.size(); ++i) {
+            fmt::print("       | {:^11d} | {:^11} | {:^19} | ", elements.labels[i],
+                       elements.type_names[elements.types[i]],
+                       scan.category_names[elements.sections[i]]);
 
-            for (int j = 0; j < num_nodes; ++j) {
-                fmt::print("{} ", element_connectivity[j]);
+            for (int j = elements.offsets[i]; j < elements.offsets[i + 1]; ++j) {
+                fmt::print("{} ", elements.connectivity[j]);
             }
             fmt::print("\n");
         }
@@ -370,137 +340,592 @@ void Odb::fields_info(const std::string &step, int frame, bool verbose) const {
 
 // ---------------------------------------------------------------------------------------
 //
-//   JSON summary
+//   Conversions from odb_Enum
 //
 // ---------------------------------------------------------------------------------------
-json Odb::field_summary(json &frames) const {
-    json summary;
+static Dimension to_dimension(odb_Enum::odb_DimensionEnum dimension) {
+    switch (dimension) {
+        case odb_Enum::THREE_D:
+            return Dimension::THREE_D;
+        case odb_Enum::TWO_D_PLANAR:
+            return Dimension::TWO_D_PLANAR;
+        case odb_Enum::AXISYMMETRIC:
+            return Dimension::AXISYMMETRIC;
+        default:
+            return Dimension::UNSUPPORTED;
+    }
+}
+
+static DataType to_data_type(odb_Enum::odb_DataTypeEnum data_type) {
+    switch (data_type) {
+        case odb_Enum::SCALAR:
+            return DataType::SCALAR;
+        case odb_Enum::VECTOR:
+            return DataType::VECTOR;
+        case odb_Enum::TENSOR_3D_FULL:
+            return DataType::TENSOR_3D_FULL;
+        case odb_Enum::TENSOR_3D_PLANAR:
+            return DataType::TENSOR_3D_PLANAR;
+        case odb_Enum::TENSOR_2D_PLANAR:
+            return DataType::TENSOR_2D_PLANAR;
+        default:
+            return DataType::UNSUPPORTED;
+    }
+}
 
-    for (auto &frame_data : frames) {
-        auto step_name = frame_data["step"].get<std::string>();
+static Position to_position(odb_Enum::odb_ResultPositionEnum position) {
+    switch (position) {
+        case odb_Enum::NODAL:
+            return Position::NODAL;
+        case odb_Enum::ELEMENT_NODAL:
+            return Position::ELEMENT_NODAL;
+        case odb_Enum::WHOLE_ELEMENT:
+            return Position::WHOLE_ELEMENT;
+        case odb_Enum::INTEGRATION_POINT:
+            return Position::INTEGRATION_POINT;
+        default:
+            return Position::UNSUPPORTED;
+    }
+}
 
-        std::cout << fmt::format("Gathering field info for {}... ", step_name);
-        std::cout << std::flush;
+// ---------------------------------------------------------------------------------------
+//
+//   Instances
+//
+// ---------------------------------------------------------------------------------------
+std::vector<std::string> Odb::instance_names() const {
+    std::vector<std::string> names;
+    odb_InstanceRepositoryIT instance_iterator(odb_->rootAssembly().instances());
+    for (instance_iterator.first(); !instance_iterator.isDone();
+         instance_iterator.next()) {
+        names.push_back(instance_iterator.currentKey().CStr());
+    }
+    return names;
+}
 
-        const odb_Step &step = odb_->steps().constGet(step_name.c_str());
-        const odb_SequenceFrame &frames = step.frames();
+Dimension Odb::dimension(const std::string &instance) const {
+    const odb_Instance &instance_object =
+        odb_->rootAssembly().instances().constGet(instance.c_str());
+    return to_dimension(instance_object.embeddedSpace());
+}
 
-        std::vector<int> frame_ids;
-        if (frame_data.contains("list")) {
-            frame_ids = frame_data["list"].get<std::vector<int>>();
-        } else {
-            frame_ids.resize(frames.size(), 0);
-            std::iota(frame_ids.begin(), frame_ids.end(), 0);
-            frame_data["list"] = frame_ids;
-        }
+int Odb::num_nodes(const std::string &instance) const {
+    return odb_->rootAssembly().instances().constGet(instance.c_str()).nodes().size();
+}
 
-        json step_json;
-        step_json["name"] = std::string{step.name().CStr()};
+int Odb::num_elements(const std::string &instance) const {
+    return odb_->rootAssembly().instances().constGet(instance.c_str()).elements().size();
+}
 
-        for (auto &frame_id : frame_ids) {
-            const odb_Frame &frame = frames.constGet(frame_id);
-            json frame_json;
+NodeData Odb::nodes(const std::string &instance) const {
+    const odb_Instance &instance_object =
+        odb_->rootAssembly().instances().constGet(instance.c_str());
+    const bool is_3d = (instance_object.embeddedSpace() == odb_Enum::THREE_D);
+    const odb_SequenceNode &instance_nodes = instance_object.nodes();
+    int number_nodes = instance_nodes.size();
 
-            frame_json["index"] = frame_id;
-            frame_json["id"] = frame.frameId();
-            frame_json["increment"] = frame.incrementNumber();
-            frame_json["value"] = frame.frameValue();
+    NodeData data;
+    data.labels.resize(number_nodes);
+    data.coordinates.resize(3 * static_cast<size_t>(number_nodes));
+
+    for (int i = 0; i < number_nodes; ++i) {
+        const odb_Node &node = instance_nodes[i];
+        const float *const coordinates = node.coordinates();
+        data.labels[i] = node.label();
+        data.coordinates[3 * i + 0] = coordinates[0];
+        data.coordinates[3 * i + 1] = coordinates[1];
+        data.coordinates[3 * i + 2] = is_3d ? coordinates[2] : 0.0f;
+    }
+    return data;
+}
 
-            const odb_FieldOutputRepository &field_outputs = frame.fieldOutputs();
-            const odb_SequenceString &field_names = field_outputs.getFieldOutputNames();
-            int num_fields = field_names.size();
+ElementData Odb::elements(const std::string &instance) const {
+    const odb_Instance &instance_object =
+        odb_->rootAssembly().instances().constGet(instance.c_str());
+    const odb_SequenceElement &instance_elements = instance_object.elements();
+    int number_elements = instance_elements.size();
 
-            for (int ifield = 0; ifield < num_fields; ++ifield) {
-                json field_json;
-                field_json["name"] = std::string{field_names[ifield].CStr()};
-                frame_json["fields"].push_back(field_json);
-            }
-            step_json["frames"].push_back(frame_json);
+    ElementData data;
+    data.labels.resize(number_elements);
+    data.types.resize(number_elements);
+    data.sections.resize(number_elements);
+    data.offsets.resize(number_elements + 1, 0);
+
+    std::unordered_map<std::string, int> type_ids;
+    std::unordered_map<std::string, int> section_ids;
+    auto intern = [](std::unordered_map<std::string, int> &ids,
+                     std::vector<std::string> &names, const char *name) {
+        auto [it, inserted] = ids.try_emplace(name, static_cast<int>(names.size()));
+        if (inserted) {
+            names.push_back(it->first);
         }
-        summary["steps"].push_back(step_json);
+        return it->second;
+    };
 
-        std::cout << "done.\n" << std::flush;
+    for (int i = 0; i < number_elements; ++i) {
+        const odb_Element &element = instance_elements[i];
+        int num_nodes = 0;
+        const int *const element_connectivity = element.connectivity(num_nodes);
+
+        data.labels[i] = element.label();
+        data.types[i] = intern(type_ids, data.type_names, element.type().CStr());
+        data.sections[i] = intern(section_ids, data.section_names,
+                                  element.sectionCategory().name().CStr());
+        data.connectivity.insert(data.connectivity.end(), element_connectivity,
+                                 element_connectivity + num_nodes);
+        data.offsets[i + 1] = static_cast<int>(data.connectivity.size());
     }
-    return summary;
+    return data;
 }
 
 // ---------------------------------------------------------------------------------------
 //
-//   Instance summary
+//   Sets
 //
 // ---------------------------------------------------------------------------------------
-json Odb::instance_summary() const {
-    json summary;
+std::vector<int> Odb::node_set(const std::string &instance,
+                               const std::string &name) const {
+    const odb_Instance &instance_object =
+        odb_->rootAssembly().instances().constGet(instance.c_str());
+    if (!instance_object.nodeSets().isMember(name.c_str())) {
+        throw std::runtime_error(
+            fmt::format("Node set {} not found in {}.", name, instance));
+    }
+    const odb_SequenceNode &set_nodes =
+        instance_object.nodeSets().constGet(name.c_str()).nodes();
 
-    odb_Assembly &root_assembly = odb_->rootAssembly();
-    odb_InstanceRepositoryIT instance_iterator(root_assembly.instances());
+    std::vector<int> labels(set_nodes.size());
+    for (int i = 0; i < set_nodes.size(); ++i) {
+        labels[i] = set_nodes[i].label();
+    }
+    return labels;
+}
 
-    std::cout << "Gathering info about the instances... " << std::flush;
+std::vector<int> Odb::element_set(const std::string &instance,
+                                  const std::string &name) const {
+    const odb_Instance &instance_object =
+        odb_->rootAssembly().instances().constGet(instance.c_str());
+    if (!instance_object.elementSets().isMember(name.c_str())) {
+        throw std::runtime_error(
+            fmt::format("Element set {} not found in {}.", name, instance));
+    }
+    const odb_SequenceElement &set_elements =
+        instance_object.elementSets().constGet(name.c_str()).elements();
 
-    for (instance_iterator.first(); !instance_iterator.isDone();
-         instance_iterator.next()) {
-        const std::string instance_name{instance_iterator.currentKey().CStr()};
-        const odb_Instance &instance_object = instance_iterator.currentValue();
-        const odb_SequenceElement &instance_elements = instance_object.elements();
-        int number_elements = instance_elements.size();
-
-        auto get_section_category_name = [](const odb_SectionCategory &section_category) {
-            std::string section_category_raw_name{section_category.name().CStr()};
-            std::string section_category_name;
-
-            if (section_category_raw_name.find("shell < composite >") !=
-                std::string::npos) {
-                section_category_name = "Shell composite";
-            } else if (section_category_raw_name.find("shell") != std::string::npos) {
-                section_category_name = "Shell";
-            } else if (section_category_raw_name.find("solid < composite >") !=
-                       std::string::npos) {
-                section_category_name = "Solid composite";
-            } else if (section_category_raw_name.find("solid") != std::string::npos) {
-                section_category_name = "Solid";
+    std::vector<int> labels(set_elements.size());
+    for (int i = 0; i < set_elements.size(); ++i) {
+        labels[i] = set_elements[i].label();
+    }
+    return labels;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Steps and frames
+//
+// ---------------------------------------------------------------------------------------
+std::vector<std::string> Odb::step_names() const {
+    std::vector<std::string> names;
+    odb_StepRepositoryIT step_iterator(odb_->steps());
+    for (step_iterator.first(); !step_iterator.isDone(); step_iterator.next()) {
+        names.push_back(step_iterator.currentKey().CStr());
+    }
+    return names;
+}
+
+int Odb::num_frames(const std::string &step) const {
+    return odb_->steps().constGet(step.c_str()).frames().size();
+}
+
+FrameInfo Odb::frame(const std::string &step, int frame) const {
+    const odb_Frame &frame_object =
+        odb_->steps().constGet(step.c_str()).frames().constGet(frame);
+    return {frame_object.frameId(), frame_object.incrementNumber(),
+            frame_object.frameValue()};
+}
+
+std::vector<std::string> Odb::field_names(const std::string &step, int frame) const {
+    const odb_Frame &frame_object =
+        odb_->steps().constGet(step.c_str()).frames().constGet(frame);
+    const odb_SequenceString &names = frame_object.fieldOutputs().getFieldOutputNames();
+
+    std::vector<std::string> field_names;
+    for (int i = 0; i < names.size(); ++i) {
+        field_names.push_back(names[i].CStr());
+    }
+    return field_names;
+}
+
+FieldInfo Odb::field_info(const std::string &step, int frame,
+                          const std::string &field) const {
+    const odb_Frame &frame_object =
+        odb_->steps().constGet(step.c_str()).frames().constGet(frame);
+    const odb_FieldOutput &field_output =
+        frame_object.fieldOutputs().constGet(field.c_str());
+    const odb_SequenceFieldLocation &locations = field_output.locations();
+
+    FieldInfo info;
+    info.name = field;
+    info.type = to_data_type(field_output.type());
+    info.width = field_output.componentLabels().size();
+    for (int i = 0; i < locations.size(); ++i) {
+        info.positions.push_back(to_position(locations[i].position()));
+    }
+    return info;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   History regions and outputs of a step
+//
+// ---------------------------------------------------------------------------------------
+std::vector<std::string> Odb::history_region_names(const std::string &step) const {
+    std::vector<std::string> names;
+    odb_HistoryRegionRepositoryIT region_iterator(
+        odb_->steps().constGet(step.c_str()).historyRegions());
+    for (region_iterator.first(); !region_iterator.isDone(); region_iterator.next()) {
+        names.push_back(region_iterator.currentKey().CStr());
+    }
+    return names;
+}
+
+std::vector<std::string> Odb::history_output_names(const std::string &step,
+                                                   const std::string &region) const {
+    const odb_HistoryRegion &region_object =
+        odb_->steps().constGet(step.c_str()).historyRegions().constGet(region.c_str());
+
+    std::vector<std::string> names;
+    odb_HistoryOutputRepositoryIT output_iterator(region_object.historyOutputs());
+    for (output_iterator.first(); !output_iterator.isDone(); output_iterator.next()) {
+        names.push_back(output_iterator.currentKey().CStr());
+    }
+    return names;
+}
+
+HistoryData Odb::history_output(const std::string &step, const std::string &region,
+                                const std::string &output) const {
+    const odb_HistoryOutput &output_object = odb_->steps()
+                                                 .constGet(step.c_str())
+                                                 .historyRegions()
+                                                 .constGet(region.c_str())
+                                                 .historyOutputs()
+                                                 .constGet(output.c_str());
+    const odb_SequenceSequenceFloat &pairs = output_object.data();
+    int num_pairs = pairs.size();
+
+    HistoryData data;
+    data.name = output;
+    data.description = output_object.description().CStr();
+    data.time.resize(num_pairs);
+    data.values.resize(num_pairs);
+    for (int i = 0; i < num_pairs; ++i) {
+        const odb_SequenceFloat &pair = pairs[i];
+        data.time[i] = pair.constGet(0);
+        data.values[i] = pair.constGet(1);
+    }
+    return data;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Node or element set of the given labels, created once and then reused (the name
+//   is derived from a hash of the labels)
+//
+// ---------------------------------------------------------------------------------------
+static odb_Set get_label_set(odb_Instance &instance, const std::vector<int> &labels,
+                             bool nodes) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const auto &label : labels) {
+        hash = (hash ^ static_cast<std::uint32_t>(label)) * 1099511628211ull;
+    }
+    const std::string name = fmt::format("OTK_{}_{:016X}", nodes ? "N" : "E", hash);
+    const odb_String set_name{name.c_str()};
+
+    if (nodes) {
+        if (instance.nodeSets().isMember(set_name)) {
+            return instance.nodeSets().get(set_name);
+        }
+        odb_SequenceNode set_nodes(instance);
+        for (const auto &label : labels) {
+            set_nodes.append(instance.getNodeFromLabel(label));
+        }
+        return instance.NodeSet(set_name, set_nodes);
+    }
+
+    if (instance.elementSets().isMember(set_name)) {
+        return instance.elementSets().get(set_name);
+    }
+    odb_SequenceElement set_elements(instance);
+    for (const auto &label : labels) {
+        set_elements.append(instance.getElementFromLabel(label));
+    }
+    return instance.ElementSet(set_name, set_elements);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Field outputs of an instance
+//
+// ---------------------------------------------------------------------------------------
+FieldData Odb::field_data(const std::string &step, int frame, const std::string &field,
+                          const std::string &instance, const ElementGroups &groups,
+                          bool composite, const std::vector<int> &region_nodes) const {
+    // Localized field outputs own the bulk data blocks viewed by FieldData
+    struct Storage {
+        std::deque<odb_FieldOutput> fields;
+    };
+    auto storage = std::make_shared<Storage>();
+
+    FieldData data;
+    data.name = field;
+    data.storage = storage;
+
+    const odb_Frame &frame_object =
+        odb_->steps().constGet(step.c_str()).frames().constGet(frame);
+    const odb_FieldOutput &field_output =
+        frame_object.fieldOutputs().constGet(field.c_str());
+    odb_Instance &instance_object =
+        odb_->rootAssembly().instances().get(instance.c_str());
+
+    const odb_FieldOutput &instance_field = field_output.getSubset(instance_object);
+    const odb_SequenceFieldLocation &instance_locations = instance_field.locations();
+    if (instance_locations.size() == 0) {
+        return data;
+    }
+    data.type = to_data_type(instance_field.type());
+    data.engineering = instance_field.isEngineeringTensor();
+    const bool has_orientation = instance_field.hasOrientation();
+
+    auto append_blocks = [&](const odb_FieldOutput &localized_field, Position position) {
+        storage->fields.push_back(localized_field);
+        const odb_SequenceFieldBulkData &blocks = storage->fields.back().bulkDataBlocks();
+        int num_blocks = blocks.size();
+        for (int iblock = 0; iblock < num_blocks; ++iblock) {
+            const odb_FieldBulkData &block = blocks[iblock];
+            FieldBlock view{position, Precision::SINGLE, block.width(), 0,
+                            nullptr,  nullptr,           nullptr};
+            if (position == Position::WHOLE_ELEMENT) {
+                view.length = block.numberOfElements();
+                view.labels = block.elementLabels();
+            } else {
+                view.length = block.numberOfNodes();
+                view.labels = block.nodeLabels();
+            }
+            if (block.precision() == odb_Enum::odb_PrecisionEnum::DOUBLE_PRECISION) {
+                view.precision = Precision::DOUBLE;
+                view.data_double = block.dataDouble();
             } else {
-                section_category_name = "Other";
+                view.data = block.data();
+            }
+            if (has_orientation) {
+                view.orientation_width = block.orientationWidth();
+                if (view.precision == Precision::DOUBLE) {
+                    view.orientation_double = block.localCoordSystemDouble();
+                } else {
+                    view.orientation = block.localCoordSystem();
+                }
             }
+            data.blocks.push_back(view);
+        }
+    };
 
-            return section_category_name;
-        };
+    // Nodal results have no section points, so the instance subset is used directly
+    bool nodal_only = true;
+    for (int i = 0; i < instance_locations.size(); ++i) {
+        if (instance_locations[i].position() != odb_Enum::NODAL) {
+            nodal_only = false;
+        }
+    }
+    if (nodal_only) {
+        // Restrict to the nodes of the region of interest (computed once per instance
+        // by the caller, so the cost per frame scales with the region)
+        if (region_nodes.empty()) {
+            append_blocks(instance_field, Position::NODAL);
+            return data;
+        }
+        odb_Set set = get_label_set(instance_object, region_nodes, true);
+        append_blocks(instance_field.getSubset(set), Position::NODAL);
+        return data;
+    }
 
-        std::set<std::string> element_types;
-        std::set<std::string> section_categories;
-        for (int i = 0; i < number_elements; ++i) {
-            const odb_Element &element = instance_elements[i];
-            const odb_SectionCategory &section_category = element.sectionCategory();
+    for (const auto &[key, labels] : groups) {
+        const odb_String set_name{key.c_str()};
+        odb_Set set;
+        if (instance_object.elementSets().isMember(set_name) == false) {
+            odb_SequenceElement elements(instance_object);
+            for (const auto &label : labels) {
+                elements.append(instance_object.getElementFromLabel(label));
+            }
+            set = instance_object.ElementSet(set_name, elements);
+        } else {
+            set = instance_object.elementSets().get(set_name);
+        }
 
-            std::string element_type = element.type().CStr();
-            std::string section_category_raw_name{section_category.name().CStr()};
-            std::string section_category_name =
-                get_section_category_name(section_category);
+        odb_FieldOutput localized_field = instance_field.getSubset(set);
 
-            element_types.insert(element_type);
-            section_categories.insert(section_category_name);
+        const odb_SequenceFieldLocation locations = localized_field.locations();
+        int num_locations = locations.size();
+        if (num_locations == 0) {
+            continue;
         }
 
-        bool supported = true;
-        bool has_composite_section = false;
-        bool has_non_composite_section = false;
-        for (const auto &section_category : section_categories) {
-            if (section_category.find("composite") != std::string::npos) {
-                has_composite_section = true;
-            } else {
-                has_non_composite_section = true;
+        bool requires_extrapolation = false;  // Interpolation to nodes
+        bool may_require_reduction = false;   // Reduction across section points
+        int location_index = 0;
+        for (int ilocation = 0; ilocation < num_locations; ++ilocation) {
+            switch (locations[ilocation].position()) {
+                case odb_Enum::odb_ResultPositionEnum::WHOLE_ELEMENT:
+                    location_index = ilocation;
+                    break;
+                case odb_Enum::odb_ResultPositionEnum::NODAL:
+                    location_index = ilocation;
+                    break;
+                case odb_Enum::odb_ResultPositionEnum::INTEGRATION_POINT:
+                    location_index = ilocation;
+                    requires_extrapolation = true;
+                    may_require_reduction = true;
+                    break;
+                default:
+                    fmt::print("Unsupported field output position for {} {} ({}).\n",
+                               field, instance,
+                               static_cast<int>(locations[ilocation].position()));
+                    data.blocks.clear();
+                    return data;
             }
         }
-        supported = !(has_composite_section && has_non_composite_section);
+        const odb_FieldLocation location = locations[location_index];
+        localized_field = localized_field.getSubset(location);
+
+        const odb_SequenceSectionPoint section_pts =
+            localized_field.locations()[0].sectionPoint();
+        int num_section_pts = section_pts.size();
 
-        summary[instance_name]["element_types"] = element_types;
-        summary[instance_name]["section_categories"] = section_categories;
-        summary[instance_name]["supported"] = supported;
-        summary[instance_name]["composite"] = has_composite_section;
+        if (requires_extrapolation) {
+            localized_field = localized_field.getSubset(
+                odb_Enum::odb_ResultPositionEnum::ELEMENT_NODAL);
+        }
+        if (composite && may_require_reduction) {
+            odb_SequenceFieldOutput composite_fields(num_section_pts);
+            for (int i = 0; i < num_section_pts; ++i) {
+                const odb_SectionPoint section_pt = section_pts.constGet(i);
+                odb_FieldOutput temp_field = localized_field.getSubset(section_pt);
+                temp_field = abs(temp_field);
+                composite_fields.append(temp_field);
+            }
+            composite_fields.append(localized_field);
+            composite_fields = maxEnvelope(composite_fields);
+            localized_field = composite_fields[0];
+        }
+
+        Position position = Position::NODAL;
+        if (location.position() == odb_Enum::odb_ResultPositionEnum::WHOLE_ELEMENT) {
+            position = Position::WHOLE_ELEMENT;
+        } else if (requires_extrapolation) {
+            position = Position::ELEMENT_NODAL;
+        }
+        append_blocks(localized_field, position);
+    }
+    return data;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Field output values at selected nodes and elements
+//
+//   The field is restricted to a set of the selected labels before the bulk data is
+//   requested, so only those entries are read from the ODB.
+//
+// ---------------------------------------------------------------------------------------
+FieldData Odb::field_values(const std::string &step, int frame, const std::string &field,
+                            const std::string &instance,
+                            const std::vector<int> &node_labels,
+                            const std::vector<int> &element_labels) const {
+    struct Storage {
+        std::deque<odb_FieldOutput> fields;
+    };
+    auto storage = std::make_shared<Storage>();
+
+    FieldData data;
+    data.name = field;
+    data.storage = storage;
+
+    const odb_Frame &frame_object =
+        odb_->steps().constGet(step.c_str()).frames().constGet(frame);
+    const odb_FieldOutput &field_output =
+        frame_object.fieldOutputs().constGet(field.c_str());
+    odb_Instance &instance_object =
+        odb_->rootAssembly().instances().get(instance.c_str());
+
+    const odb_FieldOutput &instance_field = field_output.getSubset(instance_object);
+    const odb_SequenceFieldLocation &locations = instance_field.locations();
+    if (locations.size() == 0) {
+        return data;
+    }
+    data.type = to_data_type(instance_field.type());
+    data.engineering = instance_field.isEngineeringTensor();
+    const bool has_orientation = instance_field.hasOrientation();
+
+    // Nodal results are selected by node, everything else by element
+    Position position = Position::NODAL;
+    int location_index = -1;
+    for (int i = 0; i < locations.size(); ++i) {
+        switch (locations[i].position()) {
+            case odb_Enum::odb_ResultPositionEnum::NODAL:
+                if (location_index < 0) {
+                    location_index = i;
+                }
+                break;
+            case odb_Enum::odb_ResultPositionEnum::WHOLE_ELEMENT:
+                location_index = i;
+                position = Position::WHOLE_ELEMENT;
+                break;
+            case odb_Enum::odb_ResultPositionEnum::INTEGRATION_POINT:
+                location_index = i;
+                position = Position::INTEGRATION_POINT;
+                break;
+            default:
+                break;
+        }
+    }
+    if (location_index < 0) {
+        fmt::print("Unsupported field output position for {} {}.\n", field, instance);
+        return data;
     }
 
-    std::cout << "done.\n" << std::flush;
+    const std::vector<int> &labels =
+        (position == Position::NODAL) ? node_labels : element_labels;
+    if (labels.empty()) {
+        return data;
+    }
 
-    return summary;
+    odb_Set set = get_label_set(instance_object, labels, position == Position::NODAL);
+    storage->fields.push_back(
+        instance_field.getSubset(set).getSubset(locations[location_index]));
+
+    const odb_SequenceFieldBulkData &blocks = storage->fields.back().bulkDataBlocks();
+    for (int iblock = 0; iblock < blocks.size(); ++iblock) {
+        const odb_FieldBulkData &block = blocks[iblock];
+        FieldBlock view{position, Precision::SINGLE, block.width(), block.length(),
+                        nullptr,  nullptr,           nullptr};
+        view.labels = (position == Position::NODAL) ? block.nodeLabels()
+                                                    : block.elementLabels();
+        if (block.precision() == odb_Enum::odb_PrecisionEnum::DOUBLE_PRECISION) {
+            view.precision = Precision::DOUBLE;
+            view.data_double = block.dataDouble();
+        } else {
+            view.data = block.data();
+        }
+        if (has_orientation) {
+            view.orientation_width = block.orientationWidth();
+            if (view.precision == Precision::DOUBLE) {
+                view.orientation_double = block.localCoordSystemDouble();
+            } else {
+                view.orientation = block.localCoordSystem();
+            }
+        }
+        data.blocks.push_back(view);
+    }
+    return data;
 }
 
 }  // namespace otk
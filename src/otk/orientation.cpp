@@ -0,0 +1,187 @@
+#include "otk/orientation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Data types with orientation
+//
+// ---------------------------------------------------------------------------------------
+bool is_rotatable(DataType type) {
+    switch (type) {
+        case DataType::VECTOR:
+        case DataType::TENSOR_3D_FULL:
+        case DataType::TENSOR_3D_PLANAR:
+        case DataType::TENSOR_2D_PLANAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+DataType rotated_type(DataType type) {
+    if (is_rotatable(type) && type != DataType::VECTOR) {
+        return DataType::TENSOR_3D_FULL;
+    }
+    return type;
+}
+
+int rotated_width(DataType type) { return type == DataType::VECTOR ? 3 : 6; }
+
+// ---------------------------------------------------------------------------------------
+//
+//   Output axes from three direction vectors
+//
+// ---------------------------------------------------------------------------------------
+Matrix3 make_axes(const std::array<std::array<double, 3>, 3> &directions) {
+    Matrix3 axes;
+    for (int i = 0; i < 3; ++i) {
+        const auto &d = directions[i];
+        const double norm = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        if (norm == 0.0) {
+            throw std::runtime_error(fmt::format("Orientation axis {} is zero.", i + 1));
+        }
+        for (int j = 0; j < 3; ++j) {
+            axes[3 * i + j] = d[j] / norm;
+        }
+    }
+
+    // The rotation is only a change of basis for orthonormal right-handed axes
+    const auto dot = [&axes](int a, int b) {
+        return axes[3 * a] * axes[3 * b] + axes[3 * a + 1] * axes[3 * b + 1] +
+               axes[3 * a + 2] * axes[3 * b + 2];
+    };
+    constexpr int PAIRS[3][2] = {{0, 1}, {1, 2}, {0, 2}};
+    for (const auto &[a, b] : PAIRS) {
+        if (std::abs(dot(a, b)) > AXES_TOLERANCE) {
+            throw std::runtime_error(fmt::format("Orientation axes {} and {} are not "
+                                                 "orthogonal.", a + 1, b + 1));
+        }
+    }
+    const double det = axes[0] * (axes[4] * axes[8] - axes[5] * axes[7]) -
+                       axes[1] * (axes[3] * axes[8] - axes[5] * axes[6]) +
+                       axes[2] * (axes[3] * axes[7] - axes[4] * axes[6]);
+    if (det < 0.0) {
+        throw std::runtime_error("Orientation axes are not right-handed.");
+    }
+    return axes;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Fused rotation of a row: axes x local axes of the quaternion (x, y, z, w)
+//
+// ---------------------------------------------------------------------------------------
+static inline void row_rotation(const Matrix3 &axes, double x, double y, double z,
+                                double w, double *m) {
+    const double r[9]{1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - z * w),
+                      2.0 * (x * z + y * w),       2.0 * (x * y + z * w),
+                      1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - x * w),
+                      2.0 * (x * z - y * w),       2.0 * (y * z + x * w),
+                      1.0 - 2.0 * (x * x + y * y)};
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            m[3 * i + j] = axes[3 * i] * r[j] + axes[3 * i + 1] * r[3 + j] +
+                           axes[3 * i + 2] * r[6 + j];
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Rotate rows to the output axes
+//
+//   The fused matrices of a batch are computed first, then the rows are rotated with
+//   them, so that both loops run without branches on the row.
+//
+// ---------------------------------------------------------------------------------------
+template <typename T>
+void rotate_rows(DataType type, bool engineering, const T *rows, int width,
+                 const T *quaternions, int orientation_width, const Matrix3 &axes,
+                 size_t count, double *out) {
+    if (quaternions && orientation_width < 4) {
+        throw std::runtime_error(
+            fmt::format("Unsupported orientation width ({}).", orientation_width));
+    }
+
+    double matrices[9 * ORIENTATION_BATCH];
+    const double shear = engineering ? 0.5 : 1.0;
+
+    for (size_t first = 0; first < count; first += ORIENTATION_BATCH) {
+        const size_t n = std::min<size_t>(ORIENTATION_BATCH, count - first);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (quaternions) {
+                const T *q = quaternions + (first + i) * orientation_width;
+                row_rotation(axes, q[0], q[1], q[2], q[3], matrices + 9 * i);
+            } else {
+                std::copy(axes.begin(), axes.end(), matrices + 9 * i);
+            }
+        }
+
+        if (type == DataType::VECTOR) {
+            for (size_t i = 0; i < n; ++i) {
+                const T *v = rows + (first + i) * width;
+                const double *m = matrices + 9 * i;
+                const double v1 = v[0];
+                const double v2 = width > 1 ? v[1] : 0.0;
+                const double v3 = width > 2 ? v[2] : 0.0;
+                double *o = out + (first + i) * 3;
+                o[0] = m[0] * v1 + m[1] * v2 + m[2] * v3;
+                o[1] = m[3] * v1 + m[4] * v2 + m[5] * v3;
+                o[2] = m[6] * v1 + m[7] * v2 + m[8] * v3;
+            }
+            continue;
+        }
+
+        const bool planar = type == DataType::TENSOR_2D_PLANAR;
+        const bool full = type == DataType::TENSOR_3D_FULL;
+        for (size_t i = 0; i < n; ++i) {
+            const T *t = rows + (first + i) * width;
+            const double *m = matrices + 9 * i;
+
+            const double t11 = t[0];
+            const double t22 = t[1];
+            const double t33 = planar ? 0.0 : t[2];
+            const double t12 = shear * (planar ? t[2] : t[3]);
+            const double t13 = full ? shear * t[4] : 0.0;
+            const double t23 = full ? shear * t[5] : 0.0;
+
+            // b = m t, then out = b m^T
+            double b[9];
+            for (int k = 0; k < 3; ++k) {
+                const double m1 = m[3 * k];
+                const double m2 = m[3 * k + 1];
+                const double m3 = m[3 * k + 2];
+                b[3 * k] = m1 * t11 + m2 * t12 + m3 * t13;
+                b[3 * k + 1] = m1 * t12 + m2 * t22 + m3 * t23;
+                b[3 * k + 2] = m1 * t13 + m2 * t23 + m3 * t33;
+            }
+            auto product = [&](int r, int c) {
+                return b[3 * r] * m[3 * c] + b[3 * r + 1] * m[3 * c + 1] +
+                       b[3 * r + 2] * m[3 * c + 2];
+            };
+
+            double *o = out + (first + i) * 6;
+            o[0] = product(0, 0);
+            o[1] = product(1, 1);
+            o[2] = product(2, 2);
+            o[3] = product(0, 1) / shear;
+            o[4] = product(0, 2) / shear;
+            o[5] = product(1, 2) / shear;
+        }
+    }
+}
+
+template void rotate_rows<float>(DataType, bool, const float *, int, const float *, int,
+                                 const Matrix3 &, size_t, double *);
+template void rotate_rows<double>(DataType, bool, const double *, int, const double *,
+                                  int, const Matrix3 &, size_t, double *);
+
+}  // namespace otk
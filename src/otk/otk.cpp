@@ -1,27 +1,176 @@
 #include <filesystem>
 #include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <argparse/argparse.hpp>
 
 #include <fmt/format.h>
 #include <nlohmann/json.hpp>
 
+#include "otk/batch.hpp"
 #include "otk/cli.hpp"
 #include "otk/converter.hpp"
+#include "otk/info.hpp"
 #include "otk/odb.hpp"
 #include "otk/output.hpp"
+#include "otk/trace.hpp"
 
 #pragma message("OTK build version: " STR(OTK_VERSION))
 
 namespace fs = std::filesystem;
 
+// ---------------------------------------------------------------------------------------
+//
+//   Batch conversion of several ODB files ("otk batch ...")
+//
+// ---------------------------------------------------------------------------------------
+int batch_main(int argc, char *argv[], const fs::path &executable) {
+    argparse::ArgumentParser options(fmt::format("{} batch", otk::NAME),
+                                     STR(OTK_VERSION));
+
+    options.add_argument("files")
+        .help("ODB files, directories or glob patterns (e.g. results/*.odb)")
+        .remaining();
+    options.add_argument("--list", "-l")
+        .help("Text file with one ODB file, directory or pattern per line")
+        .default_value(std::string{});
+    options.add_argument("--jobs", "-j")
+        .help("Number of worker processes (default: number of hardware threads)")
+        .default_value(static_cast<int>(std::thread::hardware_concurrency()))
+        .scan<'i', int>();
+    options.add_argument("--trace", "-t")
+        .help("Write a Chrome trace-event JSON file per ODB file (<trace>_<odb>.json)")
+        .default_value(std::string{});
+
+    try {
+        options.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        otk::print_header(STR(OTK_VERSION), STR(OTK_BUILD));
+        otk::print_error(err.what(), &options);
+        return 1;
+    }
+
+    try {
+        otk::print_header(STR(OTK_VERSION), STR(OTK_BUILD));
+
+        std::vector<std::string> patterns;
+        if (options.is_used("files")) {
+            patterns = options.get<std::vector<std::string>>("files");
+        }
+        std::vector<fs::path> files =
+            otk::expand_odb_files(patterns, options.get<std::string>("--list"));
+        if (files.empty()) {
+            otk::print_error("No ODB files to convert");
+            return 1;
+        }
+
+        const fs::path trace_file = options.get<std::string>("--trace");
+        int failed = 0;
+        if (int jobs = options.get<int>("--jobs"); jobs > 1 && files.size() > 1) {
+            failed = otk::run_batch(executable, files, jobs, trace_file);
+        } else {
+            otk::OdbSession session;
+            failed = otk::convert_files(files, trace_file);
+        }
+
+        otk::print_footer();
+        return failed == 0 ? 0 : 1;
+    } catch (const odb_Exception &odb_err) {
+        otk::print_error(fmt::format("{}", odb_err.AsString().CStr()));
+        return 1;
+    } catch (const std::exception &err) {
+        otk::print_error(err.what());
+        return 1;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Conversion plan of an ODB file ("otk plan ...")
+//
+// ---------------------------------------------------------------------------------------
+int plan_main(int argc, char *argv[]) {
+    argparse::ArgumentParser options(fmt::format("{} plan", otk::NAME), STR(OTK_VERSION));
+
+    options.add_argument("file").help("ODB file name").default_value(std::string{});
+    options.add_argument("--output", "-o")
+        .help("Write the plan (sizes and frame x field work list) to a JSON file")
+        .default_value(std::string{});
+
+    try {
+        options.parse_args(argc, argv);
+    } catch (const std::exception &err) {
+        otk::print_header(STR(OTK_VERSION), STR(OTK_BUILD));
+        otk::print_error(err.what(), &options);
+        return 1;
+    }
+
+    fs::path file;
+    if (options.get<std::string>("file").empty()) {
+        file = otk::find_file(fs::current_path());
+    } else {
+        file = fs::path{options.get<std::string>("file")};
+    }
+
+    try {
+        otk::print_header(STR(OTK_VERSION), STR(OTK_BUILD));
+
+        otk::OdbSession session;
+        otk::Odb odb{file};
+
+        fs::path json_file =
+            (fs::path{odb.path()} / odb.name()).replace_extension(".json");
+        nlohmann::json output_request = otk::read_output_request(json_file);
+        if (output_request.contains("history")) {
+            otk::print_error("History requests cannot be planned");
+            return 1;
+        }
+
+        otk::Converter converter{output_request};
+        nlohmann::json plan = converter.plan(odb);
+
+        if (auto output_file = options.get<std::string>("--output");
+            !output_file.empty()) {
+            std::ofstream stream(output_file);
+            if (!stream) {
+                throw std::runtime_error(
+                    fmt::format("Could not open {} for writing.", output_file));
+            }
+            stream << plan.dump(2) << '\n';
+            fmt::print("Plan written to {}\n", output_file);
+        }
+
+        otk::print_footer();
+        return 0;
+    } catch (const odb_Exception &odb_err) {
+        otk::print_error(fmt::format("{}", odb_err.AsString().CStr()));
+        return 1;
+    } catch (const std::exception &err) {
+        otk::print_error(err.what());
+        return 1;
+    }
+}
+
 int main(int argc, char *argv[]) {
+    // The positional file argument would swallow sub-commands, so dispatch them first
+    if (argc > 1 && std::string{argv[1]} == "batch") {
+        return batch_main(argc - 1, argv + 1, otk::executable_path(argv[0]));
+    }
+    if (argc > 1 && std::string{argv[1]} == "plan") {
+        return plan_main(argc - 1, argv + 1);
+    }
+
     // -----------------------------------------------------------------------------------
     //
     //   Parse the command line arguments
     //
     // -----------------------------------------------------------------------------------
     argparse::ArgumentParser options(otk::NAME, STR(OTK_VERSION));
+    options.add_epilog(
+        "Use \"otk batch --help\" to convert several ODB files at once and \"otk plan "
+        "--help\" to estimate a conversion before running it.");
 
     options.add_argument("file").help("ODB file name").default_value(std::string{});
     options.add_argument("--info", "-i")
@@ -34,6 +183,12 @@ int main(int argc, char *argv[]) {
         .default_value(false)
         .implicit_value(true)
         .nargs(0);
+    options.add_argument("--info-file")
+        .help("Write the info to a .json or .csv file (with -v: every node and element)")
+        .default_value(std::string{});
+    options.add_argument("--trace", "-t")
+        .help("Write a Chrome trace-event JSON file with the conversion timings")
+        .default_value(std::string{});
 
     try {
         options.parse_args(argc, argv);
@@ -63,42 +218,37 @@ int main(int argc, char *argv[]) {
     try {
         otk::print_header(STR(OTK_VERSION), STR(OTK_BUILD));
 
-        // Open the ODB file
-        otk::Odb odb{file};
+        // Initialize the ODB API (once per process)
+        otk::OdbSession session;
+
+        // Individual trace events are only kept for --trace
+        const std::string trace_file = options.get<std::string>("--trace");
+        otk::Tracer::instance().set_recording(!trace_file.empty());
 
         // Get info on the ODB file if requested
         if (options["--info"] == true) {
+            otk::Odb odb{file};
             otk::print_separator_2();
-            odb.odb_info(options["--verbose"] == true);
+            if (auto info_file = options.get<std::string>("--info-file");
+                !info_file.empty()) {
+                otk::write_info(odb, info_file, options["--verbose"] == true);
+                fmt::print("Info written to {}\n", info_file);
+            } else {
+                odb.odb_info(options["--verbose"] == true);
+            }
             otk::print_footer();
             return 0;
         }
 
-        // Get the json output request
-        fs::path odb_path = odb.path();
-        fs::path json_file = (odb_path / odb.name()).replace_extension(".json");
-        if (!fs::exists(json_file)) {
-            otk::print_error(fmt::format("JSON output request file {} does not exist",
-                                         json_file.string()));
-            return 1;
-        }
-        fmt::print("JSON output request file: {}\n", json_file.string());
-
-        // Read the JSON file
-        using namespace nlohmann;
-        std::ifstream json_stream(json_file);
-        json json_output_request = json::parse(json_stream);
+        // Convert the ODB file to VTK with the JSON output request next to it
+        otk::convert_file(file);
 
-        // Validate the JSON file
-        if (!otk::is_output_request_valid(json_output_request)) {
-            otk::print_error("Invalid JSON output request syntax");
-            return 1;
+        // Report the phase timings
+        otk::Tracer::instance().print_summary();
+        if (!trace_file.empty()) {
+            otk::Tracer::instance().write_chrome_trace(trace_file);
+            fmt::print("Trace written to {}\n", trace_file);
         }
-        fmt::print("JSON output request is valid\n");
-
-        // Convert the ODB file to VTKk
-        otk::Converter converter{json_output_request};
-        converter.convert(odb, file);
 
         otk::print_footer();
         return 0;
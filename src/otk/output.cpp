@@ -1,5 +1,11 @@
 #include "otk/output.hpp"
 
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
 #include <vtkCellArray.h>
 #include <vtkHexahedron.h>
 #include <vtkNew.h>
@@ -13,6 +19,206 @@ using namespace nlohmann;
 
 namespace otk {
 
+// ---------------------------------------------------------------------------------------
+//
+//   Validate the optional "history" object of the output request
+//
+// ---------------------------------------------------------------------------------------
+static bool is_history_request_valid(const json &history_request) {
+    if (!history_request.is_object()) {
+        return false;
+    }
+    if (!history_request.contains("nodes") && !history_request.contains("elements") &&
+        !history_request.contains("regions")) {
+        return false;
+    }
+    if (history_request.contains("regions")) {
+        if (!history_request["regions"].is_array()) {
+            return false;
+        }
+        for (const auto &region : history_request["regions"]) {
+            if (!region.is_string()) {
+                return false;
+            }
+        }
+    }
+    for (const std::string kind : {"nodes", "elements"}) {
+        if (!history_request.contains(kind)) {
+            continue;
+        }
+        if (!history_request[kind].is_array()) {
+            return false;
+        }
+        for (const auto &entry : history_request[kind]) {
+            if (!entry.contains("instance") || !entry["instance"].is_string()) {
+                return false;
+            }
+            if (!entry.contains("labels") && !entry.contains("set")) {
+                return false;
+            }
+            if (entry.contains("labels") && !entry["labels"].is_array()) {
+                return false;
+            }
+            if (entry.contains("set") && !entry["set"].is_string()) {
+                return false;
+            }
+        }
+    }
+    if (history_request.contains("format")) {
+        json formats = history_request["format"];
+        if (formats.is_string()) {
+            formats = json::array({formats});
+        }
+        if (!formats.is_array() || formats.empty()) {
+            return false;
+        }
+        for (const auto &format : formats) {
+            if (format != "csv" && format != "binary") {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Validate the optional "region" object of the output request
+//
+// ---------------------------------------------------------------------------------------
+static bool is_region_request_valid(const json &region_request) {
+    if (!region_request.is_object()) {
+        return false;
+    }
+    if (!region_request.contains("element_sets") &&
+        !region_request.contains("node_sets") && !region_request.contains("box")) {
+        return false;
+    }
+    for (const std::string kind : {"element_sets", "node_sets"}) {
+        if (!region_request.contains(kind)) {
+            continue;
+        }
+        if (!region_request[kind].is_array()) {
+            return false;
+        }
+        for (const auto &entry : region_request[kind]) {
+            if (!entry.contains("instance") || !entry["instance"].is_string()) {
+                return false;
+            }
+            if (!entry.contains("set") || !entry["set"].is_string()) {
+                return false;
+            }
+        }
+    }
+    if (region_request.contains("box")) {
+        const json &box = region_request["box"];
+        if (!box.is_array() || box.size() != 6) {
+            return false;
+        }
+        for (const auto &value : box) {
+            if (!value.is_number()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Non-empty array of strings (e.g. the "components" of a field request)
+//
+// ---------------------------------------------------------------------------------------
+static bool is_string_list(const json &list) {
+    if (!list.is_array() || list.empty()) {
+        return false;
+    }
+    for (const auto &entry : list) {
+        if (!entry.is_string()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Validate the optional "quantize" object of a field request
+//
+// ---------------------------------------------------------------------------------------
+static bool is_quantize_request_valid(const json &quantize_request) {
+    if (!quantize_request.is_object()) {
+        return false;
+    }
+    if (quantize_request.contains("bits") == quantize_request.contains("error")) {
+        return false;
+    }
+    if (quantize_request.contains("bits") && quantize_request["bits"] != 8 &&
+        quantize_request["bits"] != 16) {
+        return false;
+    }
+    if (quantize_request.contains("error") &&
+        (!quantize_request["error"].is_number() || quantize_request["error"] <= 0.0)) {
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Validate the optional "derived" array of the output request (the expressions are
+//   parsed when the conversion starts)
+//
+// ---------------------------------------------------------------------------------------
+static bool is_derived_request_valid(const json &derived_request) {
+    if (!derived_request.is_array() || derived_request.empty()) {
+        return false;
+    }
+    for (const auto &derived : derived_request) {
+        if (!derived.contains("name") || !derived["name"].is_string()) {
+            return false;
+        }
+        if (!derived.contains("expression") || !derived["expression"].is_string()) {
+            return false;
+        }
+        if (derived.contains("quantize") &&
+            !is_quantize_request_valid(derived["quantize"])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Validate the optional "orientation" of the output request ("global", or an object
+//   with "axes" as three direction vectors)
+//
+// ---------------------------------------------------------------------------------------
+static bool is_orientation_request_valid(const json &orientation_request) {
+    if (orientation_request.is_string()) {
+        return orientation_request == "global";
+    }
+    if (!orientation_request.is_object() || !orientation_request.contains("axes")) {
+        return false;
+    }
+    const json &axes = orientation_request["axes"];
+    if (!axes.is_array() || axes.size() != 3) {
+        return false;
+    }
+    for (const auto &axis : axes) {
+        if (!axis.is_array() || axis.size() != 3) {
+            return false;
+        }
+        for (const auto &value : axis) {
+            if (!value.is_number()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 // ---------------------------------------------------------------------------------------
 //
 //   Validate the JSON output request file
@@ -36,24 +242,152 @@ bool is_output_request_valid(const json &output_request) {
             return false;
         }
     }
-    if (!output_request.contains("fields")) {
+    // Fields may be left out when only derived fields are written
+    if (!output_request.contains("fields") && !output_request.contains("derived")) {
         return false;
     }
-    if (!output_request["fields"].is_array()) {
+    json fields = output_request.value("fields", json::array());
+    if (!fields.is_array()) {
         return false;
     }
-    if (output_request["fields"].size() <= 0ull) {
+    if (fields.empty() && !output_request.contains("derived")) {
         return false;
     }
-    for (auto field : output_request["fields"]) {
+    for (auto field : fields) {
         if (!field.contains("key")) {
             return false;
         }
         if (!field["key"].is_string()) {
             return false;
         }
+        if (field.contains("quantize") && !is_quantize_request_valid(field["quantize"])) {
+            return false;
+        }
+        if (field.contains("components") && !is_string_list(field["components"])) {
+            return false;
+        }
+    }
+    if (output_request.contains("derived") &&
+        !is_derived_request_valid(output_request["derived"])) {
+        return false;
+    }
+    if (output_request.contains("orientation") &&
+        !is_orientation_request_valid(output_request["orientation"])) {
+        return false;
+    }
+    if (output_request.contains("deformed")) {
+        const json &deformed = output_request["deformed"];
+        if (!deformed.is_object()) {
+            return false;
+        }
+        if (deformed.contains("field") && !deformed["field"].is_string()) {
+            return false;
+        }
+        if (deformed.contains("scale") && !deformed["scale"].is_number()) {
+            return false;
+        }
+    }
+    if (output_request.contains("constants")) {
+        const json &constants = output_request["constants"];
+        if (!constants.is_object()) {
+            return false;
+        }
+        for (const auto &[name, value] : constants.items()) {
+            if (!value.is_number()) {
+                return false;
+            }
+        }
+    }
+    if (output_request.contains("format")) {
+        json formats = output_request["format"];
+        if (formats.is_string()) {
+            formats = json::array({formats});
+        }
+        if (!formats.is_array() || formats.empty()) {
+            return false;
+        }
+        for (const auto &format : formats) {
+            if (format != "vtk" && format != "store" && format != "npy" &&
+                format != "npz" && format != "ensight") {
+                return false;
+            }
+        }
+    }
+    if (output_request.contains("store")) {
+        const json &store = output_request["store"];
+        if (!store.is_object()) {
+            return false;
+        }
+        if (store.contains("compression") && store["compression"] != "none" &&
+            store["compression"] != "zlib") {
+            return false;
+        }
+    }
+    if (output_request.contains("vtk")) {
+        const json &vtk = output_request["vtk"];
+        if (!vtk.is_object()) {
+            return false;
+        }
+        if (vtk.contains("writer") && vtk["writer"] != "vtk" &&
+            vtk["writer"] != "native") {
+            return false;
+        }
+        if (vtk.contains("compression") && vtk["compression"] != "none" &&
+            vtk["compression"] != "zlib" && vtk["compression"] != "lz4" &&
+            vtk["compression"] != "lzma") {
+            return false;
+        }
+        if (vtk.contains("threads") && !vtk["threads"].is_number_integer()) {
+            return false;
+        }
+        if (vtk.contains("partitions") && (!vtk["partitions"].is_number_integer() ||
+                                           vtk["partitions"].get<int>() < 1)) {
+            return false;
+        }
+        if (vtk.contains("min_cells") && !vtk["min_cells"].is_number_unsigned()) {
+            return false;
+        }
+    }
+    if (output_request.contains("reorder") && output_request["reorder"] != "none" &&
+        output_request["reorder"] != "morton" && output_request["reorder"] != "hilbert") {
+        return false;
+    }
+    if (output_request.contains("mesh") && output_request["mesh"] != "volume" &&
+        output_request["mesh"] != "surface") {
+        return false;
+    }
+    if (output_request.contains("region") &&
+        !is_region_request_valid(output_request["region"])) {
+        return false;
+    }
+    if (output_request.contains("history") &&
+        !is_history_request_valid(output_request["history"])) {
+        return false;
     }
     return true;
 }
 
+// ---------------------------------------------------------------------------------------
+//
+//   Read and validate the JSON output request file
+//
+// ---------------------------------------------------------------------------------------
+json read_output_request(const fs::path &json_file) {
+    if (!fs::exists(json_file)) {
+        throw std::runtime_error(fmt::format("JSON output request file {} does not exist",
+                                             json_file.string()));
+    }
+    fmt::print("JSON output request file: {}\n", json_file.string());
+
+    std::ifstream json_stream(json_file);
+    json output_request = json::parse(json_stream);
+
+    if (!is_output_request_valid(output_request)) {
+        throw std::runtime_error("Invalid JSON output request syntax");
+    }
+    fmt::print("JSON output request is valid\n");
+
+    return output_request;
+}
+
 }  // namespace otk
@@ -0,0 +1,108 @@
+#include "otk/source.hpp"
+
+#include <iostream>
+#include <numeric>
+
+#include <fmt/format.h>
+
+#include "otk/element_scan.hpp"
+#include "otk/trace.hpp"
+
+using namespace nlohmann;
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Map a raw section category name to a display category
+//
+// ---------------------------------------------------------------------------------------
+std::string get_section_category_name(const std::string& section_category_raw_name) {
+    if (section_category_raw_name.find("shell < composite >") != std::string::npos) {
+        return "Shell composite";
+    }
+    if (section_category_raw_name.find("shell") != std::string::npos) {
+        return "Shell";
+    }
+    if (section_category_raw_name.find("solid < composite >") != std::string::npos) {
+        return "Solid composite";
+    }
+    if (section_category_raw_name.find("solid") != std::string::npos) {
+        return "Solid";
+    }
+    return "Other";
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   JSON summary
+//
+// ---------------------------------------------------------------------------------------
+json Source::field_summary(json& frames) const {
+    ScopedTimer timer{"field_summary"};
+
+    json summary;
+
+    for (auto& frame_data : frames) {
+        auto step_name = frame_data["step"].get<std::string>();
+
+        std::cout << fmt::format("Gathering field info for {}... ", step_name);
+        std::cout << std::flush;
+
+        std::vector<int> frame_ids;
+        if (frame_data.contains("list")) {
+            frame_ids = frame_data["list"].get<std::vector<int>>();
+        } else {
+            frame_ids.resize(num_frames(step_name), 0);
+            std::iota(frame_ids.begin(), frame_ids.end(), 0);
+            frame_data["list"] = frame_ids;
+        }
+
+        json step_json;
+        step_json["name"] = step_name;
+
+        for (auto& frame_id : frame_ids) {
+            FrameInfo info = frame(step_name, frame_id);
+            json frame_json;
+
+            frame_json["index"] = frame_id;
+            frame_json["id"] = info.id;
+            frame_json["increment"] = info.increment;
+            frame_json["value"] = info.value;
+
+            for (const auto& field_name : field_names(step_name, frame_id)) {
+                json field_json;
+                field_json["name"] = field_name;
+                frame_json["fields"].push_back(field_json);
+            }
+            step_json["frames"].push_back(frame_json);
+        }
+        summary["steps"].push_back(step_json);
+
+        std::cout << "done.\n" << std::flush;
+    }
+    return summary;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Instance summary
+//
+// ---------------------------------------------------------------------------------------
+json Source::instance_summary() const {
+    ScopedTimer timer{"instance_summary"};
+
+    json summary;
+
+    std::cout << "Gathering info about the instances... " << std::flush;
+
+    for (const auto& instance_name : instance_names()) {
+        summary[instance_name] = scan_summary(scan_elements(elements(instance_name)));
+    }
+
+    std::cout << "done.\n" << std::flush;
+
+    return summary;
+}
+
+}  // namespace otk
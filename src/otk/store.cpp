@@ -0,0 +1,409 @@
+#include "otk/store.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkZLibDataCompressor.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "otk/trace.hpp"
+
+using namespace nlohmann;
+
+namespace otk {
+
+static constexpr char STORE_MAGIC[8] = {'O', 'T', 'K', 'S', 'T', 'O', 'R', 'E'};
+static constexpr char INDEX_MAGIC[8] = {'O', 'T', 'K', 'I', 'N', 'D', 'E', 'X'};
+static constexpr size_t HEADER_SIZE = 16;
+static constexpr size_t FOOTER_SIZE = 24;
+
+// ---------------------------------------------------------------------------------------
+//
+//   Store dtype of a VTK data type
+//
+// ---------------------------------------------------------------------------------------
+std::string store_dtype(int vtk_type) {
+    switch (vtk_type) {
+        case VTK_FLOAT:
+            return "float32";
+        case VTK_DOUBLE:
+            return "float64";
+        case VTK_UNSIGNED_CHAR:
+            return "uint8";
+        case VTK_UNSIGNED_SHORT:
+            return "uint16";
+        case VTK_INT:
+            return "int32";
+        case VTK_LONG_LONG:
+            return "int64";
+        case VTK_LONG:
+            return sizeof(long) == 8 ? "int64" : "int32";
+        case VTK_ID_TYPE:
+            return sizeof(vtkIdType) == 8 ? "int64" : "int32";
+        default:
+            return {};
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Size in bytes of a store dtype
+//
+// ---------------------------------------------------------------------------------------
+static size_t dtype_size(const std::string &dtype) {
+    static const std::unordered_map<std::string, size_t> sizes{
+        {"float32", 4}, {"float64", 8}, {"uint8", 1},
+        {"uint16", 2},  {"int32", 4},   {"int64", 8},
+    };
+    return sizes.at(dtype);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Lookup key of a chunk entry
+//
+// ---------------------------------------------------------------------------------------
+static std::string chunk_key(const std::string &step_name, int frame_id,
+                             const std::string &instance_name, const std::string &name) {
+    return fmt::format("{}\n{}\n{}\n{}", step_name, frame_id, instance_name, name);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Constructor (creates the file and writes the header)
+//
+// ---------------------------------------------------------------------------------------
+StoreWriter::StoreWriter(const fs::path &file, bool compress)
+    : file_(file), compress_(compress) {
+    stream_.open(file_, std::ios::binary);
+    if (!stream_) {
+        throw std::runtime_error(
+            fmt::format("Could not open {} for writing.", file_.string()));
+    }
+
+    const std::uint32_t header[2] = {STORE_VERSION,
+                                     static_cast<std::uint32_t>(STORE_ALIGNMENT)};
+    stream_.write(STORE_MAGIC, sizeof(STORE_MAGIC));
+    stream_.write(reinterpret_cast<const char *>(header), sizeof(header));
+    position_ = HEADER_SIZE;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Destructor (writes the index if close() was not called)
+//
+// ---------------------------------------------------------------------------------------
+StoreWriter::~StoreWriter() {
+    if (!stream_.is_open()) {
+        return;
+    }
+    try {
+        close();
+    } catch (const std::exception &err) {
+        fmt::print("ERROR: {}\n", err.what());
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Append a chunk
+//
+//   Compressed chunks are only kept when zlib actually makes them smaller.
+//
+// ---------------------------------------------------------------------------------------
+size_t StoreWriter::write(json entry, const std::string &dtype, size_t num_rows,
+                          int num_components, const void *data) {
+    const size_t raw_size = num_rows * num_components * dtype_size(dtype);
+    const char *bytes = static_cast<const char *>(data);
+    size_t size = raw_size;
+
+    std::vector<unsigned char> compressed;
+    if (compress_ && raw_size > 0) {
+        auto compressor = vtkSmartPointer<vtkZLibDataCompressor>::New();
+        compressed.resize(compressor->GetMaximumCompressionSpace(raw_size));
+        size_t compressed_size = compressor->Compress(
+            reinterpret_cast<const unsigned char *>(data), raw_size, compressed.data(),
+            compressed.size());
+        if (compressed_size > 0 && compressed_size < raw_size) {
+            bytes = reinterpret_cast<const char *>(compressed.data());
+            size = compressed_size;
+        }
+    }
+
+    std::uint64_t padding =
+        (STORE_ALIGNMENT - position_ % STORE_ALIGNMENT) % STORE_ALIGNMENT;
+    static const char zeros[STORE_ALIGNMENT] = {};
+    stream_.write(zeros, static_cast<std::streamsize>(padding));
+    position_ += padding;
+
+    entry["dtype"] = dtype;
+    entry["shape"] = {num_rows, num_components};
+    entry["offset"] = position_;
+    entry["size"] = size;
+    entry["raw_size"] = raw_size;
+    entry["compression"] = (size < raw_size) ? "zlib" : "none";
+    chunks_.push_back(std::move(entry));
+
+    stream_.write(bytes, static_cast<std::streamsize>(size));
+    position_ += size;
+
+    if (!stream_) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", file_.string()));
+    }
+    return chunks_.size() - 1;
+}
+
+size_t StoreWriter::write(json entry, vtkDataArray *array) {
+    std::string dtype = store_dtype(array->GetDataType());
+    if (dtype.empty()) {
+        throw std::runtime_error(fmt::format("Unsupported data type {} of array {}.",
+                                             array->GetDataTypeAsString(),
+                                             array->GetName() ? array->GetName() : ""));
+    }
+    return write(std::move(entry), dtype, static_cast<size_t>(array->GetNumberOfTuples()),
+                 array->GetNumberOfComponents(), array->GetVoidPointer(0));
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Add an index entry for the data of a previous chunk
+//
+// ---------------------------------------------------------------------------------------
+size_t StoreWriter::link(json entry, size_t chunk_id) {
+    const json &target = chunks_.at(chunk_id);
+    for (const char *key :
+         {"dtype", "shape", "offset", "size", "raw_size", "compression"}) {
+        entry[key] = target[key];
+    }
+    entry["link"] = chunk_id;
+    chunks_.push_back(std::move(entry));
+    return chunks_.size() - 1;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the index and the footer
+//
+// ---------------------------------------------------------------------------------------
+void StoreWriter::close() {
+    ScopedTimer timer{"store_close", [&] { return json{{"chunks", chunks_.size()}}; }};
+
+    json index;
+    index["version"] = STORE_VERSION;
+    index["byte_order"] = "little";
+    index["chunks"] = chunks_;
+    std::string text = index.dump();
+
+    const std::uint64_t footer[2] = {position_, text.size()};
+    stream_.write(text.data(), static_cast<std::streamsize>(text.size()));
+    stream_.write(reinterpret_cast<const char *>(footer), sizeof(footer));
+    stream_.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    stream_.close();
+
+    if (!stream_) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", file_.string()));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Constructor (maps the file and reads the index)
+//
+// ---------------------------------------------------------------------------------------
+Store::Store(const fs::path &file) : file_(file) {
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE file_handle =
+        CreateFileW(file_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                    FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error(fmt::format("Could not open {}.", file_.string()));
+    }
+    file_handle_ = file_handle;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size)) {
+        CloseHandle(file_handle);
+        throw std::runtime_error(fmt::format("Could not open {}.", file_.string()));
+    }
+    size_ = static_cast<size_t>(file_size.QuadPart);
+
+    HANDLE mapping_handle =
+        CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        throw std::runtime_error(fmt::format("Could not map {}.", file_.string()));
+    }
+    mapping_handle_ = mapping_handle;
+    base_ = static_cast<const unsigned char *>(
+        MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+#else
+    int descriptor = ::open(file_.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error(fmt::format("Could not open {}.", file_.string()));
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw std::runtime_error(fmt::format("Could not open {}.", file_.string()));
+    }
+    size_ = static_cast<size_t>(status.st_size);
+
+    void *address = mmap(nullptr, size_, PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (address != MAP_FAILED) {
+        base_ = static_cast<const unsigned char *>(address);
+    }
+#endif
+
+    const auto not_a_store = [this] {
+        unmap();
+        return std::runtime_error(
+            fmt::format("{} is not an OTK frame store.", file_.string()));
+    };
+    if (base_ == nullptr || size_ < HEADER_SIZE + FOOTER_SIZE ||
+        std::memcmp(base_, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+        std::memcmp(base_ + size_ - sizeof(INDEX_MAGIC), INDEX_MAGIC,
+                    sizeof(INDEX_MAGIC)) != 0) {
+        throw not_a_store();
+    }
+
+    // The index lies between the header and the footer; a corrupted footer or index is
+    // reported like any other file that is not a store
+    std::uint64_t footer[2];
+    std::memcpy(footer, base_ + size_ - FOOTER_SIZE, sizeof(footer));
+    const std::uint64_t index_end = size_ - FOOTER_SIZE;
+    if (footer[0] < HEADER_SIZE || footer[0] > index_end ||
+        footer[1] > index_end - footer[0]) {
+        throw not_a_store();
+    }
+    try {
+        index_ = json::parse(base_ + footer[0], base_ + footer[0] + footer[1]);
+
+        const json &entries = index_.at("chunks");
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const json &entry = entries[i];
+            auto instance_name = entry.at("instance").get<std::string>();
+            auto name = entry.at("name").get<std::string>();
+            if (entry.at("kind") == "mesh") {
+                lookup_[chunk_key("", -1, instance_name, name)] = i;
+            } else {
+                lookup_[chunk_key(entry.at("step").get<std::string>(),
+                                  entry.at("frame").get<int>(), instance_name, name)] = i;
+            }
+        }
+    } catch (const json::exception &) {
+        throw not_a_store();
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Destructor (unmaps the file)
+//
+// ---------------------------------------------------------------------------------------
+Store::~Store() { unmap(); }
+
+// ---------------------------------------------------------------------------------------
+//
+//   Unmap the file
+//
+// ---------------------------------------------------------------------------------------
+void Store::unmap() {
+#if defined(_WIN32) || defined(_WIN64)
+    if (base_ != nullptr) {
+        UnmapViewOfFile(base_);
+    }
+    if (mapping_handle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(mapping_handle_));
+    }
+    if (file_handle_ != nullptr) {
+        CloseHandle(static_cast<HANDLE>(file_handle_));
+    }
+    mapping_handle_ = nullptr;
+    file_handle_ = nullptr;
+#else
+    if (base_ != nullptr) {
+        munmap(const_cast<unsigned char *>(base_), size_);
+    }
+#endif
+    base_ = nullptr;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Mesh chunk of an instance
+//
+// ---------------------------------------------------------------------------------------
+Store::Chunk Store::mesh(const std::string &instance_name, const std::string &name) {
+    auto it = lookup_.find(chunk_key("", -1, instance_name, name));
+    return (it != lookup_.end()) ? load(it->second) : Chunk{};
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Field chunk of an instance in a frame
+//
+// ---------------------------------------------------------------------------------------
+Store::Chunk Store::field(const std::string &step_name, int frame_id,
+                          const std::string &instance_name,
+                          const std::string &field_name) {
+    auto it = lookup_.find(chunk_key(step_name, frame_id, instance_name, field_name));
+    return (it != lookup_.end()) ? load(it->second) : Chunk{};
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   View of a chunk (in place, or inflated once and cached for compressed chunks)
+//
+// ---------------------------------------------------------------------------------------
+Store::Chunk Store::load(size_t chunk_id) {
+    const json &entry = chunks()[chunk_id];
+
+    Chunk chunk;
+    chunk.entry = &entry;
+    chunk.dtype = entry["dtype"].get<std::string>();
+    chunk.num_rows = entry["shape"][0].get<size_t>();
+    chunk.num_components = entry["shape"][1].get<int>();
+
+    const auto offset = entry["offset"].get<std::uint64_t>();
+    const auto size = entry["size"].get<size_t>();
+    if (offset < HEADER_SIZE || offset > size_ || size > size_ - offset) {
+        throw std::runtime_error(
+            fmt::format("Corrupted chunk {} in {}.", chunk_id, file_.string()));
+    }
+    if (entry["compression"] == "none") {
+        chunk.data = base_ + offset;
+        return chunk;
+    }
+
+    // Linked chunks share their data, so the cache is keyed by offset
+    auto [it, inserted] = inflated_.try_emplace(offset);
+    if (inserted) {
+        ScopedTimer timer{"store_inflate", [&] { return json{{"chunk", chunk_id}}; }};
+        it->second.resize(entry["raw_size"].get<size_t>());
+        auto compressor = vtkSmartPointer<vtkZLibDataCompressor>::New();
+        if (compressor->Uncompress(base_ + offset, size, it->second.data(),
+                                   it->second.size()) != it->second.size()) {
+            inflated_.erase(it);
+            throw std::runtime_error(
+                fmt::format("Corrupted chunk {} in {}.", chunk_id, file_.string()));
+        }
+    }
+    chunk.data = it->second.data();
+    return chunk;
+}
+
+}  // namespace otk
@@ -0,0 +1,359 @@
+#include "otk/synthetic.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Constructor
+//
+// ---------------------------------------------------------------------------------------
+SyntheticSource::SyntheticSource(const SyntheticConfig& config) : config_(config) {
+    if (config_.nx < 1 || config_.ny < 1 || config_.nz < 1) {
+        throw std::runtime_error("Synthetic grid needs at least one element per axis.");
+    }
+
+    for (int i = 0; i < config_.instances; ++i) {
+        instance_names_.push_back(fmt::format("PART-{}-1", i + 1));
+    }
+
+    auto add_fields = [this](int count, const std::string& prefix, FieldSpec spec) {
+        for (int i = 0; i < count; ++i) {
+            std::string name = fmt::format("{}{}", prefix, i + 1);
+            field_names_.push_back(name);
+            field_specs_[name] = spec;
+        }
+    };
+
+    if (config_.nodal_vector_fields > 0) {
+        field_names_.push_back("U");
+        field_specs_["U"] = {DataType::VECTOR, Position::NODAL, 3};
+    }
+    add_fields(config_.nodal_vector_fields - 1, "V",
+               {DataType::VECTOR, Position::NODAL, 3});
+    add_fields(config_.nodal_scalar_fields, "NT", {DataType::SCALAR, Position::NODAL, 1});
+    add_fields(config_.element_scalar_fields, "EVOL",
+               {DataType::SCALAR, Position::WHOLE_ELEMENT, 1});
+    add_fields(config_.integration_scalar_fields, "PEEQ",
+               {DataType::SCALAR, Position::ELEMENT_NODAL, 1});
+    add_fields(config_.integration_tensor_fields, "S",
+               {DataType::TENSOR_3D_FULL, Position::ELEMENT_NODAL, 6});
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Instances
+//
+// ---------------------------------------------------------------------------------------
+std::vector<std::string> SyntheticSource::instance_names() const {
+    return instance_names_;
+}
+
+int SyntheticSource::instance_index(const std::string& instance) const {
+    for (size_t i = 0; i < instance_names_.size(); ++i) {
+        if (instance_names_[i] == instance) {
+            return static_cast<int>(i);
+        }
+    }
+    throw std::runtime_error(fmt::format("Unknown synthetic instance {}.", instance));
+}
+
+Dimension SyntheticSource::dimension(const std::string& instance) const {
+    return Dimension::THREE_D;
+}
+
+int SyntheticSource::num_nodes(const std::string& instance) const {
+    return (config_.nx + 1) * (config_.ny + 1) * (config_.nz + 1);
+}
+
+int SyntheticSource::num_elements(const std::string& instance) const {
+    return config_.nx * config_.ny * config_.nz;
+}
+
+NodeData SyntheticSource::nodes(const std::string& instance) const {
+    const int offset = instance_index(instance) * (config_.nx + 2);
+
+    NodeData data;
+    data.labels.reserve(num_nodes(instance));
+    data.coordinates.reserve(3 * static_cast<size_t>(num_nodes(instance)));
+
+    int label = 1;
+    for (int k = 0; k <= config_.nz; ++k) {
+        for (int j = 0; j <= config_.ny; ++j) {
+            for (int i = 0; i <= config_.nx; ++i) {
+                data.labels.push_back(label++);
+                data.coordinates.push_back(static_cast<float>(i + offset));
+                data.coordinates.push_back(static_cast<float>(j));
+                data.coordinates.push_back(static_cast<float>(k));
+            }
+        }
+    }
+    return data;
+}
+
+ElementData SyntheticSource::elements(const std::string& instance) const {
+    const int nx = config_.nx;
+    const int ny = config_.ny;
+    const int nz = config_.nz;
+    auto node = [nx, ny](int i, int j, int k) {
+        return 1 + i + (nx + 1) * (j + (ny + 1) * k);
+    };
+
+    ElementData data;
+    data.type_names = {"C3D8R"};
+    data.section_names = {"solid < SYNTHETIC >"};
+    data.labels.reserve(num_elements(instance));
+    data.types.assign(num_elements(instance), 0);
+    data.sections.assign(num_elements(instance), 0);
+    data.offsets.reserve(num_elements(instance) + 1);
+    data.connectivity.reserve(8 * static_cast<size_t>(num_elements(instance)));
+    data.offsets.push_back(0);
+
+    int label = 1;
+    for (int k = 0; k < nz; ++k) {
+        for (int j = 0; j < ny; ++j) {
+            for (int i = 0; i < nx; ++i) {
+                data.labels.push_back(label++);
+                for (int dk = 0; dk < 2; ++dk) {
+                    data.connectivity.push_back(node(i, j, k + dk));
+                    data.connectivity.push_back(node(i + 1, j, k + dk));
+                    data.connectivity.push_back(node(i + 1, j + 1, k + dk));
+                    data.connectivity.push_back(node(i, j + 1, k + dk));
+                }
+                data.offsets.push_back(static_cast<int>(data.connectivity.size()));
+            }
+        }
+    }
+    return data;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Steps and frames
+//
+// ---------------------------------------------------------------------------------------
+std::vector<std::string> SyntheticSource::step_names() const {
+    std::vector<std::string> names;
+    for (int i = 0; i < config_.steps; ++i) {
+        names.push_back(fmt::format("Step-{}", i + 1));
+    }
+    return names;
+}
+
+int SyntheticSource::num_frames(const std::string& step) const { return config_.frames; }
+
+FrameInfo SyntheticSource::frame(const std::string& step, int frame) const {
+    double value = (config_.frames > 1) ? double(frame) / (config_.frames - 1) : 0.0;
+    return {frame, frame, value};
+}
+
+std::vector<std::string> SyntheticSource::field_names(const std::string& step,
+                                                      int frame) const {
+    return field_names_;
+}
+
+FieldInfo SyntheticSource::field_info(const std::string& step, int frame,
+                                      const std::string& field) const {
+    const FieldSpec& spec = field_spec(field);
+    return {field, spec.type, spec.width, {spec.position}};
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Field outputs of an instance
+//
+//   Values are a cheap function of the label, the component and the frame. Element
+//   groups and the composite flag are ignored since the model has a single section.
+//
+// ---------------------------------------------------------------------------------------
+FieldData SyntheticSource::field_data(const std::string& step, int frame,
+                                      const std::string& field,
+                                      const std::string& instance,
+                                      const ElementGroups& groups, bool composite,
+                                      const std::vector<int>& region_nodes) const {
+    const FieldSpec& spec = field_spec(field);
+    switch (spec.position) {
+        case Position::NODAL:
+            if (!region_nodes.empty()) {
+                return make_field(field, spec, spec.position, region_nodes, frame);
+            }
+            return make_field(field, spec, spec.position, nodes(instance).labels, frame);
+        case Position::WHOLE_ELEMENT:
+            return make_field(field, spec, spec.position, elements(instance).labels,
+                              frame);
+        default:
+            return make_field(field, spec, spec.position,
+                              elements(instance).connectivity, frame);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Field output values at selected nodes and elements (C3D8R elements have a single
+//   integration point, so integration point fields have one row per element)
+//
+// ---------------------------------------------------------------------------------------
+FieldData SyntheticSource::field_values(const std::string& step, int frame,
+                                        const std::string& field,
+                                        const std::string& instance,
+                                        const std::vector<int>& node_labels,
+                                        const std::vector<int>& element_labels) const {
+    const FieldSpec& spec = field_spec(field);
+    const int max_node = num_nodes(instance);
+    const int max_element = num_elements(instance);
+
+    std::vector<int> labels;
+    Position position = spec.position;
+    if (spec.position == Position::NODAL) {
+        std::copy_if(node_labels.begin(), node_labels.end(), std::back_inserter(labels),
+                     [max_node](int label) { return label >= 1 && label <= max_node; });
+    } else {
+        std::copy_if(
+            element_labels.begin(), element_labels.end(), std::back_inserter(labels),
+            [max_element](int label) { return label >= 1 && label <= max_element; });
+        if (spec.position == Position::ELEMENT_NODAL) {
+            position = Position::INTEGRATION_POINT;
+        }
+    }
+    if (labels.empty()) {
+        FieldData data;
+        data.name = field;
+        data.type = spec.type;
+        return data;
+    }
+    return make_field(field, spec, position, std::move(labels), frame);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Sets ("ALL" is the only set of an instance)
+//
+// ---------------------------------------------------------------------------------------
+std::vector<int> SyntheticSource::node_set(const std::string& instance,
+                                           const std::string& name) const {
+    if (name != "ALL") {
+        throw std::runtime_error(
+            fmt::format("Node set {} not found in {}.", name, instance));
+    }
+    return nodes(instance).labels;
+}
+
+std::vector<int> SyntheticSource::element_set(const std::string& instance,
+                                              const std::string& name) const {
+    if (name != "ALL") {
+        throw std::runtime_error(
+            fmt::format("Element set {} not found in {}.", name, instance));
+    }
+    return elements(instance).labels;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   History regions and outputs (energies of the assembly and the reaction forces of
+//   the first node of each instance, with ten output times per frame)
+//
+// ---------------------------------------------------------------------------------------
+std::vector<std::string> SyntheticSource::history_region_names(
+    const std::string& step) const {
+    std::vector<std::string> names{"Assembly ASSEMBLY"};
+    for (const auto& instance_name : instance_names_) {
+        names.push_back(fmt::format("Node {}.1", instance_name));
+    }
+    return names;
+}
+
+std::vector<std::string> SyntheticSource::history_output_names(
+    const std::string& step, const std::string& region) const {
+    if (region == "Assembly ASSEMBLY") {
+        return {"ALLIE", "ALLKE", "ETOTAL"};
+    }
+    return {"RF1", "RF2", "RF3"};
+}
+
+HistoryData SyntheticSource::history_output(const std::string& step,
+                                            const std::string& region,
+                                            const std::string& output) const {
+    std::vector<std::string> outputs = history_output_names(step, region);
+    auto output_it = std::find(outputs.begin(), outputs.end(), output);
+    if (output_it == outputs.end()) {
+        throw std::runtime_error(
+            fmt::format("Unknown synthetic history output {} in {}.", output, region));
+    }
+    const double scale = 1.0 + (output_it - outputs.begin());
+
+    HistoryData data;
+    data.name = output;
+    data.description = fmt::format("Synthetic history output {}", output);
+
+    const int num_points = 10 * std::max(config_.frames - 1, 0) + 1;
+    data.time.resize(num_points);
+    data.values.resize(num_points);
+    for (int i = 0; i < num_points; ++i) {
+        data.time[i] = (num_points > 1) ? double(i) / (num_points - 1) : 0.0;
+        data.values[i] = scale * data.time[i] * data.time[i];
+    }
+    return data;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Field generation helpers
+//
+// ---------------------------------------------------------------------------------------
+const SyntheticSource::FieldSpec& SyntheticSource::field_spec(
+    const std::string& field) const {
+    auto spec_it = field_specs_.find(field);
+    if (spec_it == field_specs_.end()) {
+        throw std::runtime_error(fmt::format("Unknown synthetic field {}.", field));
+    }
+    return spec_it->second;
+}
+
+FieldData SyntheticSource::make_field(const std::string& field, const FieldSpec& spec,
+                                      Position position, std::vector<int> labels,
+                                      int frame) const {
+    auto block = std::make_shared<Block>();
+    block->labels = std::move(labels);
+
+    const size_t num_values = block->labels.size() * spec.width;
+    const double scale = 1.0 + 0.01 * frame;
+    if (config_.double_precision) {
+        block->data_double.resize(num_values);
+    } else {
+        block->data.resize(num_values);
+    }
+    for (size_t i = 0; i < block->labels.size(); ++i) {
+        for (int j = 0; j < spec.width; ++j) {
+            double value = scale * (block->labels[i] % 1000) + j;
+            if (config_.double_precision) {
+                block->data_double[i * spec.width + j] = value;
+            } else {
+                block->data[i * spec.width + j] = static_cast<float>(value);
+            }
+        }
+    }
+
+    FieldBlock view{position, Precision::SINGLE, spec.width,
+                    static_cast<int>(block->labels.size()), block->labels.data(),
+                    nullptr, nullptr};
+    if (config_.double_precision) {
+        view.precision = Precision::DOUBLE;
+        view.data_double = block->data_double.data();
+    } else {
+        view.data = block->data.data();
+    }
+
+    FieldData data;
+    data.name = field;
+    data.type = spec.type;
+    data.blocks.push_back(view);
+    data.storage = block;
+    return data;
+}
+
+}  // namespace otk
@@ -0,0 +1,211 @@
+#include "otk/trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+
+#include <fmt/format.h>
+
+#include "otk/cli.hpp"
+
+using namespace nlohmann;
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Process-wide tracer
+//
+// ---------------------------------------------------------------------------------------
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Small per-thread index used as the trace "tid"
+//
+// ---------------------------------------------------------------------------------------
+int Tracer::thread_index() {
+    static std::atomic<int> next_index{0};
+    thread_local int index = next_index++;
+    return index;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Record events
+//
+// ---------------------------------------------------------------------------------------
+void Tracer::record(Event event) {
+    if (!recording_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(std::move(event));
+}
+
+void Tracer::aggregate(std::string_view name, Clock::duration duration) {
+    const double ms = std::chrono::duration<double, std::milli>(duration).count();
+    int bucket = 0;
+    if (ms >= TRACE_MIN_MS) {
+        bucket = 1 + static_cast<int>(std::log10(ms / TRACE_MIN_MS) *
+                                      TRACE_BUCKETS_PER_DECADE);
+        bucket = std::min(bucket, TRACE_BUCKETS - 1);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = aggregates_.find(name);
+    if (it == aggregates_.end()) {
+        it = aggregates_.emplace(std::string(name), Aggregate{}).first;
+    }
+    Aggregate& aggregate = it->second;
+    aggregate.count++;
+    aggregate.total_ms += ms;
+    aggregate.buckets[bucket]++;
+}
+
+void Tracer::counter(std::string name, json values) {
+    if (!recording_) {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    record({std::move(name), "otk", now, Clock::duration::zero(), thread_index(),
+            std::move(values), 'C'});
+}
+
+void Tracer::metadata(const std::string& key, json value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    metadata_[key] = std::move(value);
+}
+
+void Tracer::clear_events() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    events_.shrink_to_fit();
+    metadata_.clear();
+    origin_ = Clock::now();
+}
+
+void Tracer::clear() {
+    clear_events();
+    std::lock_guard<std::mutex> lock(mutex_);
+    aggregates_.clear();
+}
+
+double Tracer::to_microseconds(Clock::time_point time) const {
+    return std::chrono::duration<double, std::micro>(time - origin_).count();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Per-phase summary (count, total, p50, p99 in milliseconds)
+//
+// ---------------------------------------------------------------------------------------
+json Tracer::summary() const {
+    // Geometric center of a bucket, in milliseconds
+    auto bucket_value = [](int bucket) {
+        if (bucket == 0) {
+            return TRACE_MIN_MS;
+        }
+        return TRACE_MIN_MS *
+               std::pow(10.0, (bucket - 0.5) / TRACE_BUCKETS_PER_DECADE);
+    };
+    auto percentile = [&](const Aggregate& aggregate, double p) {
+        const auto rank = static_cast<std::uint64_t>(p * (aggregate.count - 1) + 0.5);
+        std::uint64_t seen = 0;
+        for (int bucket = 0; bucket < TRACE_BUCKETS; ++bucket) {
+            seen += aggregate.buckets[bucket];
+            if (seen > rank) {
+                return bucket_value(bucket);
+            }
+        }
+        return bucket_value(TRACE_BUCKETS - 1);
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    json summary = json::object();
+    for (const auto& [name, aggregate] : aggregates_) {
+        summary[name]["count"] = aggregate.count;
+        summary[name]["total_ms"] = aggregate.total_ms;
+        summary[name]["p50_ms"] = percentile(aggregate, 0.50);
+        summary[name]["p99_ms"] = percentile(aggregate, 0.99);
+    }
+    return summary;
+}
+
+void Tracer::print_summary() const {
+    json phases = summary();
+
+    print_separator_2();
+    print_title("Timing summary");
+    print_separator_2();
+    fmt::print("{:<32} | {:>7} | {:>12} | {:>10} | {:>10}\n", "Phase", "Count",
+               "Total [ms]", "p50 [ms]", "p99 [ms]");
+    for (const auto& [name, phase] : phases.items()) {
+        fmt::print("{:<32} | {:>7} | {:>12.2f} | {:>10.3f} | {:>10.3f}\n", name,
+                   phase["count"].get<size_t>(), phase["total_ms"].get<double>(),
+                   phase["p50_ms"].get<double>(), phase["p99_ms"].get<double>());
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the Chrome trace-event JSON file (chrome://tracing, Perfetto)
+//
+// ---------------------------------------------------------------------------------------
+void Tracer::write_chrome_trace(const fs::path& file) const {
+    json trace;
+    trace["displayTimeUnit"] = "ms";
+    trace["traceEvents"] = json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& event : events_) {
+            json trace_event;
+            trace_event["name"] = event.name;
+            trace_event["cat"] = event.category;
+            trace_event["ph"] = std::string(1, event.phase);
+            trace_event["ts"] = to_microseconds(event.start);
+            if (event.phase == 'X') {
+                trace_event["dur"] =
+                    std::chrono::duration<double, std::micro>(event.duration).count();
+            }
+            trace_event["pid"] = 0;
+            trace_event["tid"] = event.thread;
+            if (!event.args.is_null()) {
+                trace_event["args"] = event.args;
+            }
+            trace["traceEvents"].push_back(std::move(trace_event));
+        }
+        for (const auto& [key, value] : metadata_.items()) {
+            trace["otherData"][key] = value;
+        }
+    }
+    trace["otherData"]["summary"] = summary();
+
+    std::ofstream stream(file);
+    if (!stream) {
+        throw std::runtime_error(
+            fmt::format("Could not open trace file {} for writing.", file.string()));
+    }
+    stream << trace.dump();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   ScopedTimer destructor (aggregates the duration and records the event)
+//
+// ---------------------------------------------------------------------------------------
+ScopedTimer::~ScopedTimer() {
+    Tracer::Clock::time_point end = Tracer::Clock::now();
+    Tracer& tracer = Tracer::instance();
+    tracer.aggregate(name_, end - start_);
+    if (tracer.recording()) {
+        tracer.record({name_, category_, start_, end - start_, Tracer::thread_index(),
+                       std::move(args_)});
+    }
+}
+
+}  // namespace otk
@@ -0,0 +1,415 @@
+#include "otk/vtk_xml.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include <vtkLZ4DataCompressor.h>
+#include <vtkLZMADataCompressor.h>
+#include <vtkSmartPointer.h>
+#include <vtkZLibDataCompressor.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include "otk/parallel.hpp"
+#include "otk/trace.hpp"
+
+namespace otk {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Contiguous piece of a file
+//
+// ---------------------------------------------------------------------------------------
+struct Segment {
+    const void *data;
+    size_t size;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write the segments to a file (one writev call per 1024 segments on POSIX)
+//
+// ---------------------------------------------------------------------------------------
+static void write_segments(const fs::path &file, const std::vector<Segment> &segments) {
+#if defined(_WIN32) || defined(_WIN64)
+    std::ofstream stream(file, std::ios::binary);
+    for (const auto &segment : segments) {
+        stream.write(static_cast<const char *>(segment.data),
+                     static_cast<std::streamsize>(segment.size));
+    }
+    if (!stream) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", file.string()));
+    }
+#else
+    static constexpr size_t MAX_IOV = 1024;
+
+    std::vector<iovec> iov;
+    iov.reserve(segments.size());
+    for (const auto &segment : segments) {
+        iov.push_back({const_cast<void *>(segment.data), segment.size});
+    }
+
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(
+            fmt::format("Could not open {} for writing.", file.string()));
+    }
+
+    size_t index = 0;
+    while (index < iov.size()) {
+        int count = static_cast<int>(std::min(iov.size() - index, MAX_IOV));
+        ssize_t written = ::writev(fd, &iov[index], count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error(fmt::format("Could not write to {} ({}).",
+                                                 file.string(), std::strerror(error)));
+        }
+
+        // Skip the segments written in full and resume within a partial one
+        auto remaining = static_cast<size_t>(written);
+        while (index < iov.size() && remaining >= iov[index].iov_len) {
+            remaining -= iov[index].iov_len;
+            index++;
+        }
+        if (remaining > 0) {
+            iov[index].iov_base = static_cast<char *>(iov[index].iov_base) + remaining;
+            iov[index].iov_len -= remaining;
+        }
+    }
+
+    if (::close(fd) != 0) {
+        throw std::runtime_error(fmt::format("Could not write to {}.", file.string()));
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Escape a string for an XML attribute
+//
+// ---------------------------------------------------------------------------------------
+static std::string xml_escape(const std::string &text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+            case '&':
+                escaped += "&amp;";
+                break;
+            case '<':
+                escaped += "&lt;";
+                break;
+            case '>':
+                escaped += "&gt;";
+                break;
+            case '"':
+                escaped += "&quot;";
+                break;
+            default:
+                escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   VTK XML type name of a data array
+//
+// ---------------------------------------------------------------------------------------
+std::string vtk_xml_type(vtkDataArray *array) {
+    const int bits = 8 * array->GetDataTypeSize();
+    switch (array->GetDataType()) {
+        case VTK_FLOAT:
+        case VTK_DOUBLE:
+            return fmt::format("Float{}", bits);
+        case VTK_CHAR:
+        case VTK_SIGNED_CHAR:
+        case VTK_SHORT:
+        case VTK_INT:
+        case VTK_LONG:
+        case VTK_LONG_LONG:
+        case VTK_ID_TYPE:
+            return fmt::format("Int{}", bits);
+        case VTK_UNSIGNED_CHAR:
+        case VTK_UNSIGNED_SHORT:
+        case VTK_UNSIGNED_INT:
+        case VTK_UNSIGNED_LONG:
+        case VTK_UNSIGNED_LONG_LONG:
+            return fmt::format("UInt{}", bits);
+        default:
+            throw std::runtime_error(
+                fmt::format("Unsupported data type {} of array {}.",
+                            array->GetDataTypeAsString(),
+                            array->GetName() ? array->GetName() : ""));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   VTK compressor class of a compressor name
+//
+// ---------------------------------------------------------------------------------------
+static const char *compressor_class(const std::string &compressor) {
+    if (compressor == "zlib") {
+        return "vtkZLibDataCompressor";
+    }
+    if (compressor == "lz4") {
+        return "vtkLZ4DataCompressor";
+    }
+    if (compressor == "lzma") {
+        return "vtkLZMADataCompressor";
+    }
+    throw std::runtime_error(fmt::format("Unsupported compressor {}.", compressor));
+}
+
+static vtkSmartPointer<vtkDataCompressor> make_compressor(const std::string &compressor) {
+    if (compressor == "lz4") {
+        return vtkSmartPointer<vtkLZ4DataCompressor>::New();
+    }
+    if (compressor == "lzma") {
+        return vtkSmartPointer<vtkLZMADataCompressor>::New();
+    }
+    return vtkSmartPointer<vtkZLibDataCompressor>::New();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Compress a buffer in VTU_BLOCK_SIZE blocks on a number of threads
+//
+//   Each worker uses its own compressor, created up front on the calling thread.
+//
+// ---------------------------------------------------------------------------------------
+static std::vector<std::vector<unsigned char>> compress_blocks(
+    const void *data, size_t size, const VtuCompression &compression) {
+    const size_t num_blocks = (size + VTU_BLOCK_SIZE - 1) / VTU_BLOCK_SIZE;
+    std::vector<std::vector<unsigned char>> blocks(num_blocks);
+
+    const int num_threads = static_cast<int>(std::clamp<size_t>(
+        thread_count(compression.threads), 1, std::max<size_t>(num_blocks, 1)));
+    std::vector<vtkSmartPointer<vtkDataCompressor>> compressors;
+    for (int i = 0; i < num_threads; ++i) {
+        compressors.push_back(make_compressor(compression.compressor));
+    }
+
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    parallel_for(num_blocks, num_threads, [&](size_t i, int worker) {
+        const size_t offset = i * VTU_BLOCK_SIZE;
+        const size_t length = std::min(VTU_BLOCK_SIZE, size - offset);
+        std::vector<unsigned char> &block = blocks[i];
+        block.resize(compressors[worker]->GetMaximumCompressionSpace(length));
+        size_t compressed_size = compressors[worker]->Compress(
+            bytes + offset, length, block.data(), block.size());
+        if (compressed_size == 0) {
+            throw std::runtime_error("Compression of a VTU data block failed.");
+        }
+        block.resize(compressed_size);
+    });
+    return blocks;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Appended data section of a .vtu file
+//
+//   Each array is a UInt64 byte count followed by the raw values, or the compressed
+//   block header followed by the compressed blocks. The DataArray elements reference
+//   the arrays by their offset within the section.
+//
+// ---------------------------------------------------------------------------------------
+class AppendedData {
+   public:
+    AppendedData(size_t num_arrays, const VtuCompression &compression)
+        : compression_(compression) {
+        headers_.reserve(num_arrays);
+    }
+
+    // DataArray element of an array whose bytes are at data
+    std::string add(const std::string &name, const std::string &type, int num_components,
+                    const void *data, size_t size, const std::string &extra = {}) {
+        std::string element = fmt::format(
+            "<DataArray type=\"{}\" Name=\"{}\" NumberOfComponents=\"{}\"{} "
+            "format=\"appended\" offset=\"{}\"/>\n",
+            type, xml_escape(name), num_components, extra, offset_);
+
+        std::vector<std::uint64_t> &header = headers_.emplace_back();
+        if (compression_.compressor.empty()) {
+            header.push_back(static_cast<std::uint64_t>(size));
+            segments_.push_back({header.data(), sizeof(std::uint64_t)});
+            segments_.push_back({data, size});
+            offset_ += sizeof(std::uint64_t) + size;
+            return element;
+        }
+
+        std::vector<std::vector<unsigned char>> blocks =
+            compress_blocks(data, size, compression_);
+        header = {blocks.size(), VTU_BLOCK_SIZE, size % VTU_BLOCK_SIZE};
+        for (const auto &block : blocks) {
+            header.push_back(block.size());
+        }
+        segments_.push_back({header.data(), header.size() * sizeof(std::uint64_t)});
+        offset_ += header.size() * sizeof(std::uint64_t);
+        for (const auto &block : blocks) {
+            segments_.push_back({block.data(), block.size()});
+            offset_ += block.size();
+        }
+        // The block buffers move along with their vector, so the segments stay valid
+        blocks_.push_back(std::move(blocks));
+        return element;
+    }
+
+    std::string add(vtkDataArray *array, std::string extra = {}) {
+        const size_t size = static_cast<size_t>(array->GetNumberOfValues()) *
+                            static_cast<size_t>(array->GetDataTypeSize());
+        for (int k = 0; k < array->GetNumberOfComponents(); ++k) {
+            if (const char *component = array->GetComponentName(k)) {
+                extra += fmt::format(" ComponentName{}=\"{}\"", k, xml_escape(component));
+            }
+        }
+        return add(array->GetName() ? array->GetName() : "", vtk_xml_type(array),
+                   array->GetNumberOfComponents(), array->GetVoidPointer(0), size, extra);
+    }
+
+    const std::vector<Segment> &segments() const { return segments_; }
+
+   private:
+    const VtuCompression &compression_;
+    std::vector<std::vector<std::uint64_t>> headers_;  // Reserved: segments point into it
+    std::vector<std::vector<std::vector<unsigned char>>> blocks_;
+    std::vector<Segment> segments_;
+    size_t offset_ = 0;
+};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write an unstructured grid file (.vtu)
+//
+// ---------------------------------------------------------------------------------------
+void write_vtu(const fs::path &file, const VtuPiece &piece,
+               const VtuCompression &compression) {
+    ScopedTimer timer{"write_vtu",
+                      [&] { return nlohmann::json{{"file", file.filename().string()}}; }};
+
+    const size_t num_points = static_cast<size_t>(piece.points->GetNumberOfTuples());
+    AppendedData appended{4 + piece.point_data.size() + piece.cell_data.size() +
+                              piece.field_data.size(),
+                          compression};
+
+    // VTK XML offsets are the end of each cell (no leading zero), types are UInt8
+    std::vector<std::uint8_t> types(piece.types, piece.types + piece.num_cells);
+    const size_t offset_size = static_cast<size_t>(piece.offsets->GetDataTypeSize());
+    const void *offsets = static_cast<const char *>(piece.offsets->GetVoidPointer(0)) +
+                          offset_size;
+
+    std::string compressor;
+    if (!compression.compressor.empty()) {
+        compressor = fmt::format(" compressor=\"{}\"",
+                                 compressor_class(compression.compressor));
+    }
+
+    std::string xml = fmt::format(
+        "<?xml version=\"1.0\"?>\n"
+        "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" "
+        "header_type=\"UInt64\"{}>\n"
+        "  <UnstructuredGrid>\n",
+        compressor);
+
+    if (!piece.field_data.empty()) {
+        xml += "    <FieldData>\n";
+        for (auto *array : piece.field_data) {
+            xml += "      " + appended.add(array, fmt::format(" NumberOfTuples=\"{}\"",
+                                                             array->GetNumberOfTuples()));
+        }
+        xml += "    </FieldData>\n";
+    }
+
+    xml += fmt::format("    <Piece NumberOfPoints=\"{}\" NumberOfCells=\"{}\">\n",
+                       num_points, piece.num_cells);
+
+    std::string vectors;
+    for (auto *array : piece.point_data) {
+        if (array->GetNumberOfComponents() == 3) {
+            vectors = fmt::format(" Vectors=\"{}\"", xml_escape(array->GetName()));
+        }
+    }
+    xml += fmt::format("      <PointData{}>\n", vectors);
+    for (auto *array : piece.point_data) {
+        xml += "        " + appended.add(array);
+    }
+    xml += "      </PointData>\n      <CellData>\n";
+    for (auto *array : piece.cell_data) {
+        xml += "        " + appended.add(array);
+    }
+    xml += "      </CellData>\n      <Points>\n";
+    xml += "        " + appended.add("Points", vtk_xml_type(piece.points), 3,
+                                     piece.points->GetVoidPointer(0),
+                                     num_points * 3 * piece.points->GetDataTypeSize());
+    xml += "      </Points>\n      <Cells>\n";
+    xml += "        " +
+           appended.add("connectivity", vtk_xml_type(piece.connectivity), 1,
+                        piece.connectivity->GetVoidPointer(0),
+                        static_cast<size_t>(piece.connectivity->GetNumberOfValues()) *
+                            piece.connectivity->GetDataTypeSize());
+    xml += "        " + appended.add("offsets", vtk_xml_type(piece.offsets), 1, offsets,
+                                     piece.num_cells * offset_size);
+    xml += "        " + appended.add("types", "UInt8", 1, types.data(), types.size());
+    xml +=
+        "      </Cells>\n"
+        "    </Piece>\n"
+        "  </UnstructuredGrid>\n"
+        "  <AppendedData encoding=\"raw\">\n   _";
+
+    static const std::string footer = "\n  </AppendedData>\n</VTKFile>\n";
+
+    std::vector<Segment> segments{{xml.data(), xml.size()}};
+    segments.insert(segments.end(), appended.segments().begin(),
+                    appended.segments().end());
+    segments.push_back({footer.data(), footer.size()});
+    write_segments(file, segments);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Write a partitioned dataset collection file (.vtpc)
+//
+// ---------------------------------------------------------------------------------------
+void write_vtpc(
+    const fs::path &file,
+    const std::vector<std::pair<std::string, std::vector<std::string>>> &datasets) {
+    std::string xml =
+        "<?xml version=\"1.0\"?>\n"
+        "<VTKFile type=\"vtkPartitionedDataSetCollection\" version=\"1.0\" "
+        "byte_order=\"LittleEndian\" header_type=\"UInt64\">\n"
+        "  <vtkPartitionedDataSetCollection>\n";
+    for (size_t i = 0; i < datasets.size(); ++i) {
+        const auto &[name, vtu_files] = datasets[i];
+        xml += fmt::format("    <Partitions index=\"{}\" name=\"{}\">\n", i,
+                           xml_escape(name));
+        for (size_t j = 0; j < vtu_files.size(); ++j) {
+            xml += fmt::format("      <DataSet index=\"{}\" file=\"{}\"/>\n", j,
+                               xml_escape(vtu_files[j]));
+        }
+        xml += "    </Partitions>\n";
+    }
+    xml += "  </vtkPartitionedDataSetCollection>\n</VTKFile>\n";
+
+    write_segments(file, {{xml.data(), xml.size()}});
+}
+
+}  // namespace otk
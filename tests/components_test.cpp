@@ -0,0 +1,107 @@
+#include "otk_test.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "otk/components.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Selector resolution and values
+//
+// ---------------------------------------------------------------------------------------
+TEST(ComponentTest, ResolveSelectors) {
+    auto selectors = otk::resolve_components("S", otk::DataType::TENSOR_3D_FULL,
+                                             {"S11", "S13", "S23", "MISES", "PRESS"});
+    ASSERT_EQ(selectors.size(), 5u);
+    EXPECT_EQ(selectors[0].name, "S11");
+    EXPECT_EQ(selectors[0].column, 0);
+    EXPECT_EQ(selectors[1].column, 4);
+    EXPECT_EQ(selectors[2].column, 5);
+    EXPECT_EQ(selectors[3].name, "S_MISES");
+    EXPECT_EQ(selectors[3].invariant, otk::Invariant::MISES);
+    EXPECT_EQ(selectors[4].name, "S_PRESS");
+
+    selectors = otk::resolve_components("LE", otk::DataType::TENSOR_2D_PLANAR, {"LE12"});
+    EXPECT_EQ(selectors[0].column, 2);
+    selectors = otk::resolve_components("U", otk::DataType::VECTOR, {"U3", "MAGNITUDE"});
+    EXPECT_EQ(selectors[0].column, 2);
+    EXPECT_EQ(selectors[1].name, "U_MAGNITUDE");
+
+    EXPECT_THROW(otk::resolve_components("U", otk::DataType::VECTOR, {"MISES"}),
+                 std::runtime_error);
+    EXPECT_THROW(otk::resolve_components("S", otk::DataType::TENSOR_3D_PLANAR, {"S13"}),
+                 std::runtime_error);
+    EXPECT_THROW(otk::resolve_components("S", otk::DataType::TENSOR_3D_FULL, {"U1"}),
+                 std::runtime_error);
+}
+
+TEST(ComponentTest, EvaluateInvariants) {
+    const double full[6] = {100.0, 20.0, -30.0, 10.0, 5.0, -4.0};
+    const double mises =
+        std::sqrt(0.5 * (80.0 * 80.0 + 50.0 * 50.0 + 130.0 * 130.0) +
+                  3.0 * (10.0 * 10.0 + 5.0 * 5.0 + 4.0 * 4.0));
+    auto evaluate = [](const std::string &name, otk::DataType type, const double *row,
+                       int width) {
+        auto selector = otk::resolve_components("S", type, {name})[0];
+        return otk::evaluate_component(selector, type, row, width);
+    };
+    EXPECT_DOUBLE_EQ(evaluate("MISES", otk::DataType::TENSOR_3D_FULL, full, 6), mises);
+    EXPECT_DOUBLE_EQ(evaluate("PRESS", otk::DataType::TENSOR_3D_FULL, full, 6), -30.0);
+    EXPECT_DOUBLE_EQ(evaluate("S23", otk::DataType::TENSOR_3D_FULL, full, 6), -4.0);
+
+    // Plane stress rows (11, 22, 12) have no out-of-plane components
+    const double planar[3] = {100.0, 20.0, 10.0};
+    EXPECT_DOUBLE_EQ(evaluate("MISES", otk::DataType::TENSOR_2D_PLANAR, planar, 3),
+                     std::sqrt(0.5 * (80.0 * 80.0 + 20.0 * 20.0 + 100.0 * 100.0) +
+                               3.0 * 10.0 * 10.0));
+    EXPECT_DOUBLE_EQ(evaluate("S12", otk::DataType::TENSOR_2D_PLANAR, planar, 3), 10.0);
+
+    const double vector[3] = {3.0, 4.0, 12.0};
+    auto magnitude = otk::resolve_components("U", otk::DataType::VECTOR, {"MAGNITUDE"});
+    EXPECT_DOUBLE_EQ(
+        otk::evaluate_component(magnitude[0], otk::DataType::VECTOR, vector, 3), 13.0);
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Selected components are written as scalar arrays instead of the whole fields
+//
+// ---------------------------------------------------------------------------------------
+TEST_F(ConverterTest, SelectedComponents) {
+    fs::path output = convert(
+        make_config(2),
+        {{"format", "npz"},
+         {"fields",
+          {{{"key", "S1"}, {"components", {"S113", "MISES"}}},
+           {{"key", "U"}, {"components", {"U3", "MAGNITUDE"}}}}}});
+
+    auto mesh = read_npz(output / "synthetic_mesh.npz");
+    auto frame = read_npz(output / "synthetic_0.npz");
+    const std::string prefix = "PART-1-1/";
+    EXPECT_FALSE(frame.contains(prefix + "S1.npy"));
+    EXPECT_FALSE(frame.contains(prefix + "U.npy"));
+    for (const std::string name : {"S113", "S1_MISES", "U3", "U_MAGNITUDE"}) {
+        ASSERT_TRUE(frame.contains(prefix + name + ".npy")) << name;
+        EXPECT_NE(frame[prefix + name + ".npy"].header.find("'shape': (27,)"),
+                  std::string::npos)
+            << name;
+    }
+
+    const NpyArray &labels = mesh[prefix + "node_labels.npy"];
+    for (size_t i = 0; i < 27; ++i) {
+        const int label = labels.as<std::int32_t>()[i];
+        auto s = [label](int j) { return synthetic_value(label, j); };
+        const double mises = std::sqrt(0.5 * (1.0 + 1.0 + 4.0) +
+                                       3.0 * (s(3) * s(3) + s(4) * s(4) + s(5) * s(5)));
+        EXPECT_DOUBLE_EQ(frame[prefix + "S113.npy"].as<double>()[i], s(4));
+        EXPECT_DOUBLE_EQ(frame[prefix + "S1_MISES.npy"].as<double>()[i], mises);
+        EXPECT_DOUBLE_EQ(frame[prefix + "U3.npy"].as<double>()[i], s(2));
+        EXPECT_DOUBLE_EQ(frame[prefix + "U_MAGNITUDE.npy"].as<double>()[i],
+                         std::sqrt(s(0) * s(0) + s(1) * s(1) + s(2) * s(2)));
+    }
+}
+
+}  // namespace otk::test
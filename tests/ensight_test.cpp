@@ -0,0 +1,72 @@
+#include "otk_test.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   EnSight Gold case: geometry, per-node and per-element variables and their time sets
+//
+//   Binary records are 80-character strings, int32 and float32 values; variables hold
+//   each component of a part one after the other.
+//
+// ---------------------------------------------------------------------------------------
+TEST_F(ConverterTest, EnsightCase) {
+    otk::SyntheticConfig config = make_config(2);
+    config.frames = 2;
+    fs::path output = convert(
+        config,
+        {{"format", "ensight"},
+         {"fields", {{{"key", "U"}}, {{"key", "EVOL1"}}, {{"key", "S1"}}}}});
+    constexpr size_t NUM_POINTS = 27;
+    constexpr size_t NUM_CELLS = 8;
+
+    const std::string case_file = read_file(output / "synthetic.case");
+    for (const std::string line :
+         {"model: synthetic.geo", "scalar per element: 1 EVOL1 synthetic_EVOL1.*****",
+          "tensor symm per node: 2 S1 synthetic_S1.*****",
+          "vector per node: 3 U synthetic_U.*****", "number of steps: 2"}) {
+        EXPECT_NE(case_file.find(line + "\n"), std::string::npos) << line;
+    }
+    EXPECT_NE(case_file.find("time values:\n0\n1\n"), std::string::npos);
+
+    // Geometry: header, one part with the node labels, coordinates and hexa8 cells
+    const std::string geo = read_file(output / "synthetic.geo");
+    EXPECT_EQ(read_record(geo, 0), "C Binary");
+    EXPECT_EQ(read_record(geo, 400), "part");
+    EXPECT_EQ(read_value<std::int32_t>(geo, 480), 1);
+    EXPECT_EQ(read_record(geo, 484), INSTANCE);
+    EXPECT_EQ(read_record(geo, 564), "coordinates");
+    ASSERT_EQ(read_value<std::int32_t>(geo, 644), static_cast<int>(NUM_POINTS));
+    for (size_t i = 0; i < NUM_POINTS; ++i) {
+        EXPECT_EQ(read_value<std::int32_t>(geo, 648 + 4 * i), static_cast<int>(i + 1));
+    }
+    const size_t cells = 648 + 4 * 4 * NUM_POINTS;
+    EXPECT_EQ(read_record(geo, cells), "hexa8");
+    ASSERT_EQ(read_value<std::int32_t>(geo, cells + 80), static_cast<int>(NUM_CELLS));
+    ASSERT_EQ(geo.size(), cells + 84 + 4 * NUM_CELLS + 4 * 8 * NUM_CELLS);
+
+    // Tensors in the "tensor symm" order, which is the order of the Abaqus components
+    const std::string s = read_file(output / "synthetic_S1.00000");
+    EXPECT_EQ(read_record(s, 0), "S1");
+    EXPECT_EQ(read_record(s, 80), "part");
+    EXPECT_EQ(read_record(s, 164), "coordinates");
+    ASSERT_EQ(s.size(), 244 + 4 * 6 * NUM_POINTS);
+    for (int k = 0; k < 6; ++k) {
+        for (size_t i = 0; i < NUM_POINTS; ++i) {
+            EXPECT_FLOAT_EQ(read_value<float>(s, 244 + 4 * (k * NUM_POINTS + i)),
+                            synthetic_value(static_cast<int>(i + 1), k));
+        }
+    }
+
+    // Element values per element type block
+    const std::string evol = read_file(output / "synthetic_EVOL1.00000");
+    EXPECT_EQ(read_record(evol, 164), "hexa8");
+    ASSERT_EQ(evol.size(), 244 + 4 * NUM_CELLS);
+    for (size_t i = 0; i < NUM_CELLS; ++i) {
+        EXPECT_FLOAT_EQ(read_value<float>(evol, 244 + 4 * i),
+                        synthetic_value(static_cast<int>(i + 1), 0));
+    }
+    EXPECT_TRUE(fs::exists(output / "synthetic_U.00001"));
+}
+
+}  // namespace otk::test
@@ -0,0 +1,71 @@
+#include "otk_test.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "otk/expression.hpp"
+#include "otk/store.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Expressions
+//
+// ---------------------------------------------------------------------------------------
+TEST(ExpressionTest, EvaluatesOperatorsAndFunctions) {
+    const std::vector<double> x{-2.0, 0.0, 0.5, 3.0};
+    const std::vector<double> y{1.0, 4.0, 2.0, 4.0};
+    std::vector<double> output(x.size());
+
+    auto evaluate = [&](const std::string &text) {
+        otk::Expression expression{text, {{"K", 2.0}}};
+        std::vector<const double *> inputs;
+        for (const auto &variable : expression.variables()) {
+            inputs.push_back(variable == "X" ? x.data() : y.data());
+        }
+        expression.evaluate(inputs, output.data(), x.size());
+        return output;
+    };
+
+    EXPECT_EQ(evaluate("sqrt(X^2 + Y^2)"),
+              (std::vector<double>{std::sqrt(5.0), 4.0, std::sqrt(4.25), 5.0}));
+    EXPECT_EQ(evaluate("-X * K + Y / K"), (std::vector<double>{4.5, 2.0, 0.0, -4.0}));
+    EXPECT_EQ(evaluate("2^3^2 + 0 * X"), (std::vector<double>(4, 512.0)));
+    EXPECT_EQ(evaluate("X > 0.25"), (std::vector<double>{0.0, 0.0, 1.0, 1.0}));
+    EXPECT_EQ(evaluate("max(abs(X), min(Y, K))"),
+              (std::vector<double>{2.0, 2.0, 2.0, 3.0}));
+    EXPECT_THROW(otk::Expression{"sqrt(X"}, std::runtime_error);
+}
+
+// Derived fields evaluated over the converted arrays of a frame
+TEST_F(ConverterTest, DerivedFields) {
+    fs::path output = convert(make_config(4), {{"format", "store"},
+                                               {"fields", {{{"key", "U"}}}},
+                                               {"constants", {{"ALLOW", 60.0}}},
+                                               {"derived",
+                                                {{{"name", "U_PLANE"},
+                                                  {"expression", "sqrt(U1^2 + U2^2)"}},
+                                                 {{"name", "HOT"},
+                                                  {"expression", "NT1 > ALLOW"}}}}});
+
+    otk::Store store{output / "synthetic.otks"};
+    otk::Store::Chunk u_plane = store.field(STEP, 0, INSTANCE, "U_PLANE");
+    otk::Store::Chunk hot = store.field(STEP, 0, INSTANCE, "HOT");
+    ASSERT_TRUE(u_plane);
+    ASSERT_TRUE(hot);
+    ASSERT_EQ(u_plane.num_rows, 125u);
+    ASSERT_EQ(u_plane.num_components, 1);
+
+    // Points are in node label order
+    for (int i = 0; i < 125; ++i) {
+        const int label = i + 1;
+        const double u1 = synthetic_value(label, 0);
+        const double u2 = synthetic_value(label, 1);
+        EXPECT_DOUBLE_EQ(u_plane.as<double>()[i], std::sqrt(u1 * u1 + u2 * u2));
+        EXPECT_EQ(hot.as<double>()[i], synthetic_value(label, 0) > 60.0 ? 1.0 : 0.0);
+    }
+}
+
+}  // namespace otk::test
@@ -0,0 +1,111 @@
+#include "otk_test.hpp"
+
+#include "otk/history.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Time histories of selected nodes and elements over all frames
+//
+//   The model is named job.1 so that the stem keeps its dot in the file names. Node
+//   label 100 is not in the model and gets no columns.
+//
+// ---------------------------------------------------------------------------------------
+using HistoryTest = ConverterTest;
+
+TEST_F(HistoryTest, NodeAndElementSeries) {
+    otk::SyntheticConfig config = make_config(2);
+    config.frames = 3;
+    otk::SyntheticSource source{config};
+    json request = {
+        {"fields", {{{"key", "U"}}, {{"key", "EVOL1"}}}},
+        {"frames", {{{"step", STEP}}}},
+        {"history",
+         {{"format", {"csv", "binary"}},
+          {"nodes", {{{"instance", INSTANCE}, {"labels", {5, 1, 5, 100}}}}},
+          {"elements", {{{"instance", INSTANCE}, {"set", "ALL"}}}}}}};
+    otk::History history{request};
+    history.extract(source, directory_ / "job.1.odb");
+
+    const fs::path output = directory_ / "job.1";
+    const std::string csv = read_file(output / "job.1_history_U.csv");
+    EXPECT_EQ(csv.substr(0, csv.find('\n')),
+              "step,frame,value,PART-1-1.N1.1,PART-1-1.N1.2,PART-1-1.N1.3,"
+              "PART-1-1.N5.1,PART-1-1.N5.2,PART-1-1.N5.3");
+    EXPECT_EQ(std::count(csv.begin(), csv.end(), '\n'), 4);
+
+    const json description =
+        json::parse(read_file(output / "job.1_history_EVOL1.json"));
+    EXPECT_EQ(description["dtype"], "float32");
+    EXPECT_EQ(description["shape"], json({3, 8}));
+    EXPECT_EQ(description["columns"][7], "PART-1-1.E8");
+    EXPECT_EQ(description["frames"], json({0, 1, 2}));
+    EXPECT_EQ(description["values"], json({0.0, 0.5, 1.0}));
+
+    // Records of float32 values in column order; frame f scales the label by 1 + f / 100
+    const std::string u = read_file(output / "job.1_history_U.bin");
+    const std::string evol = read_file(output / "job.1_history_EVOL1.bin");
+    ASSERT_EQ(u.size(), 3 * 6 * sizeof(float));
+    ASSERT_EQ(evol.size(), 3 * 8 * sizeof(float));
+    for (int frame = 0; frame < 3; ++frame) {
+        const double scale = 1.0 + 0.01 * frame;
+        for (int j = 0; j < 3; ++j) {
+            EXPECT_FLOAT_EQ(read_value<float>(u, 4 * (6 * frame + j)), scale * 1 + j);
+            EXPECT_FLOAT_EQ(read_value<float>(u, 4 * (6 * frame + 3 + j)), scale * 5 + j);
+        }
+        for (int i = 0; i < 8; ++i) {
+            EXPECT_FLOAT_EQ(read_value<float>(evol, 4 * (8 * frame + i)),
+                            scale * (i + 1));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   History outputs of the regions matching the request (the synthetic outputs are
+//   scale * t^2 at ten times per frame, scale being 1 + the index of the output)
+//
+// ---------------------------------------------------------------------------------------
+TEST_F(HistoryTest, RegionOutputs) {
+    otk::SyntheticConfig config = make_config(2, 2);
+    config.frames = 3;
+    otk::SyntheticSource source{config};
+    json request = {{"fields", {{{"key", "ALL.*"}}, {{"key", "RF2"}}}},
+                    {"frames", {{{"step", STEP}}}},
+                    {"history",
+                     {{"format", {"csv", "binary"}},
+                      {"regions", {"Assembly .*", "Node PART-2-1\\..*"}}}}};
+    otk::History history{request};
+    history.extract(source, directory_ / "synthetic.odb");
+
+    const fs::path output = directory_ / "synthetic";
+    const std::string csv =
+        read_file(output / "synthetic_history_Step-1_Assembly_ASSEMBLY.csv");
+    EXPECT_EQ(csv.substr(0, csv.find('\n')), "time,ALLIE,ALLKE");
+    EXPECT_EQ(std::count(csv.begin(), csv.end(), '\n'), 22);
+    EXPECT_TRUE(fs::exists(output / "synthetic_history_Step-1_Node_PART-2-1_1.csv"));
+    EXPECT_FALSE(fs::exists(output / "synthetic_history_Step-1_Node_PART-1-1_1.csv"));
+
+    const json index = json::parse(read_file(output / "synthetic_history_regions.json"));
+    EXPECT_EQ(index["dtype"], "float64");
+    ASSERT_EQ(index["outputs"].size(), 3u);
+    const std::string bytes = read_file(output / "synthetic_history_regions.bin");
+    for (size_t k = 0; k < 3; ++k) {
+        const json &entry = index["outputs"][k];
+        const double scale = (entry["output"] == "ALLIE") ? 1.0 : 2.0;
+        ASSERT_EQ(entry["length"], 21);
+        for (size_t i = 0; i < 21; ++i) {
+            const double time = read_value<double>(
+                bytes, entry["time_offset"].get<size_t>() + 8 * i);
+            EXPECT_DOUBLE_EQ(time, i / 20.0);
+            EXPECT_DOUBLE_EQ(read_value<double>(
+                                 bytes, entry["values_offset"].get<size_t>() + 8 * i),
+                             scale * time * time);
+        }
+    }
+    EXPECT_EQ(index["outputs"][2]["region"], "Node PART-2-1.1");
+    EXPECT_EQ(bytes.size(), 3 * 2 * 21 * sizeof(double));
+}
+
+}  // namespace otk::test
@@ -0,0 +1,59 @@
+#include "otk_test.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   NumPy export
+//
+// ---------------------------------------------------------------------------------------
+TEST_F(ConverterTest, NumpyRoundTrip) {
+    fs::path output =
+        convert(make_config(3), {{"format", "npz"},
+                                 {"fields", {{{"key", "U"}}, {{"key", "PEEQ1"}}}}});
+
+    auto mesh = read_npz(output / "synthetic_mesh.npz");
+    auto frame = read_npz(output / "synthetic_0.npz");
+    const std::string prefix = "PART-1-1/";
+    ASSERT_TRUE(mesh.contains(prefix + "points.npy"));
+    ASSERT_TRUE(frame.contains(prefix + "U.npy"));
+    ASSERT_TRUE(frame.contains(prefix + "PEEQ1.npy"));
+
+    const NpyArray &labels = mesh[prefix + "node_labels.npy"];
+    const NpyArray &u = frame[prefix + "U.npy"];
+    const NpyArray &peeq = frame[prefix + "PEEQ1.npy"];
+    EXPECT_NE(u.header.find("'descr': '<f8'"), std::string::npos);
+    EXPECT_NE(u.header.find("'shape': (64, 3)"), std::string::npos);
+    EXPECT_NE(peeq.header.find("'shape': (64,)"), std::string::npos);
+    ASSERT_EQ(labels.size<std::int32_t>(), 64u);
+    ASSERT_EQ(u.size<double>(), 3 * 64u);
+    ASSERT_EQ(peeq.size<double>(), 64u);
+
+    for (size_t i = 0; i < 64; ++i) {
+        const int label = labels.as<std::int32_t>()[i];
+        for (int j = 0; j < 3; ++j) {
+            EXPECT_EQ(u.as<double>()[3 * i + j], synthetic_value(label, j));
+        }
+        EXPECT_DOUBLE_EQ(peeq.as<double>()[i], synthetic_value(label, 0));
+    }
+}
+
+// ODB names with a dot keep their whole stem in the archive names
+TEST_F(ConverterTest, NumpyDottedOdbName) {
+    otk::SyntheticConfig config = make_config(2);
+    config.frames = 2;
+    fs::path output = convert(config, {{"format", "npz"}, {"fields", {{{"key", "U"}}}}},
+                              "job_1.5mm");
+
+    EXPECT_TRUE(fs::is_regular_file(output / "job_1.5mm_mesh.npz"));
+    EXPECT_TRUE(fs::is_regular_file(output / "job_1.5mm_0.npz"));
+    EXPECT_TRUE(fs::is_regular_file(output / "job_1.5mm_1.npz"));
+    EXPECT_FALSE(fs::exists(output / "job_1.npz"));
+
+    auto mesh = read_npz(output / "job_1.5mm_mesh.npz");
+    auto frame = read_npz(output / "job_1.5mm_1.npz");
+    EXPECT_TRUE(mesh.contains("PART-1-1/points.npy"));
+    EXPECT_TRUE(frame.contains("PART-1-1/U.npy"));
+}
+
+}  // namespace otk::test
@@ -0,0 +1,82 @@
+#include "otk_test.hpp"
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+#include "otk/orientation.hpp"
+#include "otk/store.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Whole tensors, in their native axes and rotated to the global axes
+//
+//   The synthetic results have no local orientation, so the rotation to the global axes
+//   keeps the values; both are written in the VTK symmetric tensor order.
+//
+// ---------------------------------------------------------------------------------------
+class TensorTest : public ConverterTest, public ::testing::WithParamInterface<bool> {};
+
+TEST_P(TensorTest, WholeTensorsInVtkOrder) {
+    const otk::SyntheticConfig config = make_config(2);
+    json request = {{"format", {"vtk", "store"}}, {"fields", {{{"key", "S1"}}}}};
+    if (GetParam()) {
+        request["orientation"] = "global";
+    }
+    fs::path output = convert(config, request);
+
+    otk::Store store{output / "synthetic.otks"};
+    otk::Store::Chunk s = store.field(STEP, 0, INSTANCE, "S1");
+    ASSERT_TRUE(s);
+    ASSERT_EQ(s.num_rows, 27u);
+    ASSERT_EQ(s.num_components, 6);
+    for (int i = 0; i < 27; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            EXPECT_DOUBLE_EQ(s.as<double>()[6 * i + j],
+                             synthetic_value(i + 1, VTK_TENSOR_ROWS[j]));
+        }
+    }
+
+    auto grid = read_vtu(output / "synthetic_0" / "synthetic_0_0_0.vtu");
+    vtkDataArray *array = grid->GetPointData()->GetArray("S1");
+    ASSERT_NE(array, nullptr);
+    ASSERT_EQ(array->GetNumberOfComponents(), 6);
+    const std::vector<std::string> names{"S111", "S122", "S133", "S112", "S123", "S113"};
+    for (int j = 0; j < 6; ++j) {
+        ASSERT_NE(array->GetComponentName(j), nullptr);
+        EXPECT_EQ(array->GetComponentName(j), names[j]);
+        EXPECT_DOUBLE_EQ(array->GetComponent(0, j),
+                         synthetic_value(1, VTK_TENSOR_ROWS[j]));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Orientation, TensorTest, ::testing::Bool());
+
+// ---------------------------------------------------------------------------------------
+//
+//   User axes: normalized, and rejected unless orthogonal and right-handed
+//
+// ---------------------------------------------------------------------------------------
+TEST(MakeAxes, NormalizesOrthogonalAxes) {
+    const otk::Matrix3 axes =
+        otk::make_axes({{{0.0, 2.0, 0.0}, {-3.0, 0.0, 0.0}, {0.0, 0.0, 1.0}}});
+    const otk::Matrix3 expected{0.0, 1.0, 0.0, -1.0, 0.0, 0.0, 0.0, 0.0, 1.0};
+    for (int i = 0; i < 9; ++i) {
+        EXPECT_DOUBLE_EQ(axes[i], expected[i]);
+    }
+}
+
+TEST(MakeAxes, RejectsInvalidAxes) {
+    // Zero, collinear, skewed and left-handed axes
+    EXPECT_THROW(otk::make_axes({{{0.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}}}),
+                 std::runtime_error);
+    EXPECT_THROW(otk::make_axes({{{1.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {0.0, 0.0, 1.0}}}),
+                 std::runtime_error);
+    EXPECT_THROW(otk::make_axes({{{1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}, {0.0, 0.0, 1.0}}}),
+                 std::runtime_error);
+    EXPECT_THROW(otk::make_axes({{{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, -1.0}}}),
+                 std::runtime_error);
+}
+
+}  // namespace otk::test
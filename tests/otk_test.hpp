@@ -0,0 +1,176 @@
+#ifndef OTK_TEST_HPP
+#define OTK_TEST_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkXMLUnstructuredGridReader.h>
+
+#include "otk/converter.hpp"
+#include "otk/output.hpp"
+#include "otk/synthetic.hpp"
+
+namespace fs = std::filesystem;
+
+namespace otk::test {
+
+using nlohmann::json;
+
+inline const std::string INSTANCE = "PART-1-1";
+inline const std::string STEP = "Step-1";
+
+// ---------------------------------------------------------------------------------------
+//
+//   Synthetic model with n x n x n elements per instance and a single frame
+//
+//   The field values of frame 0 are label % 1000 + component, so averaged ELEMENT_NODAL
+//   rows (labelled with the node labels) give the same value at each node.
+//
+// ---------------------------------------------------------------------------------------
+inline otk::SyntheticConfig make_config(int n, int instances = 1) {
+    otk::SyntheticConfig config;
+    config.instances = instances;
+    config.nx = n;
+    config.ny = n;
+    config.nz = n;
+    config.frames = 1;
+    return config;
+}
+
+inline double synthetic_value(int label, int component) {
+    return label % 1000 + component;
+}
+
+// Row component (11, 22, 33, 12, 13, 23) of each component of a VTK tensor array
+// (XX, YY, ZZ, XY, YZ, XZ)
+inline constexpr int VTK_TENSOR_ROWS[6] = {0, 1, 2, 3, 5, 4};
+
+// ---------------------------------------------------------------------------------------
+//
+//   Contents of a file, and the binary values and 80-character records in it
+//
+// ---------------------------------------------------------------------------------------
+inline std::string read_file(const fs::path &file) {
+    std::ifstream stream{file, std::ios::binary};
+    return {std::istreambuf_iterator<char>(stream), {}};
+}
+
+template <typename T>
+T read_value(const std::string &bytes, size_t offset) {
+    T value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+inline std::string read_record(const std::string &bytes, size_t offset) {
+    return bytes.substr(offset, 80).c_str();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Members of an uncompressed .npz archive, parsed from the zip local headers
+//
+// ---------------------------------------------------------------------------------------
+struct NpyArray {
+    std::string header;
+    std::vector<unsigned char> data;
+
+    template <typename T>
+    const T *as() const {
+        return reinterpret_cast<const T *>(data.data());
+    }
+    template <typename T>
+    size_t size() const {
+        return data.size() / sizeof(T);
+    }
+};
+
+inline std::map<std::string, NpyArray> read_npz(const fs::path &file) {
+    const std::string bytes = read_file(file);
+
+    std::map<std::string, NpyArray> members;
+    size_t position = 0;
+    while (position + 30 <= bytes.size() &&
+           read_value<std::uint32_t>(bytes, position) == 0x04034b50) {
+        const auto size = read_value<std::uint32_t>(bytes, position + 18);
+        const auto name_size = read_value<std::uint16_t>(bytes, position + 26);
+        const auto extra_size = read_value<std::uint16_t>(bytes, position + 28);
+        const std::string name = bytes.substr(position + 30, name_size);
+        const size_t start = position + 30 + name_size + extra_size;
+
+        // .npy: magic and version (8 bytes), header length (uint16), header
+        const auto header_size = read_value<std::uint16_t>(bytes, start + 8);
+        NpyArray &array = members[name];
+        array.header = bytes.substr(start + 10, header_size);
+        array.data.assign(bytes.begin() + start + 10 + header_size,
+                          bytes.begin() + start + size);
+        position = start + size;
+    }
+    return members;
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Dataset of a .vtu file
+//
+// ---------------------------------------------------------------------------------------
+inline vtkSmartPointer<vtkUnstructuredGrid> read_vtu(const fs::path &file) {
+    vtkNew<vtkXMLUnstructuredGridReader> reader;
+    reader->SetFileName(file.string().c_str());
+    reader->Update();
+    return reader->GetOutput();
+}
+
+// ---------------------------------------------------------------------------------------
+//
+//   Fixture converting a synthetic model into a temporary directory
+//
+// ---------------------------------------------------------------------------------------
+class ConverterTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+        std::string name = fmt::format("otk_test_{}_{}", info->test_suite_name(),
+                                       info->name());
+        std::replace(name.begin(), name.end(), '/', '_');
+        directory_ = fs::temp_directory_path() / name;
+        fs::remove_all(directory_);
+        fs::create_directories(directory_);
+    }
+
+    void TearDown() override { fs::remove_all(directory_); }
+
+    // Convert the model as <name>.odb; returns the output directory <name>
+    fs::path convert(const otk::SyntheticConfig &config, json request,
+                     const std::string &name = "synthetic") {
+        request["frames"] = json::array({{{"step", STEP}}});
+        EXPECT_TRUE(otk::is_output_request_valid(request)) << request.dump();
+
+        otk::SyntheticSource source{config};
+        otk::Converter converter{request};
+        converter.convert(source, directory_ / (name + ".odb"));
+        return directory_ / name;
+    }
+
+    fs::path directory_;
+};
+
+
+}  // namespace otk::test
+
+#endif  // !OTK_TEST_HPP
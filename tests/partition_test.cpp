@@ -0,0 +1,67 @@
+#include "otk_test.hpp"
+
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Spatial partitions of an instance, with either writer
+//
+//   The 4 x 4 x 4 block is bisected along x, then each half along y, so partition p
+//   holds the 16 elements with x >= 2 for p >= 2 and y >= 2 for odd p (element label
+//   1 + i + 4 * (j + 4 * k)). Every partition is written with the values of its own
+//   points and cells.
+//
+// ---------------------------------------------------------------------------------------
+class PartitionTest : public ConverterTest,
+                      public ::testing::WithParamInterface<std::string> {};
+
+TEST_P(PartitionTest, RecursiveBisection) {
+    fs::path output = convert(
+        make_config(4),
+        {{"vtk", {{"writer", GetParam()}, {"partitions", 4}, {"min_cells", 1}}},
+         {"fields", {{{"key", "U"}}, {{"key", "EVOL1"}}}}});
+
+    std::vector<int> partition_of(64, -1);
+    for (int p = 0; p < 4; ++p) {
+        const std::string file = fmt::format("synthetic_0_0_{}.vtu", p);
+        auto grid = read_vtu(output / "synthetic_0" / file);
+        ASSERT_EQ(grid->GetNumberOfCells(), 16) << file;
+        ASSERT_EQ(grid->GetNumberOfPoints(), 3 * 3 * 5);
+
+        vtkDataArray *evol = grid->GetCellData()->GetArray("EVOL1");
+        ASSERT_NE(evol, nullptr);
+        for (vtkIdType c = 0; c < 16; ++c) {
+            const int label = static_cast<int>(evol->GetComponent(c, 0));
+            ASSERT_GE(label, 1);
+            ASSERT_LE(label, 64);
+            EXPECT_EQ(partition_of[label - 1], -1) << "Element " << label;
+            partition_of[label - 1] = p;
+            EXPECT_EQ((label - 1) % 4 >= 2, p >= 2) << "Element " << label;
+            EXPECT_EQ((label - 1) / 4 % 4 >= 2, p % 2 == 1) << "Element " << label;
+        }
+
+        vtkDataArray *u = grid->GetPointData()->GetArray("U");
+        ASSERT_NE(u, nullptr);
+        for (vtkIdType i = 0; i < grid->GetNumberOfPoints(); ++i) {
+            double point[3];
+            grid->GetPoint(i, point);
+            const auto x = static_cast<int>(point[0]);
+            const auto y = static_cast<int>(point[1]);
+            const auto z = static_cast<int>(point[2]);
+            const int label = 1 + x + 5 * (y + 5 * z);
+            for (int j = 0; j < 3; ++j) {
+                EXPECT_EQ(u->GetComponent(i, j), synthetic_value(label, j));
+            }
+        }
+    }
+    EXPECT_EQ(std::count(partition_of.begin(), partition_of.end(), -1), 0);
+    EXPECT_FALSE(fs::exists(output / "synthetic_0" / "synthetic_0_0_4.vtu"));
+}
+
+INSTANTIATE_TEST_SUITE_P(Writer, PartitionTest, ::testing::Values("vtk", "native"));
+
+}  // namespace otk::test
@@ -0,0 +1,75 @@
+#include "otk_test.hpp"
+
+#include <cmath>
+#include <set>
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Hilbert order
+//
+//   With 8 nodes per axis every node falls in its own cell of the level-3 curve, so
+//   consecutive points of the reordered mesh are one grid step apart.
+//
+// ---------------------------------------------------------------------------------------
+TEST_F(ConverterTest, HilbertOrder) {
+    const otk::SyntheticConfig config = make_config(7);
+    otk::SyntheticSource source{config};
+    fs::path output = convert(config, {{"format", "npz"},
+                                       {"reorder", "hilbert"},
+                                       {"fields", {{{"key", "U"}}}}});
+
+    auto mesh = read_npz(output / "synthetic_mesh.npz");
+    auto frame = read_npz(output / "synthetic_0.npz");
+    const std::string prefix = "PART-1-1/";
+    const NpyArray &points = mesh[prefix + "points.npy"];
+    const NpyArray &connectivity = mesh[prefix + "connectivity.npy"];
+    const NpyArray &node_labels = mesh[prefix + "node_labels.npy"];
+    const NpyArray &element_labels = mesh[prefix + "element_labels.npy"];
+    const NpyArray &u = frame[prefix + "U.npy"];
+
+    const otk::NodeData nodes = source.nodes(INSTANCE);
+    const otk::ElementData elements = source.elements(INSTANCE);
+    const size_t num_points = nodes.labels.size();
+    ASSERT_EQ(node_labels.size<std::int32_t>(), num_points);
+    ASSERT_EQ(points.size<float>(), 3 * num_points);
+    ASSERT_EQ(u.size<double>(), 3 * num_points);
+    ASSERT_EQ(element_labels.size<std::int32_t>(), elements.labels.size());
+
+    // Points, labels and field values are permuted together
+    std::set<int> seen;
+    for (size_t i = 0; i < num_points; ++i) {
+        const int label = node_labels.as<std::int32_t>()[i];
+        ASSERT_GE(label, 1);
+        ASSERT_LE(label, static_cast<int>(num_points));
+        seen.insert(label);
+        for (int k = 0; k < 3; ++k) {
+            EXPECT_EQ(points.as<float>()[3 * i + k],
+                      nodes.coordinates[3 * (label - 1) + k]);
+            EXPECT_EQ(u.as<double>()[3 * i + k], synthetic_value(label, k));
+        }
+    }
+    EXPECT_EQ(seen.size(), num_points);
+
+    for (size_t i = 1; i < num_points; ++i) {
+        float distance = 0.0f;
+        for (int k = 0; k < 3; ++k) {
+            distance += std::fabs(points.as<float>()[3 * i + k] -
+                                  points.as<float>()[3 * (i - 1) + k]);
+        }
+        EXPECT_EQ(distance, 1.0f) << "between points " << i - 1 << " and " << i;
+    }
+
+    // Each cell keeps the nodes of its element
+    for (size_t i = 0; i < elements.labels.size(); ++i) {
+        const int label = element_labels.as<std::int32_t>()[i];
+        for (int j = 0; j < 8; ++j) {
+            const auto point = connectivity.as<std::int64_t>()[8 * i + j];
+            EXPECT_EQ(node_labels.as<std::int32_t>()[point],
+                      elements.connectivity[8 * (label - 1) + j]);
+        }
+    }
+}
+
+}  // namespace otk::test
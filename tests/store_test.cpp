@@ -0,0 +1,147 @@
+#include "otk_test.hpp"
+
+#include "otk/store.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Frame store round-trip (mesh, shared topology and field chunks)
+//
+// ---------------------------------------------------------------------------------------
+class StoreTest : public ConverterTest,
+                  public ::testing::WithParamInterface<std::string> {};
+
+TEST_P(StoreTest, RoundTrip) {
+    const otk::SyntheticConfig config = make_config(3, 2);
+    otk::SyntheticSource source{config};
+    fs::path output = convert(
+        config, {{"format", "store"},
+                 {"store", {{"compression", GetParam()}}},
+                 {"fields", {{{"key", "U"}}, {{"key", "EVOL1"}}, {{"key", "S1"}}}}});
+
+    otk::Store store{output / "synthetic.otks"};
+    for (const auto &instance_name : source.instance_names()) {
+        const otk::NodeData nodes = source.nodes(instance_name);
+        const otk::ElementData elements = source.elements(instance_name);
+
+        otk::Store::Chunk points = store.mesh(instance_name, "points");
+        ASSERT_TRUE(points);
+        ASSERT_EQ(points.dtype, "float32");
+        ASSERT_EQ(points.num_rows, nodes.labels.size());
+        EXPECT_TRUE(std::equal(nodes.coordinates.begin(), nodes.coordinates.end(),
+                               points.as<float>()));
+
+        otk::Store::Chunk offsets = store.mesh(instance_name, "offsets");
+        otk::Store::Chunk connectivity = store.mesh(instance_name, "connectivity");
+        otk::Store::Chunk types = store.mesh(instance_name, "types");
+        ASSERT_TRUE(offsets && connectivity && types);
+        ASSERT_EQ(offsets.num_rows, elements.offsets.size());
+        ASSERT_EQ(connectivity.num_rows, elements.connectivity.size());
+        for (size_t i = 0; i < elements.connectivity.size(); ++i) {
+            EXPECT_EQ(connectivity.as<std::int64_t>()[i], elements.connectivity[i] - 1);
+        }
+        for (size_t i = 0; i < elements.labels.size(); ++i) {
+            EXPECT_EQ(types.as<std::int32_t>()[i], VTK_HEXAHEDRON);
+        }
+
+        otk::Store::Chunk u = store.field(STEP, 0, instance_name, "U");
+        otk::Store::Chunk s = store.field(STEP, 0, instance_name, "S1");
+        otk::Store::Chunk evol = store.field(STEP, 0, instance_name, "EVOL1");
+        ASSERT_TRUE(u && s && evol);
+        ASSERT_EQ(u.num_components, 3);
+        ASSERT_EQ(s.num_components, 6);
+        ASSERT_EQ(evol.num_rows, elements.labels.size());
+        for (size_t i = 0; i < nodes.labels.size(); ++i) {
+            for (int j = 0; j < 3; ++j) {
+                EXPECT_EQ(u.as<double>()[3 * i + j], synthetic_value(nodes.labels[i], j));
+            }
+            for (int j = 0; j < 6; ++j) {
+                EXPECT_EQ(s.as<double>()[6 * i + j],
+                          synthetic_value(nodes.labels[i], VTK_TENSOR_ROWS[j]));
+            }
+        }
+        for (size_t i = 0; i < elements.labels.size(); ++i) {
+            EXPECT_EQ(evol.as<double>()[i], synthetic_value(elements.labels[i], 0));
+        }
+    }
+
+    // The second instance has the topology of the first one
+    size_t links = 0;
+    for (const auto &entry : store.chunks()) {
+        links += entry.contains("link");
+    }
+    EXPECT_EQ(links, 3u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Compression, StoreTest, ::testing::Values("none", "zlib"));
+
+// ---------------------------------------------------------------------------------------
+//
+//   Corrupted stores: a bad footer or index is not a store, a bad chunk range is reported
+//
+// ---------------------------------------------------------------------------------------
+using StoreCorruptionTest = ConverterTest;
+
+TEST_F(StoreCorruptionTest, RejectsCorruptedFiles) {
+    fs::path output = convert(make_config(2), {{"format", "store"},
+                                               {"store", {{"compression", "none"}}},
+                                               {"fields", {{{"key", "U"}}}}});
+    std::ifstream input{output / "synthetic.otks", std::ios::binary};
+    const std::string bytes{std::istreambuf_iterator<char>(input), {}};
+    std::uint64_t footer[2];
+    std::memcpy(footer, bytes.data() + bytes.size() - 24, sizeof(footer));
+
+    const fs::path file = directory_ / "corrupted.otks";
+    const auto write = [&file](const std::string &data) {
+        std::ofstream output{file, std::ios::binary};
+        output.write(data.data(), static_cast<std::streamsize>(data.size()));
+    };
+    const auto with_footer = [&bytes](std::uint64_t offset, std::uint64_t size) {
+        std::string data = bytes;
+        const std::uint64_t values[2] = {offset, size};
+        std::memcpy(data.data() + data.size() - 24, values, sizeof(values));
+        return data;
+    };
+    const auto expect_not_a_store = [&file] {
+        try {
+            otk::Store store{file};
+            ADD_FAILURE() << "Opened a corrupted store";
+        } catch (const std::runtime_error &error) {
+            EXPECT_NE(std::string(error.what()).find("is not an OTK frame store"),
+                      std::string::npos)
+                << error.what();
+        }
+    };
+
+    write(bytes.substr(0, 30));
+    expect_not_a_store();
+    write(with_footer(bytes.size(), 2));
+    expect_not_a_store();
+    write(with_footer(4, footer[1]));
+    expect_not_a_store();
+    write(with_footer(footer[0], ~std::uint64_t{0} - footer[0] / 2));
+    expect_not_a_store();
+    std::string garbled = bytes;
+    garbled[footer[0]] = '#';
+    write(garbled);
+    expect_not_a_store();
+
+    // A chunk past the end of the file
+    json index = json::parse(bytes.substr(footer[0], footer[1]));
+    for (auto &entry : index["chunks"]) {
+        if (entry["kind"] == "mesh" && entry["name"] == "points") {
+            entry["offset"] = bytes.size();
+        }
+    }
+    const std::string text = index.dump();
+    const std::uint64_t moved[2] = {footer[0], text.size()};
+    std::string data = bytes.substr(0, footer[0]) + text;
+    data.append(reinterpret_cast<const char *>(moved), sizeof(moved));
+    data.append(bytes, bytes.size() - 8, 8);
+    write(data);
+    otk::Store store{file};
+    EXPECT_THROW(store.mesh(INSTANCE, "points"), std::runtime_error);
+}
+
+}  // namespace otk::test
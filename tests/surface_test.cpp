@@ -0,0 +1,79 @@
+#include "otk_test.hpp"
+
+#include <set>
+
+#include <vtkCellType.h>
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Exterior surface of a 2 x 2 x 2 block: 24 quads on the 26 outer nodes, each face
+//   carrying the element results of its cell
+//
+// ---------------------------------------------------------------------------------------
+TEST_F(ConverterTest, SurfaceMesh) {
+    fs::path output =
+        convert(make_config(2), {{"format", "npz"},
+                                 {"mesh", "surface"},
+                                 {"fields", {{{"key", "U"}}, {{"key", "EVOL1"}}}}});
+
+    auto mesh = read_npz(output / "synthetic_mesh.npz");
+    auto frame = read_npz(output / "synthetic_0.npz");
+    const std::string prefix = "PART-1-1/";
+    const NpyArray &points = mesh[prefix + "points.npy"];
+    const NpyArray &offsets = mesh[prefix + "offsets.npy"];
+    const NpyArray &connectivity = mesh[prefix + "connectivity.npy"];
+    const NpyArray &types = mesh[prefix + "types.npy"];
+    const NpyArray &node_labels = mesh[prefix + "node_labels.npy"];
+    const NpyArray &element_labels = mesh[prefix + "element_labels.npy"];
+    const NpyArray &u = frame[prefix + "U.npy"];
+    const NpyArray &evol = frame[prefix + "EVOL1.npy"];
+
+    // The center node (label 14) is interior
+    ASSERT_EQ(node_labels.size<std::int32_t>(), 26u);
+    ASSERT_EQ(points.size<float>(), 3 * 26u);
+    ASSERT_EQ(u.size<double>(), 3 * 26u);
+    for (size_t i = 0; i < 26; ++i) {
+        const int label = node_labels.as<std::int32_t>()[i];
+        EXPECT_NE(label, 14);
+        EXPECT_EQ(points.as<float>()[3 * i], (label - 1) % 3);
+        EXPECT_EQ(points.as<float>()[3 * i + 1], (label - 1) / 3 % 3);
+        EXPECT_EQ(points.as<float>()[3 * i + 2], (label - 1) / 9);
+        for (int j = 0; j < 3; ++j) {
+            EXPECT_EQ(u.as<double>()[3 * i + j], synthetic_value(label, j));
+        }
+    }
+
+    // Every corner element has three exterior faces; each face lies in a boundary plane
+    ASSERT_EQ(types.size<std::int32_t>(), 24u);
+    ASSERT_EQ(offsets.size<std::int64_t>(), 25u);
+    ASSERT_EQ(connectivity.size<std::int64_t>(), 4 * 24u);
+    ASSERT_EQ(element_labels.size<std::int32_t>(), 24u);
+    ASSERT_EQ(evol.size<double>(), 24u);
+    std::map<int, int> faces_per_element;
+    for (size_t i = 0; i < 24; ++i) {
+        EXPECT_EQ(types.as<std::int32_t>()[i], VTK_QUAD);
+        EXPECT_EQ(offsets.as<std::int64_t>()[i + 1], 4 * static_cast<int>(i + 1));
+        const int label = element_labels.as<std::int32_t>()[i];
+        faces_per_element[label]++;
+        EXPECT_EQ(evol.as<double>()[i], synthetic_value(label, 0));
+
+        bool on_boundary = false;
+        for (int k = 0; k < 3; ++k) {
+            std::set<float> values;
+            for (int n = 0; n < 4; ++n) {
+                const auto point = connectivity.as<std::int64_t>()[4 * i + n];
+                values.insert(points.as<float>()[3 * point + k]);
+            }
+            on_boundary |= values.size() == 1 && *values.begin() != 1.0f;
+        }
+        EXPECT_TRUE(on_boundary) << "Face " << i;
+    }
+    ASSERT_EQ(faces_per_element.size(), 8u);
+    for (const auto &[label, count] : faces_per_element) {
+        EXPECT_EQ(count, 3) << "Element " << label;
+    }
+}
+
+}  // namespace otk::test
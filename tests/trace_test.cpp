@@ -0,0 +1,43 @@
+#include "otk_test.hpp"
+
+#include "otk/trace.hpp"
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Timer arguments are only built while the tracer records; durations always aggregate
+//
+// ---------------------------------------------------------------------------------------
+TEST(TraceTest, ArgumentsOnlyBuiltWhileRecording) {
+    otk::Tracer &tracer = otk::Tracer::instance();
+    tracer.clear();
+    int calls = 0;
+    const auto make_args = [&calls] {
+        ++calls;
+        return json{{"call", calls}};
+    };
+
+    tracer.set_recording(false);
+    { otk::ScopedTimer timer{"trace_test", make_args}; }
+    EXPECT_EQ(calls, 0);
+
+    tracer.set_recording(true);
+    { otk::ScopedTimer timer{"trace_test", make_args}; }
+    tracer.set_recording(false);
+    EXPECT_EQ(calls, 1);
+    EXPECT_EQ(tracer.summary()["trace_test"]["count"], 2);
+
+    const fs::path file = fs::temp_directory_path() / "otk_test_trace.json";
+    tracer.write_chrome_trace(file);
+    std::ifstream input{file};
+    const json trace = json::parse(input);
+    input.close();
+    fs::remove(file);
+    ASSERT_EQ(trace["traceEvents"].size(), 1u);
+    EXPECT_EQ(trace["traceEvents"][0]["name"], "trace_test");
+    EXPECT_EQ(trace["traceEvents"][0]["args"]["call"], 1);
+    tracer.clear();
+}
+
+}  // namespace otk::test
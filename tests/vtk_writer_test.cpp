@@ -0,0 +1,104 @@
+#include "otk_test.hpp"
+
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkFieldData.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkUnstructuredGrid.h>
+
+namespace otk::test {
+
+// ---------------------------------------------------------------------------------------
+//
+//   Native and VTK writers write the same datasets
+//
+// ---------------------------------------------------------------------------------------
+void expect_same_arrays(vtkFieldData *expected, vtkFieldData *actual) {
+    ASSERT_EQ(expected->GetNumberOfArrays(), actual->GetNumberOfArrays());
+    for (int i = 0; i < expected->GetNumberOfArrays(); ++i) {
+        vtkDataArray *a = expected->GetArray(i);
+        vtkDataArray *b = actual->GetArray(a->GetName());
+        ASSERT_NE(b, nullptr) << a->GetName();
+        ASSERT_EQ(a->GetDataType(), b->GetDataType()) << a->GetName();
+        ASSERT_EQ(a->GetNumberOfTuples(), b->GetNumberOfTuples()) << a->GetName();
+        ASSERT_EQ(a->GetNumberOfComponents(), b->GetNumberOfComponents()) << a->GetName();
+        for (vtkIdType t = 0; t < a->GetNumberOfTuples(); ++t) {
+            for (int c = 0; c < a->GetNumberOfComponents(); ++c) {
+                ASSERT_EQ(a->GetComponent(t, c), b->GetComponent(t, c))
+                    << a->GetName() << " tuple " << t << " component " << c;
+            }
+        }
+    }
+}
+
+TEST_F(ConverterTest, NativeWriterMatchesVtkWriter) {
+    const otk::SyntheticConfig config = make_config(4, 2);
+    const json fields = {{{"key", "U"}},
+                         {{"key", "EVOL1"}},
+                         {{"key", "PEEQ1"}, {"quantize", {{"bits", 16}}}},
+                         {{"key", "S1"}}};
+    fs::path vtk_output = convert(config, {{"fields", fields}}, "vtk");
+    fs::path native_output =
+        convert(config, {{"fields", fields}, {"vtk", {{"writer", "native"}}}}, "native");
+
+    for (int i = 0; i < config.instances; ++i) {
+        auto vtu = [i](const std::string &name) {
+            return fmt::format("{0}_0/{0}_0_{1}_0.vtu", name, i);
+        };
+        auto expected = read_vtu(vtk_output / vtu("vtk"));
+        auto actual = read_vtu(native_output / vtu("native"));
+        ASSERT_GT(expected->GetNumberOfCells(), 0);
+
+        ASSERT_EQ(expected->GetNumberOfPoints(), actual->GetNumberOfPoints());
+        for (vtkIdType p = 0; p < expected->GetNumberOfPoints(); ++p) {
+            double a[3];
+            double b[3];
+            expected->GetPoint(p, a);
+            actual->GetPoint(p, b);
+            ASSERT_TRUE(std::equal(a, a + 3, b)) << "point " << p;
+        }
+
+        ASSERT_EQ(expected->GetNumberOfCells(), actual->GetNumberOfCells());
+        vtkNew<vtkIdList> a;
+        vtkNew<vtkIdList> b;
+        for (vtkIdType c = 0; c < expected->GetNumberOfCells(); ++c) {
+            ASSERT_EQ(expected->GetCellType(c), actual->GetCellType(c));
+            expected->GetCellPoints(c, a);
+            actual->GetCellPoints(c, b);
+            ASSERT_EQ(a->GetNumberOfIds(), b->GetNumberOfIds());
+            for (vtkIdType j = 0; j < a->GetNumberOfIds(); ++j) {
+                ASSERT_EQ(a->GetId(j), b->GetId(j)) << "cell " << c;
+            }
+        }
+
+        expect_same_arrays(expected->GetPointData(), actual->GetPointData());
+        expect_same_arrays(expected->GetCellData(), actual->GetCellData());
+        expect_same_arrays(expected->GetFieldData(), actual->GetFieldData());
+    }
+}
+
+// Both writers use the same compressor when the request has none
+TEST_F(ConverterTest, WritersShareDefaultCompression) {
+    const otk::SyntheticConfig config = make_config(2);
+    const json fields = {{{"key", "U"}}};
+    fs::path vtk_output = convert(config, {{"fields", fields}}, "vtk");
+    fs::path native_output =
+        convert(config, {{"fields", fields}, {"vtk", {{"writer", "native"}}}}, "native");
+
+    auto header = [](const fs::path &file) {
+        std::ifstream stream{file, std::ios::binary};
+        std::string line;
+        while (std::getline(stream, line) && line.find("<VTKFile") == std::string::npos) {
+        }
+        return line;
+    };
+    const std::string compressor = "compressor=\"vtkZLibDataCompressor\"";
+    EXPECT_NE(header(vtk_output / "vtk_0/vtk_0_0_0.vtu").find(compressor),
+              std::string::npos);
+    EXPECT_NE(header(native_output / "native_0/native_0_0_0.vtu").find(compressor),
+              std::string::npos);
+}
+
+}  // namespace otk::test